@@ -0,0 +1,575 @@
+// Copyright 2019 Intel Corporation All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <benchmark/benchmark.h>
+#include <rcutils/types/string_array.h>
+#include <rosidl_typesupport_introspection_cpp/message_type_support_decl.hpp>
+#include <test_msgs/msg/basic_types.hpp>
+
+#ifdef __linux__
+#include <signal.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "rmw/get_node_info_and_types.h"
+#include "rmw/get_topic_names_and_types.h"
+#include "rmw/names_and_types.h"
+#include "rmw/rmw.h"
+
+#include "rmw_dps_cpp/discovery_statistics.hpp"
+
+#include "benchmark_fixtures.hpp"
+
+/*
+ * Measures the time until every node of a graph of nodes, each with
+ * publishers and subscriptions to the same topics, has discovered all the
+ * others, with the nodes in one process or spread over several. The
+ * discovery traffic and the time spent handling it are the sums of the
+ * counters of rmw_dps_cpp_node_get_discovery_statistics() over the nodes.
+ *
+ * Then measures the latency of graph queries of a node of such a graph
+ * while another node keeps changing its entities.
+ *
+ * The other processes are this benchmark run with --discover, which writes
+ * a Result to its standard output once its nodes have converged.
+ */
+
+static int64_t
+now_ns()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static const rosidl_message_type_support_t *
+type_support()
+{
+  return rosidl_typesupport_introspection_cpp::get_message_type_support_handle<
+    test_msgs::msg::BasicTypes>();
+}
+
+struct Result
+{
+  int64_t converged_ns;
+  rmw_dps_cpp::DiscoveryStatistics statistics;
+};
+
+/// The nodes of a graph created by one process.
+/**
+ * The names of the nodes and topics start with prefix, so that graphs of
+ * earlier runs still being forgotten are told apart.
+ */
+class Graph
+{
+public:
+  Graph(
+    rmw_context_t * context, rmw_node_security_options_t * security_options,
+    const std::string & prefix, size_t entity_count)
+  : context_(context), security_options_(security_options), prefix_(prefix),
+    entity_count_(entity_count)
+  {
+  }
+
+  ~Graph()
+  {
+    for (auto & entities : nodes_) {
+      for (auto publisher : entities.publishers) {
+        (void)rmw_destroy_publisher(entities.node, publisher);
+      }
+      for (auto subscription : entities.subscriptions) {
+        (void)rmw_destroy_subscription(entities.node, subscription);
+      }
+      (void)rmw_destroy_node(entities.node);
+    }
+  }
+
+  /// Create the nodes from first to first + count.
+  /**
+   * \return false on error, with the error message set.
+   */
+  bool
+  create(size_t first, size_t count)
+  {
+    rmw_qos_profile_t qos_profile = rmw_qos_profile_default;
+    rmw_publisher_options_t publisher_options = rmw_get_default_publisher_options();
+    rmw_subscription_options_t subscription_options = rmw_get_default_subscription_options();
+    for (size_t i = first; i < first + count; ++i) {
+      nodes_.emplace_back();
+      Entities & entities = nodes_.back();
+      entities.name = node_name(i);
+      entities.node = rmw_create_node(context_, entities.name.c_str(), "/", 0,
+          security_options_, true);
+      if (!entities.node) {
+        nodes_.pop_back();
+        return false;
+      }
+      for (size_t j = 0; j < entity_count_; ++j) {
+        std::string topic = topic_name(j);
+        rmw_publisher_t * publisher = rmw_create_publisher(entities.node, type_support(),
+            topic.c_str(), &qos_profile, &publisher_options);
+        if (!publisher) {
+          return false;
+        }
+        entities.publishers.push_back(publisher);
+        rmw_subscription_t * subscription = rmw_create_subscription(entities.node,
+            type_support(), topic.c_str(), &qos_profile, &subscription_options);
+        if (!subscription) {
+          return false;
+        }
+        entities.subscriptions.push_back(subscription);
+      }
+    }
+    return true;
+  }
+
+  std::string
+  node_name(size_t i) const
+  {
+    return prefix_ + "_" + std::to_string(i);
+  }
+
+  std::string
+  topic_name(size_t j) const
+  {
+    return "/" + prefix_ + "_" + std::to_string(j);
+  }
+
+  rmw_node_t *
+  node(size_t i) const
+  {
+    return nodes_[i].node;
+  }
+
+  /// Whether every node of this process has discovered the entities of all total nodes.
+  bool
+  converged(size_t total) const
+  {
+    for (const Entities & entities : nodes_) {
+      rcutils_string_array_t names = rcutils_get_zero_initialized_string_array();
+      rcutils_string_array_t namespaces = rcutils_get_zero_initialized_string_array();
+      if (rmw_get_node_names(entities.node, &names, &namespaces) != RMW_RET_OK) {
+        rmw_reset_error();
+        return false;
+      }
+      // Whether a node discovers itself is up to DPS, so count the others
+      size_t others = 0;
+      bool self = false;
+      for (size_t i = 0; i < names.size; ++i) {
+        if (entities.name == names.data[i]) {
+          self = true;
+        } else if (!strncmp(names.data[i], prefix_.c_str(), prefix_.size())) {
+          ++others;
+        }
+      }
+      (void)rcutils_string_array_fini(&names);
+      (void)rcutils_string_array_fini(&namespaces);
+      if (others != total - 1) {
+        return false;
+      }
+      const size_t expected = self ? total : total - 1;
+      for (size_t j = 0; j < entity_count_; ++j) {
+        std::string topic = topic_name(j);
+        size_t publisher_count = 0;
+        size_t subscriber_count = 0;
+        if (rmw_count_publishers(entities.node, topic.c_str(), &publisher_count) != RMW_RET_OK ||
+          rmw_count_subscribers(entities.node, topic.c_str(), &subscriber_count) != RMW_RET_OK)
+        {
+          rmw_reset_error();
+          return false;
+        }
+        if (publisher_count != expected || subscriber_count != expected) {
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+
+  /// Wait until converged, for up to a minute.
+  bool
+  wait_for_convergence(size_t total) const
+  {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::minutes(1);
+    while (!converged(total)) {
+      if (std::chrono::steady_clock::now() > deadline) {
+        return false;
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+  }
+
+  /// The sums of the discovery counters of the nodes of this process.
+  rmw_dps_cpp::DiscoveryStatistics
+  statistics() const
+  {
+    rmw_dps_cpp::DiscoveryStatistics sum = {};
+    for (const Entities & entities : nodes_) {
+      rmw_dps_cpp::DiscoveryStatistics statistics;
+      if (rmw_dps_cpp_node_get_discovery_statistics(entities.node, &statistics) == RMW_RET_OK) {
+        add(sum, statistics);
+      }
+    }
+    return sum;
+  }
+
+  static void
+  add(rmw_dps_cpp::DiscoveryStatistics & sum, const rmw_dps_cpp::DiscoveryStatistics & statistics)
+  {
+    sum.published_count += statistics.published_count;
+    sum.published_bytes += statistics.published_bytes;
+    sum.received_count += statistics.received_count;
+    sum.received_bytes += statistics.received_bytes;
+    sum.received_ns += statistics.received_ns;
+    sum.node_count += statistics.node_count;
+  }
+
+private:
+  struct Entities
+  {
+    std::string name;
+    rmw_node_t * node;
+    std::vector<rmw_publisher_t *> publishers;
+    std::vector<rmw_subscription_t *> subscriptions;
+  };
+
+  rmw_context_t * context_;
+  rmw_node_security_options_t * security_options_;
+  const std::string prefix_;
+  const size_t entity_count_;
+  std::vector<Entities> nodes_;
+};
+
+static std::string
+unique_prefix()
+{
+  static size_t run = 0;
+#ifdef __linux__
+  return "benchmark_discovery_" + std::to_string(getpid()) + "_" + std::to_string(run++);
+#else
+  return "benchmark_discovery_" + std::to_string(run++);
+#endif
+}
+
+/// A second process creating some of the nodes of a graph.
+class Process
+{
+public:
+  Process() = default;
+  Process(const Process &) = delete;
+  Process & operator=(const Process &) = delete;
+
+  ~Process()
+  {
+#ifdef __linux__
+    if (pid_ > 0) {
+      kill(pid_, SIGTERM);
+      waitpid(pid_, nullptr, 0);
+    }
+    if (fd_ >= 0) {
+      close(fd_);
+    }
+#endif
+  }
+
+  bool
+  start(const std::vector<std::string> & args)
+  {
+#ifdef __linux__
+    int fds[2];
+    if (pipe(fds)) {
+      return false;
+    }
+    pid_ = fork();
+    if (pid_ == 0) {
+      dup2(fds[1], STDOUT_FILENO);
+      close(fds[0]);
+      close(fds[1]);
+      std::vector<char *> argv;
+      argv.push_back(const_cast<char *>("benchmark_discovery"));
+      for (const std::string & arg : args) {
+        argv.push_back(const_cast<char *>(arg.c_str()));
+      }
+      argv.push_back(nullptr);
+      execv("/proc/self/exe", argv.data());
+      _exit(127);
+    }
+    close(fds[1]);
+    fd_ = fds[0];
+    return pid_ > 0;
+#else
+    (void)args;
+    return false;
+#endif
+  }
+
+  /// Wait for the result of the process.
+  bool
+  read_result(Result & result)
+  {
+#ifdef __linux__
+    auto p = reinterpret_cast<char *>(&result);
+    size_t n = 0;
+    while (n < sizeof(result)) {
+      ssize_t ret = read(fd_, p + n, sizeof(result) - n);
+      if (ret <= 0) {
+        return false;
+      }
+      n += ret;
+    }
+    return true;
+#else
+    (void)result;
+    return false;
+#endif
+  }
+
+private:
+  int pid_ = -1;
+  int fd_ = -1;
+};
+
+BENCHMARK_DEFINE_F(benchmark_fixture_rmw, convergence)(benchmark::State & state)
+{
+  if (!initialized) {
+    return;
+  }
+  const size_t node_count = state.range(0);
+  const size_t entity_count = state.range(1);
+  const size_t process_count = state.range(2);
+  for (auto _ : state) {
+    const std::string prefix = unique_prefix();
+    const int64_t start_ns = now_ns();
+    // This process creates the first share of the nodes, the other processes the rest
+    std::vector<std::unique_ptr<Process>> processes;
+    const size_t share = node_count / process_count;
+    for (size_t p = 1; p < process_count; ++p) {
+      size_t first = share * p;
+      size_t count = p + 1 < process_count ? share : node_count - first;
+      processes.emplace_back(new Process);
+      if (!processes.back()->start({"--discover", prefix, std::to_string(first),
+          std::to_string(count), std::to_string(node_count), std::to_string(entity_count)}))
+      {
+        state.SkipWithError("cannot start the other processes");
+        return;
+      }
+    }
+    Graph graph(&context, &security_options, prefix, entity_count);
+    if (!check(state, graph.create(0, share), "create the graph")) {
+      return;
+    }
+    if (!graph.wait_for_convergence(node_count)) {
+      state.SkipWithError("timed out waiting for convergence");
+      return;
+    }
+    Result result = {now_ns(), graph.statistics()};
+    for (auto & process : processes) {
+      Result process_result;
+      if (!process->read_result(process_result)) {
+        state.SkipWithError("the other processes did not converge");
+        return;
+      }
+      result.converged_ns = std::max(result.converged_ns, process_result.converged_ns);
+      Graph::add(result.statistics, process_result.statistics);
+    }
+    state.SetIterationTime(static_cast<double>(result.converged_ns - start_ns) / 1e9);
+    state.counters["payloads_sent"] = static_cast<double>(result.statistics.published_count);
+    state.counters["bytes_sent"] = static_cast<double>(result.statistics.published_bytes);
+    state.counters["payloads_received"] = static_cast<double>(result.statistics.received_count);
+    state.counters["bytes_received"] = static_cast<double>(result.statistics.received_bytes);
+    state.counters["handling_ms"] = static_cast<double>(result.statistics.received_ns) / 1e6;
+  }
+}
+BENCHMARK_REGISTER_F(benchmark_fixture_rmw, convergence)
+->ArgNames({"nodes", "entities", "processes"})
+->Args({2, 1, 1})->Args({2, 1, 2})
+->Args({10, 1, 1})->Args({10, 10, 1})->Args({10, 10, 2})
+->Args({50, 10, 1})->Args({50, 10, 5})
+->Args({100, 10, 1})->Args({100, 10, 10})
+->Iterations(1)->UseManualTime()->Unit(benchmark::kMillisecond);
+
+/// A converged graph of one process, with the entities of its last node changing.
+class benchmark_graph : public benchmark_fixture_rmw
+{
+public:
+  void
+  SetUp(benchmark::State & state) override
+  {
+    stop = false;
+    benchmark_fixture_rmw::SetUp(state);
+    if (!initialized) {
+      return;
+    }
+    const size_t node_count = state.range(0);
+    graph.reset(new Graph(&context, &security_options, unique_prefix(), state.range(1)));
+    if (!check(state, graph->create(0, node_count), "create the graph")) {
+      return;
+    }
+    if (!graph->wait_for_convergence(node_count)) {
+      state.SkipWithError("timed out waiting for convergence");
+      return;
+    }
+    // Each change publishes a discovery payload for every node to handle
+    rmw_node_t * churn_node = graph->node(node_count - 1);
+    std::string topic = graph->topic_name(0);
+    churn = std::thread([this, churn_node, topic]() {
+          rmw_qos_profile_t qos_profile = rmw_qos_profile_default;
+          rmw_publisher_options_t publisher_options = rmw_get_default_publisher_options();
+          while (!stop) {
+            rmw_publisher_t * publisher = rmw_create_publisher(churn_node, type_support(),
+              topic.c_str(), &qos_profile, &publisher_options);
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            if (publisher) {
+              (void)rmw_destroy_publisher(churn_node, publisher);
+            }
+          }
+        });
+  }
+
+  void
+  TearDown(benchmark::State & state) override
+  {
+    stop = true;
+    if (churn.joinable()) {
+      churn.join();
+    }
+    graph.reset();
+    benchmark_fixture_rmw::TearDown(state);
+  }
+
+protected:
+  std::unique_ptr<Graph> graph;
+  std::atomic<bool> stop;
+  std::thread churn;
+
+  /// Time each call of query.
+  template<typename Query>
+  void
+  query_latency(benchmark::State & state, Query query)
+  {
+    if (!graph || !churn.joinable()) {
+      return;
+    }
+    std::vector<int64_t> latencies_ns;
+    latencies_ns.reserve(state.max_iterations);
+    for (auto _ : state) {
+      int64_t start_ns = now_ns();
+      if (!query()) {
+        break;
+      }
+      latencies_ns.push_back(now_ns() - start_ns);
+    }
+    report_latencies(state, latencies_ns);
+  }
+};
+
+BENCHMARK_DEFINE_F(benchmark_graph, count_publishers)(benchmark::State & state)
+{
+  const std::string topic = graph ? graph->topic_name(0) : "";
+  query_latency(state, [this, &state, &topic]() {
+      size_t count;
+      rmw_ret_t ret = rmw_count_publishers(graph->node(0), topic.c_str(), &count);
+      return check(state, RMW_RET_OK == ret, "rmw_count_publishers");
+    });
+}
+BENCHMARK_REGISTER_F(benchmark_graph, count_publishers)
+->ArgNames({"nodes", "entities"})->Args({10, 10})->Args({100, 10})
+->Iterations(10000)->Unit(benchmark::kMicrosecond);
+
+BENCHMARK_DEFINE_F(benchmark_graph, get_topic_names_and_types)(benchmark::State & state)
+{
+  rcutils_allocator_t allocator = rcutils_get_default_allocator();
+  query_latency(state, [this, &state, &allocator]() {
+      rmw_names_and_types_t topics = rmw_get_zero_initialized_names_and_types();
+      rmw_ret_t ret = rmw_get_topic_names_and_types(graph->node(0), &allocator, false, &topics);
+      (void)rmw_names_and_types_fini(&topics);
+      return check(state, RMW_RET_OK == ret, "rmw_get_topic_names_and_types");
+    });
+}
+BENCHMARK_REGISTER_F(benchmark_graph, get_topic_names_and_types)
+->ArgNames({"nodes", "entities"})->Args({10, 10})->Args({100, 10})
+->Iterations(10000)->Unit(benchmark::kMicrosecond);
+
+static std::atomic<bool> stop_discovering(false);
+
+/// Create some of the nodes of a graph in a second process, writing a Result once converged.
+static int
+discover_main(char ** argv)
+{
+#ifdef __linux__
+  signal(SIGTERM, [](int) {stop_discovering = true;});
+  const std::string prefix = argv[0];
+  const size_t first = std::strtoul(argv[1], nullptr, 10);
+  const size_t count = std::strtoul(argv[2], nullptr, 10);
+  const size_t total = std::strtoul(argv[3], nullptr, 10);
+  const size_t entity_count = std::strtoul(argv[4], nullptr, 10);
+  rmw_init_options_t init_options = rmw_get_zero_initialized_init_options();
+  rmw_context_t context = rmw_get_zero_initialized_context();
+  if (rmw_init_options_init(&init_options, rcutils_get_default_allocator()) != RMW_RET_OK) {
+    return 1;
+  }
+  context.implementation_identifier = rmw_get_implementation_identifier();
+  if (rmw_init(&init_options, &context) != RMW_RET_OK) {
+    return 1;
+  }
+  rmw_node_security_options_t security_options = rmw_get_default_node_security_options();
+  bool ok;
+  {
+    Graph graph(&context, &security_options, prefix, entity_count);
+    ok = graph.create(first, count) && graph.wait_for_convergence(total);
+    if (ok) {
+      Result result = {now_ns(), graph.statistics()};
+      ssize_t ret = write(STDOUT_FILENO, &result, sizeof(result));
+      (void)ret;  // Writes of less than PIPE_BUF bytes are whole or fail
+      // Stay discoverable until the other processes have converged too
+      while (!stop_discovering) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      }
+    }
+  }
+  (void)rmw_shutdown(&context);
+  (void)rmw_context_fini(&context);
+  (void)rmw_init_options_fini(&init_options);
+  return ok ? 0 : 1;
+#else
+  (void)argv;
+  return 1;
+#endif
+}
+
+int
+main(int argc, char ** argv)
+{
+  if (argc == 7 && !strcmp(argv[1], "--discover")) {
+    return discover_main(argv + 2);
+  }
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  benchmark::RunSpecifiedBenchmarks();
+  return 0;
+}
@@ -0,0 +1,234 @@
+// Copyright 2019 Intel Corporation All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <benchmark/benchmark.h>
+#include <rosidl_generator_c/message_type_support_struct.h>
+#include <rosidl_generator_c/service_type_support_struct.h>
+#include <test_msgs/msg/empty.h>
+#include <test_msgs/srv/empty.h>
+
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+#ifdef __linux__
+#include <unistd.h>
+#endif
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "rmw/rmw.h"
+
+#include "benchmark_fixtures.hpp"
+
+/*
+ * Measures creating and then destroying 1 to 1000 nodes, or publishers,
+ * subscriptions, services or clients of a node, each to its own topic or
+ * service. The time of an iteration is that of creating and destroying
+ * them all; the counters are per entity: the time to create and to
+ * destroy it, the heap it holds while alive and the growth of the
+ * resident set size. Memory freed earlier is returned to the system before
+ * each iteration where glibc allows, else it hides part of that growth.
+ */
+
+/// The resident set size of this process in bytes, or zero if unknown.
+static int64_t
+resident_bytes()
+{
+#ifdef __linux__
+  FILE * statm = fopen("/proc/self/statm", "r");
+  if (!statm) {
+    return 0;
+  }
+  long size = 0;  // NOLINT(runtime/int)
+  long resident = 0;  // NOLINT(runtime/int)
+  int n = fscanf(statm, "%ld %ld", &size, &resident);
+  fclose(statm);
+  return n == 2 ? static_cast<int64_t>(resident) * sysconf(_SC_PAGESIZE) : 0;
+#else
+  return 0;
+#endif
+}
+
+/// Return the free memory of the heap to the system.
+static void
+trim_heap()
+{
+#ifdef __GLIBC__
+  malloc_trim(0);
+#endif
+}
+
+/// The bytes allocated from the heap and not freed, or zero if unknown.
+static int64_t
+heap_bytes()
+{
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+  return static_cast<int64_t>(mallinfo2().uordblks);
+#else
+  return 0;
+#endif
+}
+
+/// Create and destroy count entities per iteration, reporting per entity counters.
+/**
+ * \param[in] create creates the i'th entity, returning null on error
+ * \param[in] destroy destroys an entity
+ */
+template<typename Entity, typename Create, typename Destroy>
+static void
+create_and_destroy(benchmark::State & state, const char * what, Create create, Destroy destroy)
+{
+  typedef std::chrono::steady_clock Clock;
+  const size_t count = state.range(0);
+  std::vector<Entity *> entities;
+  entities.reserve(count);
+  std::chrono::duration<double> create_time(0);
+  std::chrono::duration<double> destroy_time(0);
+  int64_t heap_delta = 0;
+  int64_t rss_delta = 0;
+  for (auto _ : state) {
+    trim_heap();
+    const int64_t rss = resident_bytes();
+    const int64_t heap = heap_bytes();
+    auto start = Clock::now();
+    for (size_t i = 0; i < count; ++i) {
+      Entity * entity = create(i);
+      if (!check(state, nullptr != entity, what)) {
+        break;
+      }
+      entities.push_back(entity);
+    }
+    auto created = Clock::now();
+    heap_delta += heap_bytes() - heap;
+    rss_delta += resident_bytes() - rss;
+    for (auto entity : entities) {
+      (void)destroy(entity);
+    }
+    entities.clear();
+    auto destroyed = Clock::now();
+    create_time += created - start;
+    destroy_time += destroyed - created;
+    state.SetIterationTime(std::chrono::duration<double>(destroyed - start).count());
+  }
+  const double per_entity = 1.0 / (static_cast<double>(state.iterations()) * count);
+  state.counters["create_us"] = create_time.count() * 1e6 * per_entity;
+  state.counters["destroy_us"] = destroy_time.count() * 1e6 * per_entity;
+  state.counters["heap_bytes"] = static_cast<double>(heap_delta) * per_entity;
+  state.counters["rss_bytes"] = static_cast<double>(rss_delta) * per_entity;
+}
+
+/// The names of count entities, made before creating them so as not to be timed.
+static std::vector<std::string>
+names(const char * prefix, size_t count)
+{
+  std::vector<std::string> names;
+  for (size_t i = 0; i < count; ++i) {
+    names.push_back(prefix + std::to_string(i));
+  }
+  return names;
+}
+
+BENCHMARK_DEFINE_F(benchmark_fixture_rmw, node)(benchmark::State & state)
+{
+  if (!initialized) {
+    return;
+  }
+  auto node_names = names("benchmark_node_", state.range(0));
+  create_and_destroy<rmw_node_t>(state, "rmw_create_node",
+    [this, &node_names](size_t i) {
+      return rmw_create_node(&context, node_names[i].c_str(), "/", 0, &security_options, true);
+    },
+    [](rmw_node_t * node) {return rmw_destroy_node(node);});
+}
+
+BENCHMARK_DEFINE_F(benchmark_fixture_node, publisher)(benchmark::State & state)
+{
+  if (!node) {
+    return;
+  }
+  auto topics = names("/benchmark_entities/topic_", state.range(0));
+  auto type_support = ROSIDL_GET_MSG_TYPE_SUPPORT(test_msgs, msg, Empty);
+  rmw_publisher_options_t publisher_options = rmw_get_default_publisher_options();
+  create_and_destroy<rmw_publisher_t>(state, "rmw_create_publisher",
+    [this, &topics, type_support, &publisher_options](size_t i) {
+      return rmw_create_publisher(node, type_support, topics[i].c_str(),
+      &rmw_qos_profile_default, &publisher_options);
+    },
+    [this](rmw_publisher_t * publisher) {return rmw_destroy_publisher(node, publisher);});
+}
+
+BENCHMARK_DEFINE_F(benchmark_fixture_node, subscription)(benchmark::State & state)
+{
+  if (!node) {
+    return;
+  }
+  auto topics = names("/benchmark_entities/topic_", state.range(0));
+  auto type_support = ROSIDL_GET_MSG_TYPE_SUPPORT(test_msgs, msg, Empty);
+  rmw_subscription_options_t subscription_options = rmw_get_default_subscription_options();
+  create_and_destroy<rmw_subscription_t>(state, "rmw_create_subscription",
+    [this, &topics, type_support, &subscription_options](size_t i) {
+      return rmw_create_subscription(node, type_support, topics[i].c_str(),
+      &rmw_qos_profile_default, &subscription_options);
+    },
+    [this](rmw_subscription_t * subscription) {
+      return rmw_destroy_subscription(node, subscription);
+    });
+}
+
+BENCHMARK_DEFINE_F(benchmark_fixture_node, service)(benchmark::State & state)
+{
+  if (!node) {
+    return;
+  }
+  auto service_names = names("/benchmark_entities/service_", state.range(0));
+  auto type_support = ROSIDL_GET_SRV_TYPE_SUPPORT(test_msgs, srv, Empty);
+  create_and_destroy<rmw_service_t>(state, "rmw_create_service",
+    [this, &service_names, type_support](size_t i) {
+      return rmw_create_service(node, type_support, service_names[i].c_str(),
+      &rmw_qos_profile_services_default);
+    },
+    [this](rmw_service_t * service) {return rmw_destroy_service(node, service);});
+}
+
+BENCHMARK_DEFINE_F(benchmark_fixture_node, client)(benchmark::State & state)
+{
+  if (!node) {
+    return;
+  }
+  auto service_names = names("/benchmark_entities/service_", state.range(0));
+  auto type_support = ROSIDL_GET_SRV_TYPE_SUPPORT(test_msgs, srv, Empty);
+  create_and_destroy<rmw_client_t>(state, "rmw_create_client",
+    [this, &service_names, type_support](size_t i) {
+      return rmw_create_client(node, type_support, service_names[i].c_str(),
+      &rmw_qos_profile_services_default);
+    },
+    [this](rmw_client_t * client) {return rmw_destroy_client(node, client);});
+}
+
+static void
+counts(benchmark::internal::Benchmark * b)
+{
+  b->ArgNames({"count"})->Arg(1)->Arg(100)->Arg(1000)->UseManualTime()
+  ->Unit(benchmark::kMillisecond);
+}
+BENCHMARK_REGISTER_F(benchmark_fixture_rmw, node)->Apply(counts);
+BENCHMARK_REGISTER_F(benchmark_fixture_node, publisher)->Apply(counts);
+BENCHMARK_REGISTER_F(benchmark_fixture_node, subscription)->Apply(counts);
+BENCHMARK_REGISTER_F(benchmark_fixture_node, service)->Apply(counts);
+BENCHMARK_REGISTER_F(benchmark_fixture_node, client)->Apply(counts);
+
+BENCHMARK_MAIN();
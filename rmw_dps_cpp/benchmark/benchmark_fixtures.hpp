@@ -0,0 +1,123 @@
+// Copyright 2019 Intel Corporation All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef BENCHMARK_FIXTURES_HPP_
+#define BENCHMARK_FIXTURES_HPP_
+
+#include <benchmark/benchmark.h>
+#include <rcutils/allocator.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "rmw/error_handling.h"
+#include "rmw/rmw.h"
+
+/// Skip the benchmark with the rmw error message unless ok.
+inline bool
+check(benchmark::State & state, bool ok, const char * what)
+{
+  if (!ok) {
+    std::string error = std::string(what) + ": " + rmw_get_error_string().str;
+    rmw_reset_error();
+    state.SkipWithError(error.c_str());
+  }
+  return ok;
+}
+
+/// Report the median and tail of latencies, in microseconds.
+inline void
+report_latencies(benchmark::State & state, std::vector<int64_t> latencies_ns)
+{
+  if (latencies_ns.empty()) {
+    return;
+  }
+  std::sort(latencies_ns.begin(), latencies_ns.end());
+  auto percentile = [&latencies_ns](double p) {
+      size_t i = static_cast<size_t>(p * (latencies_ns.size() - 1) + 0.5);
+      return static_cast<double>(latencies_ns[i]) / 1000.0;
+    };
+  state.counters["p50_us"] = percentile(0.5);
+  state.counters["p99_us"] = percentile(0.99);
+  state.counters["p99.9_us"] = percentile(0.999);
+}
+
+class benchmark_fixture_rmw : public benchmark::Fixture
+{
+public:
+  void
+  SetUp(benchmark::State & state) override
+  {
+    init_options = rmw_get_zero_initialized_init_options();
+    context = rmw_get_zero_initialized_context();
+    initialized = false;
+    if (!check(state, RMW_RET_OK ==
+      rmw_init_options_init(&init_options, rcutils_get_default_allocator()),
+      "rmw_init_options_init"))
+    {
+      return;
+    }
+    context.implementation_identifier = rmw_get_implementation_identifier();
+    initialized = check(state, RMW_RET_OK == rmw_init(&init_options, &context), "rmw_init");
+    security_options = rmw_get_default_node_security_options();
+  }
+
+  void
+  TearDown(benchmark::State & state) override
+  {
+    (void)state;
+    if (initialized) {
+      (void)rmw_shutdown(&context);
+      (void)rmw_context_fini(&context);
+    }
+    (void)rmw_init_options_fini(&init_options);
+  }
+
+protected:
+  rmw_init_options_t init_options;
+  rmw_context_t context;
+  rmw_node_security_options_t security_options;
+  bool initialized;
+};
+
+class benchmark_fixture_node : public benchmark_fixture_rmw
+{
+public:
+  void
+  SetUp(benchmark::State & state) override
+  {
+    node = nullptr;
+    benchmark_fixture_rmw::SetUp(state);
+    if (initialized) {
+      node = rmw_create_node(&context, "benchmark_node", "/", 0, &security_options, true);
+      check(state, nullptr != node, "rmw_create_node");
+    }
+  }
+
+  void
+  TearDown(benchmark::State & state) override
+  {
+    if (node) {
+      (void)rmw_destroy_node(node);
+    }
+    benchmark_fixture_rmw::TearDown(state);
+  }
+
+protected:
+  rmw_node_t * node;
+};
+
+#endif  // BENCHMARK_FIXTURES_HPP_
@@ -0,0 +1,499 @@
+// Copyright 2019 Intel Corporation All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <benchmark/benchmark.h>
+#include <rosidl_typesupport_introspection_cpp/message_type_support_decl.hpp>
+#include <test_msgs/msg/unbounded_sequences.hpp>
+
+#ifdef __linux__
+#include <signal.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "rmw/rmw.h"
+
+#include "benchmark_fixtures.hpp"
+
+/*
+ * Measures publishing messages of 16 bytes to 8 MiB, at fixed rates or as
+ * fast as possible, to a subscription of another node in the same process
+ * or in a second process, through rmw_publish(), DPS over loopback,
+ * rmw_wait() and rmw_take(). The latency of each message is from before
+ * rmw_publish() to after rmw_take(), on the monotonic clock shared by the
+ * processes. The environment variables of rmw_dps_cpp, such as
+ * RMW_DPS_SERIALIZATION_FORMAT, select the modes compared.
+ *
+ * The second process is this benchmark run with --receive, which writes a
+ * Record of each message it takes to its standard output.
+ */
+
+static const char * topic = "/benchmark_pub_sub";
+
+struct Record
+{
+  int64_t sequence;
+  int64_t sent_ns;
+  int64_t received_ns;
+  uint64_t size;
+};
+
+static int64_t
+now_ns()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static const rosidl_message_type_support_t *
+type_support()
+{
+  return rosidl_typesupport_introspection_cpp::get_message_type_support_handle<
+    test_msgs::msg::UnboundedSequences>();
+}
+
+static rmw_qos_profile_t
+qos()
+{
+  // Deep enough that messages are lost in transport rather than in the queue
+  rmw_qos_profile_t qos = rmw_qos_profile_default;
+  qos.depth = 1000;
+  return qos;
+}
+
+/// Take the messages of a subscription until stop is set.
+/**
+ * \param[in] on_message called with the record of each message taken
+ * \return false on error, with the error message set.
+ */
+template<typename OnMessage>
+static bool
+receive(
+  rmw_context_t * context, rmw_subscription_t * subscription, const std::atomic<bool> & stop,
+  OnMessage on_message)
+{
+  rmw_wait_set_t * wait_set = rmw_create_wait_set(context, 1);
+  if (!wait_set) {
+    return false;
+  }
+  test_msgs::msg::UnboundedSequences message;
+  const rmw_time_t timeout = {0, 100000000};
+  bool ok = true;
+  while (ok && !stop) {
+    void * data = subscription->data;
+    rmw_subscriptions_t subscriptions = {1, &data};
+    rmw_ret_t ret = rmw_wait(&subscriptions, nullptr, nullptr, nullptr, nullptr, wait_set,
+        &timeout);
+    if (ret == RMW_RET_TIMEOUT) {
+      continue;
+    }
+    ok = ret == RMW_RET_OK;
+    bool taken = ok;
+    while (taken) {
+      ok = rmw_take(subscription, &message, &taken, nullptr) == RMW_RET_OK;
+      taken = ok && taken;
+      if (taken && message.int64_values.size() == 2) {
+        on_message(Record{message.int64_values[0], message.int64_values[1], now_ns(),
+            message.uint8_values.size()});
+      }
+    }
+  }
+  (void)rmw_destroy_wait_set(wait_set);
+  return ok;
+}
+
+/// Receive in a thread of this process, or in a second process.
+class Receiver
+{
+public:
+  explicit Receiver(size_t count)
+  : records_(count), received_(0), stop_(false)
+  {
+  }
+
+  ~Receiver()
+  {
+    stop();
+  }
+
+  bool
+  start_local(rmw_context_t * context, rmw_node_t * node)
+  {
+    rmw_qos_profile_t qos_profile = qos();
+    rmw_subscription_options_t subscription_options = rmw_get_default_subscription_options();
+    subscription_ = rmw_create_subscription(node, type_support(), topic, &qos_profile,
+        &subscription_options);
+    if (!subscription_) {
+      return false;
+    }
+    node_ = node;
+    thread_ = std::thread([this, context]() {
+          auto on_message = [this](const Record & record) {add(record);};
+          (void)receive(context, subscription_, stop_, on_message);
+        });
+    return true;
+  }
+
+  bool
+  start_remote()
+  {
+#ifdef __linux__
+    int fds[2];
+    if (pipe(fds)) {
+      return false;
+    }
+    pid_ = fork();
+    if (pid_ == 0) {
+      dup2(fds[1], STDOUT_FILENO);
+      close(fds[0]);
+      close(fds[1]);
+      execl("/proc/self/exe", "benchmark_pub_sub", "--receive", nullptr);
+      _exit(127);
+    }
+    close(fds[1]);
+    if (pid_ < 0) {
+      close(fds[0]);
+      return false;
+    }
+    fd_ = fds[0];
+    thread_ = std::thread([this]() {
+          Record record;
+          while (read_record(record)) {
+            add(record);
+          }
+        });
+    return true;
+#else
+    return false;
+#endif
+  }
+
+  size_t
+  received() const
+  {
+    return received_;
+  }
+
+  /// Stop receiving, after which the records may be read.
+  void
+  stop()
+  {
+    stop_ = true;
+#ifdef __linux__
+    if (pid_ > 0) {
+      kill(pid_, SIGTERM);
+      waitpid(pid_, nullptr, 0);
+      pid_ = -1;
+    }
+#endif
+    if (thread_.joinable()) {
+      thread_.join();
+    }
+#ifdef __linux__
+    if (fd_ >= 0) {
+      close(fd_);
+      fd_ = -1;
+    }
+#endif
+    if (subscription_) {
+      (void)rmw_destroy_subscription(node_, subscription_);
+      subscription_ = nullptr;
+    }
+  }
+
+  /// The record of each message sent, with a zero received_ns if it was lost.
+  const std::vector<Record> &
+  records() const
+  {
+    return records_;
+  }
+
+private:
+  std::vector<Record> records_;
+  std::atomic<size_t> received_;
+  std::atomic<bool> stop_;
+  std::thread thread_;
+  rmw_node_t * node_ = nullptr;
+  rmw_subscription_t * subscription_ = nullptr;
+  int pid_ = -1;
+  int fd_ = -1;
+
+  void
+  add(const Record & record)
+  {
+    if (record.sequence >= 0 && static_cast<size_t>(record.sequence) < records_.size() &&
+      !records_[record.sequence].received_ns)
+    {
+      records_[record.sequence] = record;
+      ++received_;
+    }
+  }
+
+#ifdef __linux__
+  bool
+  read_record(Record & record)
+  {
+    auto p = reinterpret_cast<char *>(&record);
+    size_t n = 0;
+    while (n < sizeof(record)) {
+      ssize_t ret = read(fd_, p + n, sizeof(record) - n);
+      if (ret <= 0) {
+        return false;
+      }
+      n += ret;
+    }
+    return true;
+  }
+#endif
+};
+
+class benchmark_pub_sub : public benchmark_fixture_rmw
+{
+public:
+  void
+  SetUp(benchmark::State & state) override
+  {
+    publisher_node = nullptr;
+    subscription_node = nullptr;
+    publisher = nullptr;
+    benchmark_fixture_rmw::SetUp(state);
+    if (!initialized) {
+      return;
+    }
+    publisher_node = rmw_create_node(&context, "benchmark_publisher", "/", 0,
+        &security_options, true);
+    if (!check(state, nullptr != publisher_node, "rmw_create_node")) {
+      return;
+    }
+    rmw_qos_profile_t qos_profile = qos();
+    rmw_publisher_options_t publisher_options = rmw_get_default_publisher_options();
+    publisher = rmw_create_publisher(publisher_node, type_support(), topic, &qos_profile,
+        &publisher_options);
+    if (!check(state, nullptr != publisher, "rmw_create_publisher")) {
+      return;
+    }
+    subscription_node = rmw_create_node(&context, "benchmark_subscription", "/", 0,
+        &security_options, true);
+    check(state, nullptr != subscription_node, "rmw_create_node");
+  }
+
+  void
+  TearDown(benchmark::State & state) override
+  {
+    if (publisher) {
+      (void)rmw_destroy_publisher(publisher_node, publisher);
+    }
+    if (subscription_node) {
+      (void)rmw_destroy_node(subscription_node);
+    }
+    if (publisher_node) {
+      (void)rmw_destroy_node(publisher_node);
+    }
+    benchmark_fixture_rmw::TearDown(state);
+  }
+
+protected:
+  rmw_node_t * publisher_node;
+  rmw_node_t * subscription_node;
+  rmw_publisher_t * publisher;
+
+  bool
+  wait_for_subscription(benchmark::State & state)
+  {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (std::chrono::steady_clock::now() < deadline) {
+      size_t count = 0;
+      if (!check(state, RMW_RET_OK == rmw_publisher_count_matched_subscriptions(publisher, &count),
+        "rmw_publisher_count_matched_subscriptions"))
+      {
+        return false;
+      }
+      if (count) {
+        return true;
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    state.SkipWithError("timed out waiting for the subscription");
+    return false;
+  }
+};
+
+/// The number of messages to publish, up to 256 MiB and 10 seconds worth.
+static size_t
+message_count(size_t size, int64_t rate)
+{
+  size_t count = std::max<size_t>(100, std::min<size_t>(10000, (size_t(256) << 20) / size));
+  if (rate) {
+    count = std::min<size_t>(count, 10 * rate);
+  }
+  return count;
+}
+
+BENCHMARK_DEFINE_F(benchmark_pub_sub, latency)(benchmark::State & state)
+{
+  if (!subscription_node) {
+    return;
+  }
+  const size_t size = state.range(0);
+  const int64_t rate = state.range(1);
+  const size_t count = message_count(size, rate);
+  Receiver receiver(count);
+  if (state.range(2) == 2) {
+    if (!receiver.start_remote()) {
+      state.SkipWithError("cannot start the receiving process");
+      return;
+    }
+  } else if (!check(state, receiver.start_local(&context, subscription_node),
+    "rmw_create_subscription"))
+  {
+    return;
+  }
+  if (!wait_for_subscription(state)) {
+    return;
+  }
+
+  test_msgs::msg::UnboundedSequences message;
+  message.uint8_values.assign(size, 0x5a);
+  message.int64_values.assign(2, 0);
+  for (auto _ : state) {
+    auto period = rate ? std::chrono::nanoseconds(1000000000 / rate) : std::chrono::nanoseconds(0);
+    auto next = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < count; ++i) {
+      if (rate) {
+        std::this_thread::sleep_until(next);
+        next += period;
+      }
+      message.int64_values[0] = static_cast<int64_t>(i);
+      message.int64_values[1] = now_ns();
+      if (!check(state, RMW_RET_OK == rmw_publish(publisher, &message, nullptr), "rmw_publish")) {
+        break;
+      }
+    }
+    // Wait for the messages in flight, giving up on the rest once none arrive for a second
+    size_t received = receiver.received();
+    auto last = std::chrono::steady_clock::now();
+    while (received < count && std::chrono::steady_clock::now() - last < std::chrono::seconds(1)) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      if (receiver.received() != received) {
+        received = receiver.received();
+        last = std::chrono::steady_clock::now();
+      }
+    }
+  }
+  receiver.stop();
+
+  std::vector<int64_t> latencies_ns;
+  int64_t first_sent_ns = 0;
+  int64_t last_received_ns = 0;
+  uint64_t received_bytes = 0;
+  for (const Record & record : receiver.records()) {
+    if (record.received_ns) {
+      latencies_ns.push_back(record.received_ns - record.sent_ns);
+      if (!first_sent_ns || record.sent_ns < first_sent_ns) {
+        first_sent_ns = record.sent_ns;
+      }
+      last_received_ns = std::max(last_received_ns, record.received_ns);
+      received_bytes += record.size;
+    }
+  }
+  report_latencies(state, latencies_ns);
+  state.counters["sent"] = static_cast<double>(count);
+  state.counters["loss"] = 1.0 - static_cast<double>(latencies_ns.size()) / count;
+  if (last_received_ns > first_sent_ns) {
+    state.counters["MB/s"] = static_cast<double>(received_bytes) * 1e3 /
+      (last_received_ns - first_sent_ns);
+  }
+}
+
+static void
+sizes_rates_and_processes(benchmark::internal::Benchmark * b)
+{
+  b->ArgNames({"size", "rate", "processes"});
+  for (int64_t processes : {1, 2}) {
+    for (int64_t size = 16; size <= (8 << 20); size *= 16) {
+      // A rate of zero publishes as fast as possible
+      for (int64_t rate : {100, 1000, 0}) {
+        b->Args({size, rate, processes});
+      }
+    }
+  }
+}
+BENCHMARK_REGISTER_F(benchmark_pub_sub, latency)->Apply(sizes_rates_and_processes)
+->Iterations(1)->UseRealTime()->Unit(benchmark::kMillisecond);
+
+static std::atomic<bool> stop_receiving(false);
+
+/// Receive in a second process, writing a Record of each message taken to the standard output.
+static int
+receive_main()
+{
+#ifdef __linux__
+  signal(SIGTERM, [](int) {stop_receiving = true;});
+  rmw_init_options_t init_options = rmw_get_zero_initialized_init_options();
+  rmw_context_t context = rmw_get_zero_initialized_context();
+  if (rmw_init_options_init(&init_options, rcutils_get_default_allocator()) != RMW_RET_OK) {
+    return 1;
+  }
+  context.implementation_identifier = rmw_get_implementation_identifier();
+  if (rmw_init(&init_options, &context) != RMW_RET_OK) {
+    return 1;
+  }
+  rmw_node_security_options_t security_options = rmw_get_default_node_security_options();
+  rmw_node_t * node = rmw_create_node(&context, "benchmark_receiver", "/", 0,
+      &security_options, true);
+  rmw_qos_profile_t qos_profile = qos();
+  rmw_subscription_options_t subscription_options = rmw_get_default_subscription_options();
+  rmw_subscription_t * subscription = node ? rmw_create_subscription(node, type_support(), topic,
+      &qos_profile, &subscription_options) : nullptr;
+  bool ok = subscription && receive(&context, subscription, stop_receiving,
+      [](const Record & record) {
+        ssize_t ret = write(STDOUT_FILENO, &record, sizeof(record));
+        (void)ret;  // Writes of less than PIPE_BUF bytes are whole or fail
+      });
+  if (subscription) {
+    (void)rmw_destroy_subscription(node, subscription);
+  }
+  if (node) {
+    (void)rmw_destroy_node(node);
+  }
+  (void)rmw_shutdown(&context);
+  (void)rmw_context_fini(&context);
+  (void)rmw_init_options_fini(&init_options);
+  return ok ? 0 : 1;
+#else
+  return 1;
+#endif
+}
+
+int
+main(int argc, char ** argv)
+{
+  if (argc == 2 && !strcmp(argv[1], "--receive")) {
+    return receive_main();
+  }
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  benchmark::RunSpecifiedBenchmarks();
+  return 0;
+}
@@ -0,0 +1,357 @@
+// Copyright 2019 Intel Corporation All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <benchmark/benchmark.h>
+#include <rosidl_generator_c/message_type_support_struct.h>
+#include <rosidl_typesupport_introspection_c/identifier.h>
+#include <rosidl_typesupport_introspection_c/message_introspection.h>
+#include <rosidl_typesupport_introspection_cpp/message_type_support_decl.hpp>
+#include <sensor_msgs/msg/image.h>
+#include <sensor_msgs/msg/image.hpp>
+#include <sensor_msgs/msg/point_cloud2.h>
+#include <sensor_msgs/msg/point_cloud2.hpp>
+#include <std_msgs/msg/float32_multi_array.h>
+#include <std_msgs/msg/float32_multi_array.hpp>
+#include <test_msgs/msg/basic_types.h>
+#include <test_msgs/msg/basic_types.hpp>
+#include <test_msgs/msg/multi_nested.h>
+#include <test_msgs/msg/multi_nested.hpp>
+#include <test_msgs/msg/unbounded_sequences.h>
+#include <test_msgs/msg/unbounded_sequences.hpp>
+
+#include <atomic>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "rmw_dps_cpp/CborStream.hpp"
+#include "rmw_dps_cpp/CdrStream.hpp"
+#include "rmw_dps_cpp/MessageTypeSupport.hpp"
+
+/*
+ * Measures serializing and deserializing representative messages with the
+ * type supports of rmw_dps_cpp, for both the C and C++ introspection type
+ * supports and both the CBOR and CDR formats. Messages are serialized
+ * contiguously, as when published keyed, delta encoded or compressed, and
+ * deserialized into the same message each time, as when a subscription
+ * takes into a reused message.
+ */
+
+static std::atomic<uint64_t> allocation_count(0);
+
+#ifdef __GLIBC__
+// Count every heap allocation, C++ and C type supports and DPS alike
+extern "C" void * __libc_malloc(size_t size);
+extern "C" void * __libc_calloc(size_t n, size_t size);
+extern "C" void * __libc_realloc(void * ptr, size_t size);
+
+extern "C" void *
+malloc(size_t size) noexcept
+{
+  allocation_count.fetch_add(1, std::memory_order_relaxed);
+  return __libc_malloc(size);
+}
+
+extern "C" void *
+calloc(size_t n, size_t size) noexcept
+{
+  allocation_count.fetch_add(1, std::memory_order_relaxed);
+  return __libc_calloc(n, size);
+}
+
+extern "C" void *
+realloc(void * ptr, size_t size) noexcept
+{
+  allocation_count.fetch_add(1, std::memory_order_relaxed);
+  return __libc_realloc(ptr, size);
+}
+#endif
+
+using MessageMembers_c = rosidl_typesupport_introspection_c__MessageMembers;
+using MessageMembers_cpp = rosidl_typesupport_introspection_cpp::MessageMembers;
+
+/// A message constructed and destroyed through the members of its type support.
+template<typename MembersType>
+class Message
+{
+public:
+  explicit Message(const MembersType * members)
+  : members_(members), data_(std::malloc(members->size_of_))
+  {
+    if (!data_) {
+      throw std::bad_alloc();
+    }
+    rmw_dps_cpp::MessageHelper<MembersType>::init(members, data_);
+  }
+
+  ~Message()
+  {
+    members_->fini_function(data_);
+    std::free(data_);
+  }
+
+  Message(const Message &) = delete;
+  Message & operator=(const Message &) = delete;
+
+  void *
+  get() const
+  {
+    return data_;
+  }
+
+private:
+  const MembersType * members_;
+  void * data_;
+};
+
+template<typename MembersType>
+static bool
+deserialize(
+  rmw_dps_cpp::MessageTypeSupport<MembersType> & type_support,
+  const std::vector<uint8_t> & payload, void * message)
+{
+  if (rmw_dps_cpp::cdr::is_cdr(payload.data(), payload.size())) {
+    rmw_dps_cpp::cdr::RxStream stream(payload.data(), payload.size());
+    return type_support.deserializeROSmessage(stream, message);
+  }
+  auto stream = rmw_dps_cpp::cbor::RxStream::view(
+    const_cast<uint8_t *>(payload.data()), payload.size());
+  return type_support.deserializeROSmessage(stream, message);
+}
+
+template<typename MembersType, typename Stream>
+static void
+benchmark_serialize(benchmark::State & state, const MembersType * members, const void * message)
+{
+  rmw_dps_cpp::MessageTypeSupport<MembersType> type_support(members);
+  size_t size = 0;
+  uint64_t allocations = allocation_count;
+  for (auto _ : state) {
+    Stream ser;
+    if (!type_support.serializeROSmessage(message, ser)) {
+      state.SkipWithError("cannot serialize message");
+      break;
+    }
+    size = ser.size();
+    benchmark::DoNotOptimize(ser.data());
+  }
+  allocations = allocation_count - allocations;
+  state.SetBytesProcessed(state.iterations() * size);
+  state.counters["bytes"] = static_cast<double>(size);
+  state.counters["allocs"] = benchmark::Counter(
+    static_cast<double>(allocations), benchmark::Counter::kAvgIterations);
+}
+
+template<typename MembersType>
+static void
+benchmark_deserialize(
+  benchmark::State & state, const MembersType * members, const std::vector<uint8_t> * payload)
+{
+  rmw_dps_cpp::MessageTypeSupport<MembersType> type_support(members);
+  Message<MembersType> message(members);
+  uint64_t allocations = allocation_count;
+  try {
+    for (auto _ : state) {
+      if (!deserialize(type_support, *payload, message.get())) {
+        state.SkipWithError("cannot deserialize message");
+        break;
+      }
+      benchmark::ClobberMemory();
+    }
+  } catch (const std::exception & e) {
+    state.SkipWithError(e.what());
+  }
+  allocations = allocation_count - allocations;
+  state.SetBytesProcessed(state.iterations() * payload->size());
+  state.counters["bytes"] = static_cast<double>(payload->size());
+  state.counters["allocs"] = benchmark::Counter(
+    static_cast<double>(allocations), benchmark::Counter::kAvgIterations);
+}
+
+template<typename MembersType, typename Stream>
+static std::vector<uint8_t>
+serialize(const MembersType * members, const void * message)
+{
+  rmw_dps_cpp::MessageTypeSupport<MembersType> type_support(members);
+  Stream ser;
+  if (!type_support.serializeROSmessage(message, ser)) {
+    throw std::runtime_error("cannot serialize message");
+  }
+  return std::vector<uint8_t>(ser.data(), ser.data() + ser.size());
+}
+
+/// A representative message, with its C and C++ type supports.
+struct Shape
+{
+  std::string name;
+  const MessageMembers_c * c_members;
+  const MessageMembers_cpp * cpp_members;
+  std::shared_ptr<void> cpp_message;
+};
+
+template<typename T>
+static Shape
+make_shape(
+  const char * name, const rosidl_message_type_support_t * c_type_support,
+  std::function<void(T &)> fill)
+{
+  auto c_handle = get_message_typesupport_handle(
+    c_type_support, rosidl_typesupport_introspection_c__identifier);
+  auto cpp_handle = rosidl_typesupport_introspection_cpp::get_message_type_support_handle<T>();
+  auto message = std::make_shared<T>();
+  fill(*message);
+  return Shape{name,
+    static_cast<const MessageMembers_c *>(c_handle->data),
+    static_cast<const MessageMembers_cpp *>(cpp_handle->data),
+    message};
+}
+
+static std::vector<Shape>
+make_shapes()
+{
+  std::vector<Shape> shapes;
+  shapes.push_back(make_shape<test_msgs::msg::BasicTypes>("flat",
+    ROSIDL_GET_MSG_TYPE_SUPPORT(test_msgs, msg, BasicTypes),
+    [](test_msgs::msg::BasicTypes & m) {
+      m.bool_value = true;
+      m.byte_value = 0x2a;
+      m.char_value = 'x';
+      m.float32_value = 1.125f;
+      m.float64_value = 2.25;
+      m.int8_value = -8;
+      m.uint8_value = 8;
+      m.int16_value = -16;
+      m.uint16_value = 16;
+      m.int32_value = -32;
+      m.uint32_value = 32;
+      m.int64_value = -64;
+      m.uint64_value = 64;
+    }));
+  shapes.push_back(make_shape<test_msgs::msg::UnboundedSequences>("strings",
+    ROSIDL_GET_MSG_TYPE_SUPPORT(test_msgs, msg, UnboundedSequences),
+    [](test_msgs::msg::UnboundedSequences & m) {
+      for (size_t i = 0; i < 64; ++i) {
+        m.string_values.push_back(std::string(8 + i % 32, static_cast<char>('a' + i % 26)));
+      }
+    }));
+  shapes.push_back(make_shape<test_msgs::msg::MultiNested>("nested",
+    ROSIDL_GET_MSG_TYPE_SUPPORT(test_msgs, msg, MultiNested),
+    [](test_msgs::msg::MultiNested & m) {
+      m.unbounded_sequence_of_unbounded_sequences.resize(16);
+      for (auto & sequences : m.unbounded_sequence_of_unbounded_sequences) {
+        sequences.int32_values.assign(16, 7);
+        sequences.float64_values.assign(16, 0.5);
+        sequences.string_values.assign(4, std::string(16, 'n'));
+      }
+    }));
+  shapes.push_back(make_shape<sensor_msgs::msg::Image>("image",
+    ROSIDL_GET_MSG_TYPE_SUPPORT(sensor_msgs, msg, Image),
+    [](sensor_msgs::msg::Image & m) {
+      m.header.frame_id = "camera";
+      m.height = 480;
+      m.width = 640;
+      m.encoding = "rgb8";
+      m.step = 3 * m.width;
+      m.data.assign(m.step * m.height, 0x7f);
+    }));
+  shapes.push_back(make_shape<sensor_msgs::msg::PointCloud2>("point_cloud",
+    ROSIDL_GET_MSG_TYPE_SUPPORT(sensor_msgs, msg, PointCloud2),
+    [](sensor_msgs::msg::PointCloud2 & m) {
+      m.header.frame_id = "lidar";
+      m.height = 1;
+      m.width = 100000;
+      for (auto name : {"x", "y", "z", "intensity"}) {
+        sensor_msgs::msg::PointField field;
+        field.name = name;
+        field.offset = static_cast<uint32_t>(4 * m.fields.size());
+        field.datatype = sensor_msgs::msg::PointField::FLOAT32;
+        field.count = 1;
+        m.fields.push_back(field);
+      }
+      m.point_step = 16;
+      m.row_step = m.point_step * m.width;
+      m.data.assign(m.row_step, 0x3f);
+      m.is_dense = true;
+    }));
+  shapes.push_back(make_shape<std_msgs::msg::Float32MultiArray>("float32_array",
+    ROSIDL_GET_MSG_TYPE_SUPPORT(std_msgs, msg, Float32MultiArray),
+    [](std_msgs::msg::Float32MultiArray & m) {
+      std_msgs::msg::MultiArrayDimension dim;
+      dim.label = "values";
+      dim.size = 262144;
+      dim.stride = 262144;
+      m.layout.dim.push_back(dim);
+      m.data.assign(dim.size, 0.5f);
+    }));
+  return shapes;
+}
+
+template<typename Stream>
+static void
+register_benchmarks(
+  const Shape & shape, const char * format,
+  std::vector<std::unique_ptr<Message<MessageMembers_c>>> &
+  c_messages,
+  std::vector<std::unique_ptr<std::vector<uint8_t>>> & payloads)
+{
+  // The C message is the C++ message passed through the serializer
+  payloads.emplace_back(new std::vector<uint8_t>(
+      serialize<MessageMembers_cpp, Stream>(shape.cpp_members, shape.cpp_message.get())));
+  const std::vector<uint8_t> * payload = payloads.back().get();
+  c_messages.emplace_back(
+    new Message<MessageMembers_c>(shape.c_members));
+  rmw_dps_cpp::MessageTypeSupport<MessageMembers_c>
+  type_support(shape.c_members);
+  if (!deserialize(type_support, *payload, c_messages.back()->get())) {
+    throw std::runtime_error("cannot deserialize " + shape.name);
+  }
+  const void * c_message = c_messages.back()->get();
+
+  std::string name = shape.name + "/" + format;
+  benchmark::RegisterBenchmark((name + "/c/serialize").c_str(),
+    benchmark_serialize<MessageMembers_c, Stream>,
+    shape.c_members, c_message);
+  benchmark::RegisterBenchmark((name + "/c/deserialize").c_str(),
+    benchmark_deserialize<MessageMembers_c>,
+    shape.c_members, payload);
+  benchmark::RegisterBenchmark((name + "/cpp/serialize").c_str(),
+    benchmark_serialize<MessageMembers_cpp, Stream>,
+    shape.cpp_members, shape.cpp_message.get());
+  benchmark::RegisterBenchmark((name + "/cpp/deserialize").c_str(),
+    benchmark_deserialize<MessageMembers_cpp>,
+    shape.cpp_members, payload);
+}
+
+int
+main(int argc, char ** argv)
+{
+  std::vector<Shape> shapes = make_shapes();
+  std::vector<std::unique_ptr<Message<MessageMembers_c>>>
+  c_messages;
+  std::vector<std::unique_ptr<std::vector<uint8_t>>> payloads;
+  for (const Shape & shape : shapes) {
+    register_benchmarks<rmw_dps_cpp::cbor::TxStream>(shape, "cbor", c_messages, payloads);
+    register_benchmarks<rmw_dps_cpp::cdr::TxStream>(shape, "cdr", c_messages, payloads);
+  }
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  benchmark::RunSpecifiedBenchmarks();
+  return 0;
+}
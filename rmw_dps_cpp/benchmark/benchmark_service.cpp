@@ -0,0 +1,308 @@
+// Copyright 2019 Intel Corporation All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <benchmark/benchmark.h>
+#include <rosidl_typesupport_introspection_cpp/service_type_support_decl.hpp>
+#include <test_msgs/srv/basic_types.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "rmw/rmw.h"
+
+#include "rmw_dps_cpp/pending_requests.hpp"
+
+#include "benchmark_fixtures.hpp"
+
+/*
+ * Measures calls of a service by clients of another node, each keeping a
+ * number of requests in flight, through rmw_send_request(),
+ * rmw_take_request(), rmw_send_response(), which acknowledges the request
+ * publication, and rmw_take_response(). Requests and responses carry a
+ * string of the size benchmarked.
+ *
+ * The requests pending in the service, taken and not yet responded to, are
+ * counted after each response; the benchmark fails if they exceed the
+ * requests in flight, or remain once every call has returned.
+ */
+
+static const char * service_name = "/benchmark_service";
+
+static int64_t
+now_ns()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static const rosidl_service_type_support_t *
+type_support()
+{
+  return rosidl_typesupport_introspection_cpp::get_service_type_support_handle<
+    test_msgs::srv::BasicTypes>();
+}
+
+class benchmark_service : public benchmark_fixture_rmw
+{
+public:
+  void
+  SetUp(benchmark::State & state) override
+  {
+    server_node = nullptr;
+    client_node = nullptr;
+    service = nullptr;
+    clients.clear();
+    stop = false;
+    max_pending = 0;
+    pending = 0;
+    benchmark_fixture_rmw::SetUp(state);
+    if (!initialized) {
+      return;
+    }
+    rmw_qos_profile_t qos_profile = rmw_qos_profile_services_default;
+    server_node = rmw_create_node(&context, "benchmark_server", "/", 0, &security_options, true);
+    if (!check(state, nullptr != server_node, "rmw_create_node")) {
+      return;
+    }
+    service = rmw_create_service(server_node, type_support(), service_name, &qos_profile);
+    if (!check(state, nullptr != service, "rmw_create_service")) {
+      return;
+    }
+    client_node = rmw_create_node(&context, "benchmark_client", "/", 0, &security_options, true);
+    if (!check(state, nullptr != client_node, "rmw_create_node")) {
+      return;
+    }
+    for (int64_t i = 0; i < state.range(2); ++i) {
+      rmw_client_t * client = rmw_create_client(client_node, type_support(), service_name,
+          &qos_profile);
+      if (!check(state, nullptr != client, "rmw_create_client")) {
+        return;
+      }
+      clients.push_back(client);
+    }
+    const size_t size = state.range(0);
+    server = std::thread([this, size]() {serve(size);});
+  }
+
+  void
+  TearDown(benchmark::State & state) override
+  {
+    stop = true;
+    if (server.joinable()) {
+      server.join();
+    }
+    for (auto client : clients) {
+      (void)rmw_destroy_client(client_node, client);
+    }
+    if (client_node) {
+      (void)rmw_destroy_node(client_node);
+    }
+    if (service) {
+      (void)rmw_destroy_service(server_node, service);
+    }
+    if (server_node) {
+      (void)rmw_destroy_node(server_node);
+    }
+    benchmark_fixture_rmw::TearDown(state);
+  }
+
+protected:
+  rmw_node_t * server_node;
+  rmw_node_t * client_node;
+  rmw_service_t * service;
+  std::vector<rmw_client_t *> clients;
+  std::thread server;
+  std::atomic<bool> stop;
+  /// The requests pending in the service after the last response, and the most seen.
+  std::atomic<size_t> pending;
+  std::atomic<size_t> max_pending;
+
+  /// Respond to each request with a string of size bytes, echoing its int64_value.
+  void
+  serve(size_t size)
+  {
+    rmw_wait_set_t * wait_set = rmw_create_wait_set(&context, 1);
+    if (!wait_set) {
+      return;
+    }
+    rmw_request_id_t request_header;
+    test_msgs::srv::BasicTypes::Request request;
+    test_msgs::srv::BasicTypes::Response response;
+    response.string_value.assign(size, 'r');
+    const rmw_time_t timeout = {0, 100000000};
+    while (!stop) {
+      void * data = service->data;
+      rmw_services_t services = {1, &data};
+      rmw_ret_t ret = rmw_wait(nullptr, nullptr, &services, nullptr, nullptr, wait_set,
+          &timeout);
+      if (ret != RMW_RET_OK) {
+        continue;
+      }
+      bool taken = true;
+      while (taken) {
+        if (rmw_take_request(service, &request_header, &request, &taken) != RMW_RET_OK) {
+          break;
+        }
+        if (!taken) {
+          break;
+        }
+        response.int64_value = request.int64_value;
+        (void)rmw_send_response(service, &request_header, &response);
+        size_t count;
+        if (rmw_dps_cpp_service_get_pending_request_count(service, &count) == RMW_RET_OK) {
+          pending = count;
+          max_pending = std::max<size_t>(max_pending, count);
+        }
+      }
+    }
+    (void)rmw_destroy_wait_set(wait_set);
+  }
+
+  bool
+  wait_for_service(benchmark::State & state)
+  {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    for (auto client : clients) {
+      bool available = false;
+      while (!available) {
+        if (!check(state, RMW_RET_OK ==
+          rmw_service_server_is_available(client_node, client, &available),
+          "rmw_service_server_is_available"))
+        {
+          return false;
+        }
+        if (std::chrono::steady_clock::now() > deadline) {
+          state.SkipWithError("timed out waiting for the service");
+          return false;
+        }
+        if (!available) {
+          std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+      }
+    }
+    return true;
+  }
+};
+
+/// The number of calls, up to 256 MiB of requests.
+static size_t
+call_count(size_t size)
+{
+  return std::max<size_t>(100, std::min<size_t>(10000, (size_t(256) << 20) / size));
+}
+
+BENCHMARK_DEFINE_F(benchmark_service, round_trip)(benchmark::State & state)
+{
+  if (clients.size() != static_cast<size_t>(state.range(2)) || !wait_for_service(state)) {
+    return;
+  }
+  const size_t size = state.range(0);
+  const size_t in_flight = state.range(1);
+  const size_t count = call_count(size);
+  rmw_wait_set_t * wait_set = rmw_create_wait_set(&context, clients.size());
+  if (!check(state, nullptr != wait_set, "rmw_create_wait_set")) {
+    return;
+  }
+  test_msgs::srv::BasicTypes::Request request;
+  request.string_value.assign(size, 'q');
+  test_msgs::srv::BasicTypes::Response response;
+  rmw_request_id_t request_header;
+  std::vector<int64_t> latencies_ns;
+  latencies_ns.reserve(count);
+  std::vector<void *> data(clients.size());
+  auto send = [&](rmw_client_t * client) {
+      int64_t sequence_id;
+      request.int64_value = now_ns();
+      rmw_ret_t ret = rmw_send_request(client, &request, &sequence_id);
+      return check(state, RMW_RET_OK == ret, "rmw_send_request");
+    };
+
+  for (auto _ : state) {
+    size_t sent = 0;
+    bool ok = true;
+    for (size_t i = 0; ok && i < in_flight; ++i) {
+      for (auto client : clients) {
+        ok = ok && send(client);
+        ++sent;
+      }
+    }
+    // Send a request for each response until count requests have been sent
+    const rmw_time_t timeout = {1, 0};
+    while (ok && latencies_ns.size() < sent) {
+      for (size_t i = 0; i < clients.size(); ++i) {
+        data[i] = clients[i]->data;
+      }
+      rmw_clients_t wait_clients = {clients.size(), data.data()};
+      rmw_ret_t ret = rmw_wait(nullptr, nullptr, nullptr, &wait_clients, nullptr, wait_set,
+          &timeout);
+      if (ret == RMW_RET_TIMEOUT) {
+        state.SkipWithError("timed out waiting for responses");
+        ok = false;
+        break;
+      }
+      ok = check(state, RMW_RET_OK == ret, "rmw_wait");
+      for (size_t i = 0; ok && i < clients.size(); ++i) {
+        if (!wait_clients.clients[i]) {
+          continue;
+        }
+        bool taken = true;
+        while (ok && taken) {
+          ret = rmw_take_response(clients[i], &request_header, &response, &taken);
+          ok = check(state, RMW_RET_OK == ret, "rmw_take_response");
+          if (ok && taken) {
+            latencies_ns.push_back(now_ns() - response.int64_value);
+            if (sent < count) {
+              ok = send(clients[i]);
+              ++sent;
+            }
+          }
+        }
+      }
+    }
+  }
+  (void)rmw_destroy_wait_set(wait_set);
+
+  report_latencies(state, latencies_ns);
+  state.counters["calls"] = benchmark::Counter(static_cast<double>(latencies_ns.size()),
+      benchmark::Counter::kIsRate);
+  state.counters["max_pending"] = static_cast<double>(max_pending);
+  // The server counts the pending requests after sending each response, which may be taken first
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  if (max_pending > in_flight * clients.size()) {
+    state.SkipWithError("the service holds more requests than are in flight");
+  } else if (latencies_ns.size() == count && pending != 0) {
+    state.SkipWithError("the service holds requests already responded to");
+  }
+}
+
+static void
+sizes_in_flight_and_clients(benchmark::internal::Benchmark * b)
+{
+  b->ArgNames({"size", "in_flight", "clients"});
+  for (int64_t size : {16, 1024, 65536}) {
+    for (int64_t in_flight : {1, 8, 64}) {
+      for (int64_t clients : {1, 4, 16}) {
+        b->Args({size, in_flight, clients});
+      }
+    }
+  }
+}
+BENCHMARK_REGISTER_F(benchmark_service, round_trip)->Apply(sizes_in_flight_and_clients)
+->Iterations(1)->UseRealTime()->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
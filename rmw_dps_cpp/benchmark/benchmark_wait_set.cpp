@@ -0,0 +1,500 @@
+// Copyright 2019 Intel Corporation All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifdef __linux__
+#include <sys/resource.h>
+#endif
+
+#include <benchmark/benchmark.h>
+#include <rosidl_generator_c/message_type_support_struct.h>
+#include <rosidl_generator_c/service_type_support_struct.h>
+#include <test_msgs/msg/empty.h>
+#include <test_msgs/srv/empty.h>
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "rmw/rmw.h"
+
+#include "rmw_dps_cpp/wait_fds.hpp"
+#include "rmw_dps_cpp/wait_policy.hpp"
+
+#include "benchmark_fixtures.hpp"
+
+/*
+ * Measures rmw_wait() over wait sets of 1 to 10000 entities: checking a
+ * wait set of which no entity is ready, of which one is and of which all
+ * are, and waking up from a publication or guard condition trigger.
+ * Subscriptions stay ready while they have messages, so the ready cases
+ * publish once and then wait without taking.
+ *
+ * On Linux each entity holds an eventfd, so the soft limit on open files is
+ * raised to the hard limit at startup. A benchmark whose entities cannot all
+ * get one is skipped, as rmw_wait() would fall back to waiting on a condition
+ * variable.
+ */
+
+enum Entity
+{
+  SUBSCRIPTION,
+  GUARD_CONDITION,
+  CLIENT,
+  SERVICE
+};
+
+static const char * idle_topic = "/benchmark_wait_set/idle";
+static const char * ready_topic = "/benchmark_wait_set/ready";
+
+class benchmark_wait_set : public benchmark_fixture_node
+{
+public:
+  void
+  SetUp(benchmark::State & state) override
+  {
+    wait_set = nullptr;
+    publisher = nullptr;
+    benchmark_fixture_node::SetUp(state);
+    if (node) {
+      wait_set = rmw_create_wait_set(&context, 0);
+      check(state, nullptr != wait_set, "rmw_create_wait_set");
+    }
+  }
+
+  void
+  TearDown(benchmark::State & state) override
+  {
+    if (publisher) {
+      (void)rmw_destroy_publisher(node, publisher);
+    }
+    for (auto subscription : subscriptions) {
+      (void)rmw_destroy_subscription(node, subscription);
+    }
+    for (auto guard_condition : guard_conditions) {
+      (void)rmw_destroy_guard_condition(guard_condition);
+    }
+    for (auto client : clients) {
+      (void)rmw_destroy_client(node, client);
+    }
+    for (auto service : services) {
+      (void)rmw_destroy_service(node, service);
+    }
+    subscriptions.clear();
+    guard_conditions.clear();
+    clients.clear();
+    services.clear();
+    if (wait_set) {
+      (void)rmw_destroy_wait_set(wait_set);
+    }
+    benchmark_fixture_node::TearDown(state);
+  }
+
+protected:
+  rmw_wait_set_t * wait_set;
+  rmw_publisher_t * publisher;
+  std::vector<rmw_subscription_t *> subscriptions;
+  std::vector<rmw_guard_condition_t *> guard_conditions;
+  std::vector<rmw_client_t *> clients;
+  std::vector<rmw_service_t *> services;
+  // The arrays passed to rmw_wait(), which clears the entities that are not ready
+  std::vector<void *> subscriber_data;
+  std::vector<void *> guard_condition_data;
+  std::vector<void *> client_data;
+  std::vector<void *> service_data;
+
+  /// Skip the benchmark unless the entity just created has a file descriptor.
+  bool
+  check_fd(benchmark::State & state, rmw_ret_t ret)
+  {
+#ifdef __linux__
+    if (ret != RMW_RET_OK) {
+      rmw_reset_error();
+      state.SkipWithError("entity has no file descriptor, raise the limit on open files");
+      return false;
+    }
+#else
+    (void)state;
+    rmw_reset_error();
+#endif
+    return true;
+  }
+
+  bool
+  create(benchmark::State & state, Entity entity, size_t count, const char * topic = idle_topic)
+  {
+    auto message_type_support = ROSIDL_GET_MSG_TYPE_SUPPORT(test_msgs, msg, Empty);
+    auto service_type_support = ROSIDL_GET_SRV_TYPE_SUPPORT(test_msgs, srv, Empty);
+    rmw_subscription_options_t subscription_options = rmw_get_default_subscription_options();
+    int fd;
+    for (size_t i = 0; i < count; ++i) {
+      // Clients and services need distinct names, lest requests reach several services
+      std::string name = std::string(topic) + "_" + std::to_string(i);
+      switch (entity) {
+        case SUBSCRIPTION:
+          subscriptions.push_back(rmw_create_subscription(node, message_type_support, topic,
+            &rmw_qos_profile_default, &subscription_options));
+          if (!check(state, nullptr != subscriptions.back(), "rmw_create_subscription")) {
+            subscriptions.pop_back();
+            return false;
+          }
+          if (!check_fd(state, rmw_dps_cpp_subscription_get_fd(subscriptions.back(), &fd))) {
+            return false;
+          }
+          break;
+        case GUARD_CONDITION:
+          guard_conditions.push_back(rmw_create_guard_condition(&context));
+          if (!check(state, nullptr != guard_conditions.back(), "rmw_create_guard_condition")) {
+            guard_conditions.pop_back();
+            return false;
+          }
+          if (!check_fd(state,
+            rmw_dps_cpp_guard_condition_get_fd(guard_conditions.back(), &fd)))
+          {
+            return false;
+          }
+          break;
+        case CLIENT:
+          clients.push_back(rmw_create_client(node, service_type_support, name.c_str(),
+            &rmw_qos_profile_services_default));
+          if (!check(state, nullptr != clients.back(), "rmw_create_client")) {
+            clients.pop_back();
+            return false;
+          }
+          if (!check_fd(state, rmw_dps_cpp_client_get_fd(clients.back(), &fd))) {
+            return false;
+          }
+          break;
+        case SERVICE:
+          services.push_back(rmw_create_service(node, service_type_support, name.c_str(),
+            &rmw_qos_profile_services_default));
+          if (!check(state, nullptr != services.back(), "rmw_create_service")) {
+            services.pop_back();
+            return false;
+          }
+          if (!check_fd(state, rmw_dps_cpp_service_get_fd(services.back(), &fd))) {
+            return false;
+          }
+          break;
+      }
+    }
+    return true;
+  }
+
+  bool
+  create_publisher(benchmark::State & state)
+  {
+    rmw_publisher_options_t publisher_options = rmw_get_default_publisher_options();
+    publisher = rmw_create_publisher(node,
+        ROSIDL_GET_MSG_TYPE_SUPPORT(test_msgs, msg, Empty), ready_topic,
+        &rmw_qos_profile_default, &publisher_options);
+    return check(state, nullptr != publisher, "rmw_create_publisher");
+  }
+
+  bool
+  publish(benchmark::State & state)
+  {
+    test_msgs__msg__Empty message;
+    test_msgs__msg__Empty__init(&message);
+    bool ok = check(state, RMW_RET_OK == rmw_publish(publisher, &message, nullptr), "rmw_publish");
+    test_msgs__msg__Empty__fini(&message);
+    return ok;
+  }
+
+  /// Wait on all the entities created.
+  rmw_ret_t
+  wait(const rmw_time_t * timeout)
+  {
+    subscriber_data.resize(subscriptions.size());
+    for (size_t i = 0; i < subscriptions.size(); ++i) {
+      subscriber_data[i] = subscriptions[i]->data;
+    }
+    guard_condition_data.resize(guard_conditions.size());
+    for (size_t i = 0; i < guard_conditions.size(); ++i) {
+      guard_condition_data[i] = guard_conditions[i]->data;
+    }
+    client_data.resize(clients.size());
+    for (size_t i = 0; i < clients.size(); ++i) {
+      client_data[i] = clients[i]->data;
+    }
+    service_data.resize(services.size());
+    for (size_t i = 0; i < services.size(); ++i) {
+      service_data[i] = services[i]->data;
+    }
+    rmw_subscriptions_t s = {subscriber_data.size(), subscriber_data.data()};
+    rmw_guard_conditions_t g = {guard_condition_data.size(), guard_condition_data.data()};
+    rmw_clients_t c = {client_data.size(), client_data.data()};
+    rmw_services_t v = {service_data.size(), service_data.data()};
+    return rmw_wait(&s, &g, &v, &c, nullptr, wait_set, timeout);
+  }
+
+  /// Wait until the subscriptions from first on have a message.
+  bool
+  wait_for_subscriptions(benchmark::State & state, size_t first)
+  {
+    const rmw_time_t timeout = {0, 0};
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (std::chrono::steady_clock::now() < deadline) {
+      (void)wait(&timeout);
+      size_t ready = first;
+      while (ready < subscriber_data.size() && subscriber_data[ready]) {
+        ++ready;
+      }
+      if (ready == subscriber_data.size()) {
+        return true;
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    state.SkipWithError("timed out waiting for the published message");
+    return false;
+  }
+
+  void
+  report_statistics(benchmark::State & state)
+  {
+    rmw_dps_cpp::WaitStatistics statistics;
+    if (RMW_RET_OK == rmw_dps_cpp_wait_set_get_statistics(wait_set, &statistics)) {
+      state.counters["immediate"] = static_cast<double>(statistics.immediate_count);
+      state.counters["spun"] = static_cast<double>(statistics.spin_count);
+      state.counters["blocked"] = static_cast<double>(statistics.block_count);
+    }
+  }
+};
+
+static void
+entities_and_counts(benchmark::internal::Benchmark * b)
+{
+  b->ArgNames({"entity", "count"});
+  for (int64_t entity : {SUBSCRIPTION, GUARD_CONDITION, CLIENT, SERVICE}) {
+    for (int64_t count = 1; count <= 10000; count *= 10) {
+      b->Args({entity, count});
+    }
+  }
+}
+
+static void
+counts(benchmark::internal::Benchmark * b)
+{
+  b->ArgNames({"count"});
+  for (int64_t count = 1; count <= 10000; count *= 10) {
+    b->Args({count});
+  }
+}
+
+static void
+counts_and_spin_periods(benchmark::internal::Benchmark * b)
+{
+  b->ArgNames({"count", "spin_us"});
+  for (int64_t count = 1; count <= 10000; count *= 100) {
+    for (int64_t spin_us : {0, 50}) {
+      b->Args({count, spin_us});
+    }
+  }
+}
+
+BENCHMARK_DEFINE_F(benchmark_wait_set, empty)(benchmark::State & state)
+{
+  if (!wait_set || !create(state, static_cast<Entity>(state.range(0)), state.range(1))) {
+    return;
+  }
+  const rmw_time_t timeout = {0, 0};
+  for (auto _ : state) {
+    if (RMW_RET_TIMEOUT != wait(&timeout)) {
+      state.SkipWithError("rmw_wait did not time out");
+      break;
+    }
+  }
+}
+BENCHMARK_REGISTER_F(benchmark_wait_set, empty)->Apply(entities_and_counts);
+
+BENCHMARK_DEFINE_F(benchmark_wait_set, single_ready)(benchmark::State & state)
+{
+  // The ready subscription is last, as rmw_wait() stops checking at the first ready
+  if (!wait_set || !create(state, SUBSCRIPTION, state.range(0) - 1) ||
+    !create(state, SUBSCRIPTION, 1, ready_topic) || !create_publisher(state) ||
+    !publish(state))
+  {
+    return;
+  }
+  if (!wait_for_subscriptions(state, subscriptions.size() - 1)) {
+    return;
+  }
+  const rmw_time_t timeout = {0, 0};
+  for (auto _ : state) {
+    if (RMW_RET_OK != wait(&timeout)) {
+      state.SkipWithError("rmw_wait timed out");
+      break;
+    }
+  }
+}
+BENCHMARK_REGISTER_F(benchmark_wait_set, single_ready)->Apply(counts);
+
+BENCHMARK_DEFINE_F(benchmark_wait_set, all_ready)(benchmark::State & state)
+{
+  if (!wait_set || !create(state, SUBSCRIPTION, state.range(0), ready_topic) ||
+    !create_publisher(state) || !publish(state) ||
+    !wait_for_subscriptions(state, 0))
+  {
+    return;
+  }
+  const rmw_time_t timeout = {0, 0};
+  for (auto _ : state) {
+    if (RMW_RET_OK != wait(&timeout)) {
+      state.SkipWithError("rmw_wait timed out");
+      break;
+    }
+  }
+}
+BENCHMARK_REGISTER_F(benchmark_wait_set, all_ready)->Apply(counts);
+
+/// Measure the time from waking up the entity to rmw_wait() returning in another thread.
+/**
+ * \param[in] wait waits on the wait set
+ * \param[in] wake_up publishes to, or triggers, the last entity
+ * \param[in] take takes the message, or checks the guard condition, of the last entity
+ * \param[in] spin_period the spin period of the wait set
+ */
+template<typename Wait, typename WakeUp, typename Take>
+static void
+wake_up_latency(
+  benchmark::State & state, Wait wait, WakeUp wake_up, Take take,
+  std::chrono::microseconds spin_period)
+{
+  typedef std::chrono::steady_clock Clock;
+  std::atomic<bool> waiting(false);
+  std::atomic<bool> woken(false);
+  std::atomic<bool> stop(false);
+  Clock::time_point woken_at;
+  std::thread waiter([&]() {
+      while (!stop) {
+        waiting = true;
+        rmw_ret_t ret = wait();
+        auto now = Clock::now();
+        if (ret == RMW_RET_OK && take()) {
+          woken_at = now;
+          woken = true;
+          while (woken && !stop) {
+            std::this_thread::yield();
+          }
+        }
+      }
+    });
+  for (auto _ : state) {
+    while (!waiting) {
+      std::this_thread::yield();
+    }
+    waiting = false;
+    // Wake up the waiter while it spins, or once it has blocked
+    std::this_thread::sleep_for(
+      spin_period.count() ? spin_period / 2 : std::chrono::microseconds(200));
+    auto start = Clock::now();
+    if (!wake_up()) {
+      state.SkipWithError("failed to wake up the wait set");
+      break;
+    }
+    auto deadline = start + std::chrono::seconds(1);
+    while (!woken && Clock::now() < deadline) {
+      std::this_thread::yield();
+    }
+    if (!woken) {
+      state.SkipWithError("timed out waiting for the wait set to wake up");
+      break;
+    }
+    state.SetIterationTime(std::chrono::duration<double>(woken_at - start).count());
+    woken = false;
+  }
+  stop = true;
+  waiter.join();
+}
+
+BENCHMARK_DEFINE_F(benchmark_wait_set, wake_up_subscription)(benchmark::State & state)
+{
+  if (!wait_set || !create(state, SUBSCRIPTION, state.range(0) - 1) ||
+    !create(state, SUBSCRIPTION, 1, ready_topic) || !create_publisher(state))
+  {
+    return;
+  }
+  if (!check(state, RMW_RET_OK == rmw_dps_cpp_wait_set_set_spin_period(wait_set,
+    rmw_time_t{0, static_cast<uint64_t>(state.range(1)) * 1000}), "set spin period"))
+  {
+    return;
+  }
+  const rmw_time_t timeout = {1, 0};
+  rmw_subscription_t * ready = subscriptions.back();
+  wake_up_latency(state,
+    [this, &timeout]() {return wait(&timeout);},
+    [this, &state]() {return publish(state);},
+    [this, ready]() {
+      if (!subscriber_data.back()) {
+        return false;
+      }
+      test_msgs__msg__Empty message;
+      test_msgs__msg__Empty__init(&message);
+      bool taken = false;
+      rmw_ret_t ret = rmw_take(ready, &message, &taken, nullptr);
+      test_msgs__msg__Empty__fini(&message);
+      return ret == RMW_RET_OK && taken;
+    }, std::chrono::microseconds(state.range(1)));
+  report_statistics(state);
+}
+BENCHMARK_REGISTER_F(benchmark_wait_set, wake_up_subscription)->Apply(counts_and_spin_periods)
+->UseManualTime();
+
+BENCHMARK_DEFINE_F(benchmark_wait_set, wake_up_guard_condition)(benchmark::State & state)
+{
+  if (!wait_set || !create(state, GUARD_CONDITION, state.range(0))) {
+    return;
+  }
+  if (!check(state, RMW_RET_OK == rmw_dps_cpp_wait_set_set_spin_period(wait_set,
+    rmw_time_t{0, static_cast<uint64_t>(state.range(1)) * 1000}), "set spin period"))
+  {
+    return;
+  }
+  const rmw_time_t timeout = {1, 0};
+  rmw_guard_condition_t * ready = guard_conditions.back();
+  wake_up_latency(state,
+    [this, &timeout]() {return wait(&timeout);},
+    [ready]() {return RMW_RET_OK == rmw_trigger_guard_condition(ready);},
+    [this]() {return nullptr != guard_condition_data.back();},
+    std::chrono::microseconds(state.range(1)));
+  report_statistics(state);
+}
+BENCHMARK_REGISTER_F(benchmark_wait_set, wake_up_guard_condition)
+->Apply(counts_and_spin_periods)->UseManualTime();
+
+/// Raise the soft limit on open files to the hard limit, for the eventfds of the entities.
+static void
+raise_open_file_limit()
+{
+#ifdef __linux__
+  rlimit limit;
+  if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+    limit.rlim_cur = limit.rlim_max;
+    (void)setrlimit(RLIMIT_NOFILE, &limit);
+  }
+#endif
+}
+
+int
+main(int argc, char ** argv)
+{
+  raise_open_file_limit();
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  benchmark::RunSpecifiedBenchmarks();
+  return 0;
+}
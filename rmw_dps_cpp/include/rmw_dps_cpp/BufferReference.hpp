@@ -0,0 +1,61 @@
+// Copyright 2018 Intel Corporation All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef RMW_DPS_CPP__BUFFERREFERENCE_HPP_
+#define RMW_DPS_CPP__BUFFERREFERENCE_HPP_
+
+#include <dps/dps.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace rmw_dps_cpp
+{
+
+/// Message data sent in place, inserted after offset bytes of a stream.
+struct BufferReference
+{
+  size_t offset;
+  DPS_Buffer buffer;
+};
+
+/// Interleave the bytes of a stream with the data it references.
+/**
+ * \param[out] buffers the buffers whose concatenation is the serialized
+ *   message, reusing the memory of the vector
+ */
+inline void
+gather_buffers(
+  const uint8_t * data, size_t size, const std::vector<BufferReference> & references,
+  std::vector<DPS_Buffer> & buffers)
+{
+  buffers.clear();
+  buffers.reserve(2 * references.size() + 1);
+  size_t pos = 0;
+  for (const BufferReference & reference : references) {
+    if (reference.offset > pos) {
+      buffers.push_back({const_cast<uint8_t *>(data) + pos, reference.offset - pos});
+    }
+    buffers.push_back(reference.buffer);
+    pos = reference.offset;
+  }
+  if (size > pos || buffers.empty()) {
+    buffers.push_back({const_cast<uint8_t *>(data) + pos, size - pos});
+  }
+}
+
+}  // namespace rmw_dps_cpp
+
+#endif  // RMW_DPS_CPP__BUFFERREFERENCE_HPP_
@@ -23,6 +23,8 @@
 #include <string>
 #include <vector>
 
+#include "rmw_dps_cpp/BufferReference.hpp"
+
 namespace rmw_dps_cpp
 {
 
@@ -45,6 +47,7 @@ public:
     DPS_TxBufferFree(&buffer_);
   }
   TxStream(const TxStream & other)
+  : min_reference_size_(other.min_reference_size_), references_(other.references_)
   {
     ret_ = other.ret_;
     size_ = other.size_;
@@ -54,6 +57,7 @@ public:
     DPS_TxBufferAppend(&buffer_, other.buffer_.base, DPS_TxBufferUsed(&other.buffer_));
   }
   TxStream(TxStream && other)
+  : min_reference_size_(other.min_reference_size_), references_(std::move(other.references_))
   {
     ret_ = other.ret_;
     size_ = other.size_;
@@ -69,6 +73,8 @@ public:
       DPS_TxBufferFree(&buffer_);
       ret_ = other.ret_;
       size_ = other.size_;
+      min_reference_size_ = other.min_reference_size_;
+      references_ = other.references_;
       if (DPS_TxBufferInit(&buffer_, nullptr, DPS_TxBufferCapacity(&other.buffer_)) != DPS_OK) {
         throw std::bad_alloc();
       }
@@ -82,6 +88,8 @@ public:
       DPS_TxBufferFree(&buffer_);
       ret_ = other.ret_;
       size_ = other.size_;
+      min_reference_size_ = other.min_reference_size_;
+      references_ = std::move(other.references_);
       buffer_.base = other.buffer_.base;
       buffer_.eob = other.buffer_.eob;
       buffer_.txPos = other.buffer_.txPos;
@@ -92,11 +100,45 @@ public:
     return *this;
   }
 
+  /// The bytes written to the stream, the whole message when it has no references.
   const uint8_t * data() const noexcept {return buffer_.base;}
   size_t size() const noexcept {return DPS_TxBufferUsed(&buffer_);}
   DPS_Status status() const {return ret_;}
   size_t size_needed() const {return size_;}
 
+  /// Discard the contents, reserving hint bytes.
+  void reset(size_t hint)
+  {
+    DPS_TxBufferFree(&buffer_);
+    ret_ = DPS_OK;
+    size_ = 0;
+    references_.clear();
+    if (DPS_TxBufferInit(&buffer_, nullptr, hint) != DPS_OK) {
+      throw std::bad_alloc();
+    }
+  }
+  /// Discard the contents, keeping the buffer to write the next message into.
+  void clear()
+  {
+    buffer_.txPos = buffer_.base;
+    ret_ = DPS_OK;
+    size_ = 0;
+    references_.clear();
+  }
+
+  /// Reference byte arrays of at least size bytes in place instead of copying them.
+  /**
+   * The referenced arrays must outlive the use of buffers(). Zero, the
+   * default, copies all arrays.
+   */
+  void setMinReferenceSize(size_t size) {min_reference_size_ = size;}
+  bool hasReferences() const {return !references_.empty();}
+  /// Get the buffers whose concatenation is the serialized message.
+  void buffers(std::vector<DPS_Buffer> & bufs) const
+  {
+    gather_buffers(data(), size(), references_, bufs);
+  }
+
   inline TxStream & operator<<(const uint64_t n)
   {
     size_ += CBOR_SIZEOF_UINT(n);
@@ -139,7 +181,7 @@ public:
     return *this;
   }
 
-  inline TxStream & operator<<(const std::string s)
+  inline TxStream & operator<<(const std::string & s)
   {
     size_ += CBOR_SIZEOF_STRING_AND_LENGTH(s.size());
     if (ret_ == DPS_OK) {
@@ -148,7 +190,7 @@ public:
     return *this;
   }
 
-  inline TxStream & operator<<(const std::u16string s)
+  inline TxStream & operator<<(const std::u16string & s)
   {
     size_ += CBOR_SIZEOF_ARRAY(s.size());
     if (ret_ == DPS_OK) {
@@ -161,12 +203,12 @@ public:
   }
 
   template<typename T>
-  inline TxStream & operator<<(const std::vector<T> v)
+  inline TxStream & operator<<(const std::vector<T> & v)
   {
     return encodeSequence(v.data(), v.size());
   }
 
-  inline TxStream & operator<<(const std::vector<bool> v)
+  inline TxStream & operator<<(const std::vector<bool> & v)
   {
     size_ += CBOR_SIZEOF_ARRAY(v.size());
     if (ret_ == DPS_OK) {
@@ -193,6 +235,17 @@ public:
     return *this;
   }
 
+  template<typename T>
+  inline TxStream & serializeArray(const T * items, size_t size)
+  {
+    return encodeSequence(items, size);
+  }
+
+  inline TxStream & serializeStructHeader(size_t member_count)
+  {
+    return serializeSequence(member_count);
+  }
+
   inline TxStream & operator<<(const bool b)
   {
     size_ += CBOR_SIZEOF_BOOLEAN();
@@ -206,6 +259,8 @@ private:
   DPS_Status ret_;
   size_t size_;
   DPS_TxBuffer buffer_;
+  size_t min_reference_size_ = 0;
+  std::vector<BufferReference> references_;
 
   template<typename T>
   inline TxStream & encodeSequence(const T * items, size_t size)
@@ -222,6 +277,17 @@ private:
 
   inline TxStream & encodeSequence(const uint8_t * items, size_t size)
   {
+    if (min_reference_size_ && size >= min_reference_size_) {
+      // Only the byte string header is written, the bytes follow it on the wire
+      size_ += CBOR_SIZEOF_LEN(size);
+      if (ret_ == DPS_OK) {
+        ret_ = CBOR_EncodeLength(&buffer_, size, CBOR_BYTES);
+      }
+      if (ret_ == DPS_OK) {
+        references_.push_back({this->size(), {const_cast<uint8_t *>(items), size}});
+      }
+      return *this;
+    }
     size_ += CBOR_SIZEOF_BYTES(size);
     if (ret_ == DPS_OK) {
       ret_ = CBOR_EncodeBytes(&buffer_, items, size);
@@ -239,18 +305,38 @@ public:
   }
   ~RxStream()
   {
-    DPS_RxBufferFree(&buffer_);
+    if (owned_) {
+      DPS_RxBufferFree(&buffer_);
+    }
   }
   RxStream(const uint8_t * data, size_t size)
   {
     copy(data, data + size);
   }
+  /// Create a stream that decodes data in place, without copying or freeing it.
+  static RxStream view(uint8_t * data, size_t size)
+  {
+    RxStream stream;
+    DPS_RxBufferInit(&stream.buffer_, data, size);
+    stream.owned_ = false;
+    return stream;
+  }
+  /// Create a stream that takes ownership of data allocated with malloc().
+  static RxStream adopt(uint8_t * data, size_t size)
+  {
+    RxStream stream;
+    DPS_RxBufferInit(&stream.buffer_, data, size);
+    return stream;
+  }
   RxStream(const RxStream & other)
   {
     copy(other.buffer_.base, other.buffer_.eod);
+    max_sequence_size_ = other.max_sequence_size_;
   }
   RxStream(RxStream && other)
   {
+    max_sequence_size_ = other.max_sequence_size_;
+    owned_ = other.owned_;
     buffer_.base = other.buffer_.base;
     buffer_.eod = other.buffer_.eod;
     buffer_.rxPos = other.buffer_.rxPos;
@@ -259,14 +345,23 @@ public:
   RxStream & operator=(const RxStream & other)
   {
     if (this != &other) {
-      DPS_RxBufferFree(&buffer_);
+      if (owned_) {
+        DPS_RxBufferFree(&buffer_);
+      }
       copy(other.buffer_.base, other.buffer_.eod);
+      owned_ = true;
+      max_sequence_size_ = other.max_sequence_size_;
     }
     return *this;
   }
   RxStream & operator=(RxStream && other)
   {
     if (this != &other) {
+      if (owned_) {
+        DPS_RxBufferFree(&buffer_);
+      }
+      max_sequence_size_ = other.max_sequence_size_;
+      owned_ = other.owned_;
       buffer_.base = other.buffer_.base;
       buffer_.eod = other.buffer_.eod;
       buffer_.rxPos = other.buffer_.rxPos;
@@ -283,6 +378,46 @@ public:
   {
     return buffer_.eod - buffer_.base;
   }
+  /// Give up ownership of the buffer, leaving the stream empty.
+  /**
+   * \return the buffer, of getBufferSize() bytes allocated with malloc(), to be
+   *   released with free(), or null if the stream does not own its buffer.
+   */
+  uint8_t * release()
+  {
+    if (!owned_) {
+      return nullptr;
+    }
+    uint8_t * data = buffer_.base;
+    DPS_RxBufferClear(&buffer_);
+    return data;
+  }
+
+  /// Limit the length of any sequence or string accepted while decoding.
+  void setMaxSequenceSize(size_t size)
+  {
+    max_sequence_size_ = size;
+  }
+  size_t getMaxSequenceSize() const
+  {
+    return max_sequence_size_;
+  }
+
+  /// Throw if a decoded length cannot be valid for the rest of the payload.
+  /**
+   * Every CBOR item occupies at least one byte, so a length greater than the
+   * number of bytes remaining is corrupt and is rejected before anything is
+   * allocated for it.
+   */
+  inline void checkSequenceSize(uint64_t size) const
+  {
+    if (size > static_cast<uint64_t>(buffer_.eod - buffer_.rxPos)) {
+      throw std::runtime_error("sequence size exceeds remaining payload");
+    }
+    if (size > max_sequence_size_) {
+      throw std::runtime_error("sequence size exceeds maximum");
+    }
+  }
 
   inline RxStream & operator>>(uint64_t & n)
   {
@@ -395,6 +530,9 @@ public:
     if (ret != DPS_OK) {
       throw std::runtime_error("failed to deserialize std::string");
     }
+    if (size > max_sequence_size_) {
+      throw std::runtime_error("string size exceeds maximum");
+    }
     if (!size) {
       s = std::string();
     } else {
@@ -410,6 +548,7 @@ public:
     if (ret != DPS_OK) {
       throw std::runtime_error("failed to deserialize std::vector<>");
     }
+    checkSequenceSize(size);
     s.resize(size);
     for (size_t i = 0; i < size; ++i) {
       *this >> s[i];
@@ -425,6 +564,7 @@ public:
     if (ret != DPS_OK) {
       throw std::runtime_error("failed to deserialize std::vector<>");
     }
+    checkSequenceSize(size);
     v.resize(size);
     for (size_t i = 0; i < size; ++i) {
       *this >> v[i];
@@ -439,6 +579,7 @@ public:
     if (ret != DPS_OK) {
       throw std::runtime_error("failed to deserialize std::vector<bool>");
     }
+    checkSequenceSize(size);
     v.resize(size);
     for (size_t i = 0; i < size; ++i) {
       int b;
@@ -459,6 +600,9 @@ public:
     if (ret != DPS_OK) {
       throw std::runtime_error("failed to deserialize std::vector<uint8_t>");
     }
+    if (size > max_sequence_size_) {
+      throw std::runtime_error("sequence size exceeds maximum");
+    }
     v.assign(items, items + size);
     return *this;
   }
@@ -475,6 +619,23 @@ public:
     if (ret != DPS_OK) {
       throw std::runtime_error("failed to deserialize array");
     }
+    checkSequenceSize(*size);
+    return *this;
+  }
+
+  template<typename T>
+  inline RxStream & deserializeArray(T * items, size_t size)
+  {
+    return decodeSequence(items, size);
+  }
+
+  inline RxStream & deserializeStructHeader(size_t member_count)
+  {
+    size_t size = 0;
+    deserializeSequence(&size);
+    if (size != member_count) {
+      throw std::runtime_error("failed to deserialize value");
+    }
     return *this;
   }
 
@@ -489,10 +650,55 @@ public:
     if (info > std::numeric_limits<std::size_t>::max()) {
       throw std::runtime_error("array size too large");
     }
+    checkSequenceSize(info);
+    *size = (size_t)info;
+    return *this;
+  }
+
+  inline RxStream & deserializeStringSize(size_t * size)
+  {
+    uint8_t maj;
+    uint64_t info;
+    DPS_Status ret = CBOR_Peek(&buffer_, &maj, &info);
+    if (ret != DPS_OK || maj != CBOR_STRING) {
+      throw std::runtime_error("failed to deserialize string size");
+    }
+    checkSequenceSize(info);
     *size = (size_t)info;
     return *this;
   }
 
+  /// Skip over the next item without decoding it.
+  inline RxStream & skip()
+  {
+    uint8_t maj;
+    size_t size;
+    DPS_Status ret = CBOR_Skip(&buffer_, &maj, &size);
+    if (ret != DPS_OK) {
+      throw std::runtime_error("failed to skip item");
+    }
+    return *this;
+  }
+
+  // Values, arrays and sequences are each a single item.
+  template<typename T>
+  inline RxStream & skipValue()
+  {
+    return skip();
+  }
+
+  template<typename T>
+  inline RxStream & skipArray(size_t)
+  {
+    return skip();
+  }
+
+  template<typename T>
+  inline RxStream & skipSequence()
+  {
+    return skip();
+  }
+
   inline RxStream & operator>>(bool & b)
   {
     int b_;
@@ -506,6 +712,8 @@ public:
 
 private:
   DPS_RxBuffer buffer_;
+  size_t max_sequence_size_ = std::numeric_limits<size_t>::max();
+  bool owned_ = true;
 
   void
   copy(const uint8_t * begin, const uint8_t * end)
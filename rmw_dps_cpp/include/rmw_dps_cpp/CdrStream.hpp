@@ -0,0 +1,545 @@
+// Copyright 2018 Intel Corporation All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef RMW_DPS_CPP__CDRSTREAM_HPP_
+#define RMW_DPS_CPP__CDRSTREAM_HPP_
+
+#include <dps/dps.h>
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "rmw_dps_cpp/BufferReference.hpp"
+
+namespace rmw_dps_cpp
+{
+
+/// Plain CDR (XCDR1) encoding.
+/**
+ * The payload starts with the 4 byte encapsulation header {0x00, 0x00 (big
+ * endian) or 0x01 (little endian), 0x00, 0x00}.  Primitives are aligned to
+ * their size relative to the end of the header, strings are a uint32 length
+ * including the terminating NUL followed by the characters, sequences are a
+ * uint32 count followed by the items, and fixed size arrays have no count.
+ * Wide strings are a uint32 count followed by 16 bit characters.
+ *
+ * A CBOR payload never starts with two bytes that form a CDR encapsulation
+ * header, so the format of a received payload is determined from its first
+ * bytes; see is_cdr().
+ */
+namespace cdr
+{
+
+const size_t encapsulation_size = 4;
+
+inline bool
+is_big_endian()
+{
+  const uint16_t n = 1;
+  return *reinterpret_cast<const uint8_t *>(&n) == 0;
+}
+
+inline bool
+is_cdr(const uint8_t * data, size_t size)
+{
+  return size >= encapsulation_size && data[0] == 0x00 && (data[1] == 0x00 || data[1] == 0x01) &&
+         data[2] == 0x00 && data[3] == 0x00;
+}
+
+class TxStream
+{
+public:
+  explicit TxStream(size_t hint = 1024)
+  {
+    reset(hint);
+  }
+
+  /// The bytes written to the stream, the whole message when it has no references.
+  const uint8_t * data() const noexcept {return buffer_.data();}
+  size_t size() const noexcept {return buffer_.size();}
+  DPS_Status status() const {return DPS_OK;}
+  size_t size_needed() const {return buffer_.size();}
+
+  /// Discard the contents, reserving hint bytes.
+  void reset(size_t hint)
+  {
+    buffer_.clear();
+    buffer_.reserve(std::max(hint, encapsulation_size));
+    buffer_.push_back(0x00);
+    buffer_.push_back(is_big_endian() ? 0x00 : 0x01);
+    buffer_.push_back(0x00);
+    buffer_.push_back(0x00);
+    references_.clear();
+    referenced_size_ = 0;
+  }
+  /// Discard the contents, keeping the buffer to write the next message into.
+  void clear() {reset(0);}
+
+  /// Reference primitive arrays of at least size bytes in place instead of copying them.
+  /**
+   * The referenced arrays must outlive the use of buffers(). Zero, the
+   * default, copies all arrays.
+   */
+  void setMinReferenceSize(size_t size) {min_reference_size_ = size;}
+  bool hasReferences() const {return !references_.empty();}
+  /// Get the buffers whose concatenation is the serialized message.
+  void buffers(std::vector<DPS_Buffer> & bufs) const
+  {
+    gather_buffers(data(), size(), references_, bufs);
+  }
+
+  inline TxStream & operator<<(const uint64_t n) {return write(n);}
+  inline TxStream & operator<<(const uint32_t n) {return write(n);}
+  inline TxStream & operator<<(const uint16_t n) {return write(n);}
+  inline TxStream & operator<<(const uint8_t n) {return write(n);}
+  inline TxStream & operator<<(const int64_t i) {return write(i);}
+  inline TxStream & operator<<(const int32_t i) {return write(i);}
+  inline TxStream & operator<<(const int16_t i) {return write(i);}
+  inline TxStream & operator<<(const int8_t i) {return write(i);}
+  inline TxStream & operator<<(const char c) {return write(c);}
+  inline TxStream & operator<<(const char16_t c) {return write(static_cast<uint16_t>(c));}
+  inline TxStream & operator<<(const float f) {return write(f);}
+  inline TxStream & operator<<(const double d) {return write(d);}
+  inline TxStream & operator<<(const bool b) {return write(static_cast<uint8_t>(b ? 1 : 0));}
+
+  inline TxStream & operator<<(const std::string & s)
+  {
+    *this << static_cast<uint32_t>(s.size() + 1);
+    buffer_.insert(buffer_.end(), s.begin(), s.end());
+    buffer_.push_back(0);
+    return *this;
+  }
+
+  inline TxStream & operator<<(const std::u16string & s)
+  {
+    *this << static_cast<uint32_t>(s.size());
+    // Strings of C messages are converted to temporaries, so are never referenced
+    return copyBlock(s.data(), s.size());
+  }
+
+  template<typename T>
+  inline TxStream & operator<<(const std::vector<T> & v)
+  {
+    return serializeSequence(v.data(), v.size());
+  }
+
+  inline TxStream & operator<<(const std::vector<bool> & v)
+  {
+    *this << static_cast<uint32_t>(v.size());
+    for (size_t i = 0; i < v.size(); ++i) {
+      *this << static_cast<bool>(v[i]);
+    }
+    return *this;
+  }
+
+  template<typename T>
+  inline TxStream & serializeSequence(const T * items, size_t size)
+  {
+    *this << static_cast<uint32_t>(size);
+    return encodeArray(items, size);
+  }
+
+  template<typename T>
+  inline TxStream & serializeArray(const T * items, size_t size)
+  {
+    return encodeArray(items, size);
+  }
+
+  inline TxStream & serializeStructHeader(size_t)
+  {
+    return *this;
+  }
+
+private:
+  std::vector<uint8_t> buffer_;
+  size_t min_reference_size_ = 0;
+  std::vector<BufferReference> references_;
+  size_t referenced_size_ = 0;
+
+  inline void align(size_t alignment)
+  {
+    // Referenced arrays occupy the wire between the bytes of the buffer
+    size_t offset = (buffer_.size() + referenced_size_ - encapsulation_size) % alignment;
+    if (offset) {
+      buffer_.insert(buffer_.end(), alignment - offset, 0);
+    }
+  }
+
+  template<typename T>
+  inline TxStream & write(const T & value)
+  {
+    align(sizeof(T));
+    const uint8_t * p = reinterpret_cast<const uint8_t *>(&value);
+    buffer_.insert(buffer_.end(), p, p + sizeof(T));
+    return *this;
+  }
+
+  template<typename T>
+  inline TxStream & encodeArray(const T * items, size_t size)
+  {
+    for (size_t i = 0; i < size; ++i) {
+      *this << items[i];
+    }
+    return *this;
+  }
+
+  template<typename T>
+  inline TxStream & copyBlock(const T * items, size_t size)
+  {
+    if (size) {
+      align(sizeof(T));
+      const uint8_t * p = reinterpret_cast<const uint8_t *>(items);
+      buffer_.insert(buffer_.end(), p, p + size * sizeof(T));
+    }
+    return *this;
+  }
+
+  template<typename T>
+  inline TxStream & encodeBlock(const T * items, size_t size)
+  {
+    if (!min_reference_size_ || size * sizeof(T) < min_reference_size_) {
+      return copyBlock(items, size);
+    }
+    align(sizeof(T));
+    uint8_t * p = reinterpret_cast<uint8_t *>(const_cast<T *>(items));
+    references_.push_back({buffer_.size(), {p, size * sizeof(T)}});
+    referenced_size_ += size * sizeof(T);
+    return *this;
+  }
+
+  inline TxStream & encodeArray(const uint8_t * items, size_t n) {return encodeBlock(items, n);}
+  inline TxStream & encodeArray(const int8_t * items, size_t n) {return encodeBlock(items, n);}
+  inline TxStream & encodeArray(const char * items, size_t n) {return encodeBlock(items, n);}
+  inline TxStream & encodeArray(const uint16_t * items, size_t n) {return encodeBlock(items, n);}
+  inline TxStream & encodeArray(const int16_t * items, size_t n) {return encodeBlock(items, n);}
+  inline TxStream & encodeArray(const char16_t * items, size_t n) {return encodeBlock(items, n);}
+  inline TxStream & encodeArray(const uint32_t * items, size_t n) {return encodeBlock(items, n);}
+  inline TxStream & encodeArray(const int32_t * items, size_t n) {return encodeBlock(items, n);}
+  inline TxStream & encodeArray(const uint64_t * items, size_t n) {return encodeBlock(items, n);}
+  inline TxStream & encodeArray(const int64_t * items, size_t n) {return encodeBlock(items, n);}
+  inline TxStream & encodeArray(const float * items, size_t n) {return encodeBlock(items, n);}
+  inline TxStream & encodeArray(const double * items, size_t n) {return encodeBlock(items, n);}
+};
+
+/// A read-only view of a CDR payload; the underlying bytes must outlive it.
+class RxStream
+{
+public:
+  RxStream(const uint8_t * data, size_t size)
+  : begin_(data + encapsulation_size), pos_(begin_), end_(data + size)
+  {
+    if (!is_cdr(data, size)) {
+      throw std::runtime_error("invalid CDR encapsulation");
+    }
+    swap_ = (data[1] == 0x00) != is_big_endian();
+  }
+
+  const uint8_t * getBuffer() const
+  {
+    return begin_ - encapsulation_size;
+  }
+  size_t getBufferSize() const
+  {
+    return end_ - getBuffer();
+  }
+
+  /// Limit the length of any sequence or string accepted while decoding.
+  void setMaxSequenceSize(size_t size)
+  {
+    max_sequence_size_ = size;
+  }
+  size_t getMaxSequenceSize() const
+  {
+    return max_sequence_size_;
+  }
+
+  /// Throw if a decoded length cannot be valid for the rest of the payload.
+  inline void checkSequenceSize(uint64_t size) const
+  {
+    if (size > static_cast<uint64_t>(end_ - pos_)) {
+      throw std::runtime_error("sequence size exceeds remaining payload");
+    }
+    if (size > max_sequence_size_) {
+      throw std::runtime_error("sequence size exceeds maximum");
+    }
+  }
+
+  inline RxStream & operator>>(uint64_t & n) {return read(n);}
+  inline RxStream & operator>>(uint32_t & n) {return read(n);}
+  inline RxStream & operator>>(uint16_t & n) {return read(n);}
+  inline RxStream & operator>>(uint8_t & n) {return read(n);}
+  inline RxStream & operator>>(int64_t & i) {return read(i);}
+  inline RxStream & operator>>(int32_t & i) {return read(i);}
+  inline RxStream & operator>>(int16_t & i) {return read(i);}
+  inline RxStream & operator>>(int8_t & i) {return read(i);}
+  inline RxStream & operator>>(char & c) {return read(c);}
+  inline RxStream & operator>>(float & f) {return read(f);}
+  inline RxStream & operator>>(double & d) {return read(d);}
+
+  inline RxStream & operator>>(char16_t & c)
+  {
+    uint16_t n;
+    read(n);
+    c = n;
+    return *this;
+  }
+
+  inline RxStream & operator>>(bool & b)
+  {
+    uint8_t n;
+    read(n);
+    b = n ? true : false;
+    return *this;
+  }
+
+  inline RxStream & operator>>(std::string & s)
+  {
+    uint32_t size;
+    *this >> size;
+    checkSequenceSize(size);
+    if (!size) {
+      s = std::string();
+      return *this;
+    }
+    const char * data = reinterpret_cast<const char *>(pos_);
+    pos_ += size;
+    // The length includes the terminating NUL.
+    s.assign(data, data[size - 1] ? size : size - 1);
+    return *this;
+  }
+
+  inline RxStream & operator>>(std::u16string & s)
+  {
+    uint32_t size;
+    *this >> size;
+    checkSequenceSize(size);
+    s.resize(size);
+    for (size_t i = 0; i < size; ++i) {
+      *this >> s[i];
+    }
+    return *this;
+  }
+
+  template<typename T>
+  inline RxStream & operator>>(std::vector<T> & v)
+  {
+    uint32_t size;
+    *this >> size;
+    checkSequenceSize(size);
+    v.resize(size);
+    return decodeArray(v.data(), size);
+  }
+
+  inline RxStream & operator>>(std::vector<bool> & v)
+  {
+    uint32_t size;
+    *this >> size;
+    checkSequenceSize(size);
+    v.resize(size);
+    for (size_t i = 0; i < size; ++i) {
+      bool b;
+      *this >> b;
+      v[i] = b;
+    }
+    return *this;
+  }
+
+  template<typename T>
+  inline RxStream & deserializeSequence(T * items, size_t size)
+  {
+    uint32_t size_;
+    *this >> size_;
+    if (size_ != size) {
+      throw std::runtime_error("failed to deserialize sequence");
+    }
+    return decodeArray(items, size);
+  }
+
+  template<typename T>
+  inline RxStream & deserializeArray(T * items, size_t size)
+  {
+    return decodeArray(items, size);
+  }
+
+  inline RxStream & deserializeStructHeader(size_t)
+  {
+    return *this;
+  }
+
+  inline RxStream & deserializeSequenceSize(size_t * size)
+  {
+    const uint8_t * pos = pos_;
+    uint32_t size_;
+    *this >> size_;
+    checkSequenceSize(size_);
+    pos_ = pos;
+    *size = size_;
+    return *this;
+  }
+
+  template<typename T>
+  inline RxStream & skipValue()
+  {
+    return skipItems(static_cast<T *>(nullptr), 1);
+  }
+
+  template<typename T>
+  inline RxStream & skipArray(size_t size)
+  {
+    return skipItems(static_cast<T *>(nullptr), size);
+  }
+
+  template<typename T>
+  inline RxStream & skipSequence()
+  {
+    uint32_t size;
+    *this >> size;
+    checkSequenceSize(size);
+    return skipItems(static_cast<T *>(nullptr), size);
+  }
+
+  inline RxStream & deserializeStringSize(size_t * size)
+  {
+    deserializeSequenceSize(size);
+    if (*size) {
+      // The length includes the terminating NUL.
+      --*size;
+    }
+    return *this;
+  }
+
+private:
+  const uint8_t * begin_;
+  const uint8_t * pos_;
+  const uint8_t * end_;
+  bool swap_;
+  size_t max_sequence_size_ = std::numeric_limits<size_t>::max();
+
+  inline void align(size_t alignment)
+  {
+    size_t offset = (pos_ - begin_) % alignment;
+    if (offset) {
+      pos_ += std::min(alignment - offset, static_cast<size_t>(end_ - pos_));
+    }
+  }
+
+  inline void need(size_t size) const
+  {
+    if (size > static_cast<size_t>(end_ - pos_)) {
+      throw std::runtime_error("failed to deserialize, end of data");
+    }
+  }
+
+  template<typename T>
+  inline void swap(T & value) const
+  {
+    if (swap_ && sizeof(T) > 1) {
+      uint8_t * p = reinterpret_cast<uint8_t *>(&value);
+      std::reverse(p, p + sizeof(T));
+    }
+  }
+
+  template<typename T>
+  inline RxStream & read(T & value)
+  {
+    align(sizeof(T));
+    need(sizeof(T));
+    memcpy(&value, pos_, sizeof(T));
+    pos_ += sizeof(T);
+    swap(value);
+    return *this;
+  }
+
+  template<typename T>
+  inline RxStream & skipItems(T *, size_t size)
+  {
+    if (size) {
+      align(sizeof(T));
+      if (size > static_cast<size_t>(end_ - pos_) / sizeof(T)) {
+        throw std::runtime_error("failed to skip array, end of data");
+      }
+      pos_ += size * sizeof(T);
+    }
+    return *this;
+  }
+
+  inline RxStream & skipItems(std::string *, size_t size)
+  {
+    for (size_t i = 0; i < size; ++i) {
+      uint32_t length;
+      *this >> length;
+      need(length);
+      pos_ += length;
+    }
+    return *this;
+  }
+
+  inline RxStream & skipItems(std::u16string *, size_t size)
+  {
+    for (size_t i = 0; i < size; ++i) {
+      uint32_t length;
+      *this >> length;
+      skipItems(static_cast<char16_t *>(nullptr), length);
+    }
+    return *this;
+  }
+
+  template<typename T>
+  inline RxStream & decodeArray(T * items, size_t size)
+  {
+    for (size_t i = 0; i < size; ++i) {
+      *this >> items[i];
+    }
+    return *this;
+  }
+
+  template<typename T>
+  inline RxStream & decodeBlock(T * items, size_t size)
+  {
+    if (size) {
+      align(sizeof(T));
+      if (size > static_cast<size_t>(end_ - pos_) / sizeof(T)) {
+        throw std::runtime_error("failed to deserialize array, end of data");
+      }
+      memcpy(items, pos_, size * sizeof(T));
+      pos_ += size * sizeof(T);
+      for (size_t i = 0; swap_ && i < size; ++i) {
+        swap(items[i]);
+      }
+    }
+    return *this;
+  }
+
+  inline RxStream & decodeArray(uint8_t * items, size_t size) {return decodeBlock(items, size);}
+  inline RxStream & decodeArray(int8_t * items, size_t size) {return decodeBlock(items, size);}
+  inline RxStream & decodeArray(char * items, size_t size) {return decodeBlock(items, size);}
+  inline RxStream & decodeArray(uint16_t * items, size_t size) {return decodeBlock(items, size);}
+  inline RxStream & decodeArray(int16_t * items, size_t size) {return decodeBlock(items, size);}
+  inline RxStream & decodeArray(uint32_t * items, size_t size) {return decodeBlock(items, size);}
+  inline RxStream & decodeArray(int32_t * items, size_t size) {return decodeBlock(items, size);}
+  inline RxStream & decodeArray(uint64_t * items, size_t size) {return decodeBlock(items, size);}
+  inline RxStream & decodeArray(int64_t * items, size_t size) {return decodeBlock(items, size);}
+  inline RxStream & decodeArray(float * items, size_t size) {return decodeBlock(items, size);}
+  inline RxStream & decodeArray(double * items, size_t size) {return decodeBlock(items, size);}
+};
+
+}  // namespace cdr
+
+}  // namespace rmw_dps_cpp
+
+#endif  // RMW_DPS_CPP__CDRSTREAM_HPP_
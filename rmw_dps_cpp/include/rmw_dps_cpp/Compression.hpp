@@ -0,0 +1,90 @@
+// Copyright 2018 Intel Corporation All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef RMW_DPS_CPP__COMPRESSION_HPP_
+#define RMW_DPS_CPP__COMPRESSION_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "rmw_dps_cpp/CborStream.hpp"
+
+namespace rmw_dps_cpp
+{
+
+/// A payload may be published compressed.
+/**
+ * A compressed payload is a 12 byte header followed by the compressed bytes.
+ * The header is the magic bytes {0xf7, 'C', 'M', 'P'}, the codec, three
+ * zero bytes and the little endian uint32 size of the uncompressed payload.
+ * As with fragments, neither a CBOR nor a CDR payload starts with 0xf7. A
+ * compressed payload may itself be published in fragments.
+ */
+const size_t compression_header_size = 12;
+
+enum class Codec : uint8_t
+{
+  NONE = 0,
+  /// A byte oriented LZ77 codec built into rmw_dps_cpp, fast rather than thorough.
+  LZ = 1,
+  /// zstd, when rmw_dps_cpp is built with it.
+  ZSTD = 2
+};
+
+/// Return the codec named "lz" or "zstd".
+/**
+ * \return false if the name is unknown or the codec is not available in this build.
+ */
+bool
+get_codec(const char * name, Codec & codec);
+
+inline bool
+is_compressed(const uint8_t * data, size_t size)
+{
+  return size >= compression_header_size && data[0] == 0xf7 && data[1] == 'C' &&
+         data[2] == 'M' && data[3] == 'P';
+}
+
+/// Return the size of a compressed payload once uncompressed.
+inline size_t
+get_uncompressed_size(const uint8_t * data)
+{
+  uint32_t size = 0;
+  for (size_t j = 0; j < 4; ++j) {
+    size |= static_cast<uint32_t>(data[8 + j]) << (8 * j);
+  }
+  return size;
+}
+
+/// Compress a payload, header included.
+/**
+ * \return false if the payload cannot be compressed to fewer bytes than it has.
+ */
+bool
+compress(Codec codec, const uint8_t * data, size_t size, std::vector<uint8_t> & compressed);
+
+/// Replace a compressed payload with the uncompressed one.
+/**
+ * Other payloads are left as they are.
+ * \param[in] max_size payloads larger than this once uncompressed are rejected, zero for
+ *   default_max_payload_size
+ * \return false if the payload cannot be uncompressed.
+ */
+bool
+decompress(cbor::RxStream & payload, size_t max_size = 0);
+
+}  // namespace rmw_dps_cpp
+
+#endif  // RMW_DPS_CPP__COMPRESSION_HPP_
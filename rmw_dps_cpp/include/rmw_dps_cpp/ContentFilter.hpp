@@ -0,0 +1,228 @@
+// Copyright 2018 Intel Corporation All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef RMW_DPS_CPP__CONTENTFILTER_HPP_
+#define RMW_DPS_CPP__CONTENTFILTER_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "rosidl_typesupport_introspection_cpp/field_types.hpp"
+
+namespace rmw_dps_cpp
+{
+
+/// A field or literal value compared by a content filter.
+/**
+ * Booleans and all numeric types are compared as numbers.
+ */
+struct FilterValue
+{
+  enum Type
+  {
+    NONE,
+    NUMBER,
+    STRING
+  };
+  Type type = NONE;
+  long double number = 0;
+  std::string string;
+};
+
+/// The members of a message read by a content filter.
+struct FilterField
+{
+  /// Indexed by member when the field is a message; a null entry is skipped.
+  std::vector<std::unique_ptr<FilterField>> members;
+  /// The index of the value read for a field.
+  size_t slot = 0;
+};
+
+/// Reads the values of selected fields from serialized messages.
+/**
+ * A field is a '.' separated member path, e.g. "header.frame_id", naming a
+ * primitive or string member outside of any array.
+ */
+class FieldReader
+{
+public:
+  virtual ~FieldReader();
+
+  /// The member paths of the fields read, indexed by value slot.
+  const std::vector<std::string> &
+  fields() const
+  {
+    return fields_;
+  }
+
+  /// The type of the value read for each field.
+  const std::vector<FilterValue::Type> &
+  types() const
+  {
+    return types_;
+  }
+
+  /// Read the values of the fields from a CBOR or CDR payload.
+  /**
+   * \return false if the payload cannot be decoded.
+   */
+  virtual bool
+  read(uint8_t * payload, size_t len, std::vector<FilterValue> & values) const = 0;
+
+protected:
+  /// Locate the fields in a message.
+  /**
+   * \throw std::invalid_argument if a field is not a member of the message.
+   */
+  template<typename MembersType>
+  void
+  resolve(const MembersType * members, const std::vector<std::string> & fields);
+
+  std::vector<std::string> fields_;
+  std::vector<FilterValue::Type> types_;
+  FilterField root_;
+};
+
+/// Format a value for use in a DPS topic.
+std::string
+to_topic_string(const FilterValue & value);
+
+/// A filter expression over the fields of a message.
+/**
+ * The grammar is a subset of the DDS content filter expression syntax:
+ *
+ *   expression := term { OR term }
+ *   term := factor { AND factor }
+ *   factor := NOT factor | '(' expression ')' | operand op operand
+ *   op := = | == | <> | != | < | <= | > | >=
+ *   operand := field | number | 'string' | TRUE | FALSE | %n
+ *
+ * See FieldReader for the fields that may be compared. One side of each
+ * comparison must be a field and the other a literal. %n is replaced by the
+ * n'th expression parameter, which is itself parsed as a literal.
+ */
+class ContentFilter
+{
+public:
+  /// \throw std::invalid_argument if the expression is malformed.
+  ContentFilter(const std::string & expression, const std::vector<std::string> & parameters);
+  ~ContentFilter();
+
+  /// The member paths of the fields compared, indexed by value slot.
+  const std::vector<std::string> &
+  fields() const
+  {
+    return fields_;
+  }
+
+  /// Set the reader of the fields, checking their types against the literals.
+  /**
+   * \throw std::invalid_argument if a field is compared to a literal of another type.
+   */
+  void
+  setReader(std::unique_ptr<FieldReader> reader);
+
+  /// Evaluate the expression for the values read from a message.
+  bool
+  evaluate(const std::vector<FilterValue> & values) const;
+
+  /// Return true if a serialized message satisfies the filter.
+  /**
+   * Payloads that cannot be decoded do not match.
+   */
+  bool
+  matches(uint8_t * payload, size_t len) const;
+
+private:
+  friend class ContentFilterParser;
+  struct Node;
+
+  std::vector<std::string> fields_;
+  std::unique_ptr<FieldReader> reader_;
+  std::unique_ptr<Node> expression_;
+
+  void
+  check_types(const Node & node) const;
+
+  bool
+  evaluate(const Node & node, const std::vector<FilterValue> & values) const;
+};
+
+template<typename MembersType>
+void
+FieldReader::resolve(const MembersType * members, const std::vector<std::string> & fields)
+{
+  fields_ = fields;
+  types_.assign(fields_.size(), FilterValue::NONE);
+  root_.members.clear();
+  root_.members.resize(members->member_count_);
+  for (size_t slot = 0; slot < fields_.size(); ++slot) {
+    const std::string & path = fields_[slot];
+    const MembersType * parent = members;
+    FilterField * field = &root_;
+    size_t begin = 0;
+    while (true) {
+      size_t end = path.find('.', begin);
+      std::string name = path.substr(begin, end == std::string::npos ? end : end - begin);
+      uint32_t i = 0;
+      while (i < parent->member_count_ && name != parent->members_[i].name_) {
+        ++i;
+      }
+      if (i == parent->member_count_) {
+        throw std::invalid_argument("unknown field '" + path + "'");
+      }
+      const auto member = parent->members_ + i;
+      if (member->is_array_) {
+        throw std::invalid_argument("array field '" + path + "' is not supported");
+      }
+      std::unique_ptr<FilterField> & sub_field = field->members[i];
+      if (end == std::string::npos) {
+        switch (member->type_id_) {
+          case ::rosidl_typesupport_introspection_cpp::ROS_TYPE_MESSAGE:
+          case ::rosidl_typesupport_introspection_cpp::ROS_TYPE_WSTRING:
+            throw std::invalid_argument("field '" + path + "' has an unsupported type");
+          default:
+            break;
+        }
+        if (sub_field) {
+          throw std::invalid_argument("field '" + path + "' is repeated");
+        }
+        sub_field.reset(new FilterField());
+        sub_field->slot = slot;
+        types_[slot] =
+          member->type_id_ == ::rosidl_typesupport_introspection_cpp::ROS_TYPE_STRING ?
+          FilterValue::STRING : FilterValue::NUMBER;
+        break;
+      }
+      if (member->type_id_ != ::rosidl_typesupport_introspection_cpp::ROS_TYPE_MESSAGE) {
+        throw std::invalid_argument("field '" + path + "' has no members");
+      }
+      parent = static_cast<const MembersType *>(member->members_->data);
+      if (!sub_field) {
+        sub_field.reset(new FilterField());
+        sub_field->members.resize(parent->member_count_);
+      }
+      field = sub_field.get();
+      begin = end + 1;
+    }
+  }
+}
+
+}  // namespace rmw_dps_cpp
+
+#endif  // RMW_DPS_CPP__CONTENTFILTER_HPP_
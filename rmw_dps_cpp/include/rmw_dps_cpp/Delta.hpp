@@ -0,0 +1,423 @@
+// Copyright 2018 Intel Corporation All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef RMW_DPS_CPP__DELTA_HPP_
+#define RMW_DPS_CPP__DELTA_HPP_
+
+#include <dps/dps.h>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <vector>
+
+#include "rmw_dps_cpp/CborStream.hpp"
+#include "rmw_dps_cpp/Compression.hpp"
+#include "rmw_dps_cpp/subscription_options.hpp"
+
+namespace rmw_dps_cpp
+{
+
+/// A payload may be published as a delta against the previous payload of its publication.
+/**
+ * Each payload of a delta encoding publication is a frame: a 20 byte header
+ * followed by the body. The header is the magic bytes {0xf7, 'D', 'L', 'T'},
+ * the flags, three zero bytes and the little endian uint32 sequence number
+ * of the frame, sequence number of the frame it is a delta against and size
+ * of the payload. The body of a keyframe is the payload, the body of a delta
+ * is a series of operations, each the bytes of the payload to insert
+ * followed by the bytes of the previous payload to copy: the number of
+ * bytes to insert, the bytes themselves, then the number of bytes to copy
+ * and their offset in the previous payload, numbers being LEB128 encoded.
+ * The body is compressed when the flags say so.
+ */
+const size_t delta_header_size = 20;
+
+/// Acknowledging a frame with this payload requests a keyframe.
+const uint8_t keyframe_request[] = {0xf7, 'K', 'E', 'Y'};
+
+struct DeltaHeader
+{
+  enum Flags
+  {
+    KEYFRAME = 0x01,
+    COMPRESSED = 0x02
+  };
+  uint8_t flags;
+  uint32_t sequence;
+  uint32_t base;
+  uint32_t size;
+};
+
+inline bool
+is_delta_frame(const uint8_t * data, size_t size)
+{
+  return size >= delta_header_size && data[0] == 0xf7 && data[1] == 'D' && data[2] == 'L' &&
+         data[3] == 'T';
+}
+
+inline void
+encode_delta_header(const DeltaHeader & header, uint8_t * data)
+{
+  const uint32_t fields[] = {header.sequence, header.base, header.size};
+  data[0] = 0xf7;
+  data[1] = 'D';
+  data[2] = 'L';
+  data[3] = 'T';
+  data[4] = header.flags;
+  data[5] = data[6] = data[7] = 0;
+  for (size_t i = 0; i < 3; ++i) {
+    for (size_t j = 0; j < 4; ++j) {
+      data[8 + 4 * i + j] = static_cast<uint8_t>(fields[i] >> (8 * j));
+    }
+  }
+}
+
+inline DeltaHeader
+decode_delta_header(const uint8_t * data)
+{
+  uint32_t fields[3] = {};
+  for (size_t i = 0; i < 3; ++i) {
+    for (size_t j = 0; j < 4; ++j) {
+      fields[i] |= static_cast<uint32_t>(data[8 + 4 * i + j]) << (8 * j);
+    }
+  }
+  return DeltaHeader{data[4], fields[0], fields[1], fields[2]};
+}
+
+inline void
+encode_delta_number(std::vector<uint8_t> & delta, size_t n)
+{
+  for (; n >= 0x80; n >>= 7) {
+    delta.push_back(static_cast<uint8_t>(n | 0x80));
+  }
+  delta.push_back(static_cast<uint8_t>(n));
+}
+
+inline bool
+decode_delta_number(const uint8_t * delta, size_t size, size_t & pos, size_t & n)
+{
+  n = 0;
+  for (size_t shift = 0; pos < size && shift < 64; shift += 7) {
+    uint8_t b = delta[pos++];
+    n |= static_cast<size_t>(b & 0x7f) << shift;
+    if (!(b & 0x80)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/// Encode a payload as a delta against base.
+/**
+ * Serialized messages whose values change in place keep their layout, so
+ * bytes are compared at the same offset in both payloads, and from their
+ * ends for what follows a change of size.
+ */
+inline void
+encode_delta(
+  const std::vector<uint8_t> & base, const uint8_t * data, size_t size,
+  std::vector<uint8_t> & delta)
+{
+  // Shorter runs of unchanged bytes cost more to copy than to insert
+  const size_t min_copy_size = 8;
+  size_t suffix = 0;
+  while (suffix < size && suffix < base.size() &&
+    data[size - 1 - suffix] == base[base.size() - 1 - suffix])
+  {
+    ++suffix;
+  }
+  size_t end = size - suffix;
+  size_t base_end = base.size() - suffix;
+  size_t insert = 0;
+  size_t pos = 0;
+  delta.clear();
+  while (pos < end) {
+    size_t copy_size = 0;
+    while (pos + copy_size < end && pos + copy_size < base_end &&
+      data[pos + copy_size] == base[pos + copy_size])
+    {
+      ++copy_size;
+    }
+    if (copy_size < min_copy_size) {
+      pos += copy_size ? copy_size : 1;
+      continue;
+    }
+    encode_delta_number(delta, pos - insert);
+    delta.insert(delta.end(), data + insert, data + pos);
+    encode_delta_number(delta, copy_size);
+    encode_delta_number(delta, pos);
+    pos += copy_size;
+    insert = pos;
+  }
+  encode_delta_number(delta, end - insert);
+  delta.insert(delta.end(), data + insert, data + end);
+  encode_delta_number(delta, suffix);
+  encode_delta_number(delta, base_end);
+}
+
+/// Apply a delta to base, writing the size bytes of the payload.
+/**
+ * \return false if the delta is not valid for base or does not result in size bytes.
+ */
+inline bool
+apply_delta(
+  const std::vector<uint8_t> & base, const uint8_t * delta, size_t delta_size,
+  uint8_t * payload, size_t size)
+{
+  size_t out = 0;
+  size_t pos = 0;
+  while (pos < delta_size) {
+    size_t insert_size;
+    if (!decode_delta_number(delta, delta_size, pos, insert_size) ||
+      insert_size > delta_size - pos || insert_size > size - out)
+    {
+      return false;
+    }
+    if (insert_size) {
+      memcpy(payload + out, delta + pos, insert_size);
+    }
+    out += insert_size;
+    pos += insert_size;
+    size_t copy_size;
+    size_t copy_offset;
+    if (!decode_delta_number(delta, delta_size, pos, copy_size) ||
+      !decode_delta_number(delta, delta_size, pos, copy_offset) ||
+      copy_offset > base.size() || copy_size > base.size() - copy_offset ||
+      copy_size > size - out)
+    {
+      return false;
+    }
+    if (copy_size) {
+      memcpy(payload + out, base.data() + copy_offset, copy_size);
+    }
+    out += copy_size;
+  }
+  return out == size;
+}
+
+/// Encodes the payloads of a publication as keyframes and deltas.
+/**
+ * Every keyframe_interval'th payload is a keyframe, as is any payload
+ * following a keyframe request or whose delta would not be smaller.
+ */
+class DeltaEncoder
+{
+public:
+  explicit DeltaEncoder(size_t keyframe_interval)
+  : keyframe_interval_(keyframe_interval)
+  {
+  }
+
+  /// Request a keyframe when acknowledged with keyframe_request.
+  /**
+   * The data of the publication must be its encoder.
+   */
+  static void
+  onAcknowledgement(DPS_Publication * pub, uint8_t * payload, size_t len)
+  {
+    if (len == sizeof(keyframe_request) && !memcmp(payload, keyframe_request, len)) {
+      reinterpret_cast<DeltaEncoder *>(DPS_GetPublicationData(pub))->keyframe_requested_ = true;
+    }
+  }
+
+  /// Held from encoding a payload until it is published, to publish frames in order.
+  std::mutex &
+  mutex()
+  {
+    return mutex_;
+  }
+
+  /// Encode the next payload.
+  /**
+   * \param[out] delta the body of a delta; the body of a keyframe is the payload itself
+   */
+  DeltaHeader
+  encode(const uint8_t * data, size_t size, std::vector<uint8_t> & delta)
+  {
+    DeltaHeader header = {0, ++sequence_, 0, static_cast<uint32_t>(size)};
+    bool keyframe = sequence_ == 1 || keyframe_requested_.exchange(false) ||
+      ++count_ >= keyframe_interval_;
+    if (!keyframe) {
+      header.base = sequence_ - 1;
+      encode_delta(base_, data, size, delta);
+      keyframe = delta.size() >= size;
+    }
+    if (keyframe) {
+      header.flags = DeltaHeader::KEYFRAME;
+      delta.clear();
+      count_ = 0;
+    }
+    base_.assign(data, data + size);
+    return header;
+  }
+
+private:
+  const size_t keyframe_interval_;
+  std::mutex mutex_;
+  std::atomic<bool> keyframe_requested_{false};
+  uint32_t sequence_ = 0;
+  size_t count_ = 0;
+  std::vector<uint8_t> base_;
+};
+
+/// Reconstructs the payloads of delta encoding publications.
+/**
+ * The last payload of each publication is kept as the base of its next
+ * delta, until the publication has been silent for a minute, or is the
+ * least recently decoded from when the bases of more than max_bases
+ * publications would be kept. A delta whose base was discarded requests a
+ * keyframe.
+ */
+class DeltaDecoder
+{
+public:
+  explicit DeltaDecoder(size_t max_bases = 16)
+  : max_bases_(max_bases ? max_bases : 1)
+  {
+  }
+
+  enum Result
+  {
+    DECODED,
+    /// The base of the delta has not been received, a keyframe should be requested.
+    MISSING_BASE,
+    INVALID
+  };
+
+  /// Decode a frame published by pub.
+  /**
+   * The payload is decoded straight into the buffer it adopts; the
+   * base kept for the next delta is the one copy made of it.
+   * \param[in] max_size payloads larger than this are discarded, zero for
+   *   default_max_payload_size
+   * \param[out] payload the payload when decoded
+   */
+  Result
+  decode(
+    const DPS_Publication * pub, const uint8_t * data, size_t size, size_t max_size,
+    cbor::RxStream & payload)
+  {
+    DeltaHeader header = decode_delta_header(data);
+    if (!max_size) {
+      max_size = default_max_payload_size;
+    }
+    if (header.size > max_size) {
+      return INVALID;
+    }
+    cbor::RxStream body = cbor::RxStream::view(
+      const_cast<uint8_t *>(data) + delta_header_size, size - delta_header_size);
+    if ((header.flags & DeltaHeader::COMPRESSED) &&
+      (!is_compressed(body.getBuffer(), body.getBufferSize()) ||
+      !decompress(body, header.size)))
+    {
+      return INVALID;
+    }
+
+    std::array<uint8_t, sizeof(DPS_UUID)> key;
+    memcpy(key.data(), DPS_PublicationGetUUID(pub), key.size());
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    Clock::time_point now = Clock::now();
+    discardExpired(now);
+    uint8_t * buffer = nullptr;
+    if (header.flags & DeltaHeader::KEYFRAME) {
+      if (body.getBufferSize() != header.size) {
+        return INVALID;
+      }
+      // An uncompressed body is already in a buffer of its own
+      buffer = body.release();
+      if (!buffer) {
+        buffer = static_cast<uint8_t *>(malloc(header.size ? header.size : 1));
+        if (!buffer) {
+          return INVALID;
+        }
+        memcpy(buffer, body.getBuffer(), header.size);
+      }
+    } else {
+      auto it = bases_.find(key);
+      if (it == bases_.end() || it->second.sequence != header.base) {
+        return MISSING_BASE;
+      }
+      buffer = static_cast<uint8_t *>(malloc(header.size ? header.size : 1));
+      if (!buffer) {
+        return INVALID;
+      }
+      if (!apply_delta(it->second.payload, body.getBuffer(), body.getBufferSize(), buffer,
+        header.size))
+      {
+        free(buffer);
+        return INVALID;
+      }
+    }
+    payload = cbor::RxStream::adopt(buffer, header.size);
+    if (bases_.size() >= max_bases_ && bases_.find(key) == bases_.end()) {
+      discardOldest();
+    }
+    Base & base = bases_[key];
+    base.payload.assign(buffer, buffer + header.size);
+    base.sequence = header.sequence;
+    base.last = now;
+    return DECODED;
+  }
+
+private:
+  typedef std::chrono::steady_clock Clock;
+
+  struct Base
+  {
+    std::vector<uint8_t> payload;
+    uint32_t sequence = 0;
+    Clock::time_point last;
+  };
+
+  const size_t max_bases_;
+  std::mutex mutex_;
+  std::map<std::array<uint8_t, sizeof(DPS_UUID)>, Base> bases_;
+
+  void
+  discardExpired(Clock::time_point now)
+  {
+    for (auto it = bases_.begin(); it != bases_.end(); ) {
+      if (now - it->second.last > std::chrono::minutes(1)) {
+        it = bases_.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+
+  void
+  discardOldest()
+  {
+    auto oldest = bases_.begin();
+    for (auto it = bases_.begin(); it != bases_.end(); ++it) {
+      if (it->second.last < oldest->second.last) {
+        oldest = it;
+      }
+    }
+    if (oldest != bases_.end()) {
+      bases_.erase(oldest);
+    }
+  }
+};
+
+}  // namespace rmw_dps_cpp
+
+#endif  // RMW_DPS_CPP__DELTA_HPP_
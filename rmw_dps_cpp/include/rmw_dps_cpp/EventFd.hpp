@@ -0,0 +1,95 @@
+// Copyright 2018 Intel Corporation All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef RMW_DPS_CPP__EVENTFD_HPP_
+#define RMW_DPS_CPP__EVENTFD_HPP_
+
+#ifdef __linux__
+#include <sys/eventfd.h>
+#include <unistd.h>
+#endif
+
+#include <cstdint>
+
+namespace rmw_dps_cpp
+{
+
+/// A file descriptor that is readable while the event is set.
+/**
+ * Lets rmw_wait() and executors poll for the event together with other file
+ * descriptors. Where eventfd() is not available, or fails, fd() is -1 and
+ * setting or clearing the event does nothing, and rmw_wait() waits on a
+ * condition variable instead of polling.
+ */
+class EventFd
+{
+public:
+  EventFd()
+#ifdef __linux__
+  : fd_(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC))
+#endif
+  {
+  }
+
+  ~EventFd()
+  {
+    if (fd_ >= 0) {
+#ifdef __linux__
+      close(fd_);
+#endif
+    }
+  }
+
+  EventFd(const EventFd &) = delete;
+  EventFd & operator=(const EventFd &) = delete;
+
+  int
+  fd() const
+  {
+    return fd_;
+  }
+
+  /// Make the file descriptor readable.
+  void
+  set()
+  {
+#ifdef __linux__
+    if (fd_ >= 0) {
+      uint64_t n = 1;
+      ssize_t ret = write(fd_, &n, sizeof(n));
+      (void)ret;  // Only fails when the counter is already set
+    }
+#endif
+  }
+
+  /// Make the file descriptor unreadable until set again.
+  void
+  clear()
+  {
+#ifdef __linux__
+    if (fd_ >= 0) {
+      uint64_t n;
+      ssize_t ret = read(fd_, &n, sizeof(n));
+      (void)ret;  // Only fails when the counter is not set
+    }
+#endif
+  }
+
+private:
+  int fd_ = -1;
+};
+
+}  // namespace rmw_dps_cpp
+
+#endif  // RMW_DPS_CPP__EVENTFD_HPP_
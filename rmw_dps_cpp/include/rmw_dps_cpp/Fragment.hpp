@@ -0,0 +1,233 @@
+// Copyright 2018 Intel Corporation All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef RMW_DPS_CPP__FRAGMENT_HPP_
+#define RMW_DPS_CPP__FRAGMENT_HPP_
+
+#include <dps/dps.h>
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <utility>
+
+#include "rmw_dps_cpp/CborStream.hpp"
+#include "rmw_dps_cpp/subscription_options.hpp"
+
+namespace rmw_dps_cpp
+{
+
+/// A payload too large for one datagram is published as a series of fragments.
+/**
+ * Each fragment is a 16 byte header followed by a slice of the payload. The
+ * header is the magic bytes {0xf7, 'F', 'R', 'G'}, then the little endian
+ * uint32 message id, payload size and offset of the slice in the payload.
+ * Neither a CBOR nor a CDR payload starts with 0xf7 (the CBOR undefined
+ * value). Message ids are scoped by the UUID of the DPS publication.
+ */
+const size_t fragment_header_size = 16;
+
+struct FragmentHeader
+{
+  uint32_t message_id;
+  uint32_t size;
+  uint32_t offset;
+};
+
+inline bool
+is_fragment(const uint8_t * data, size_t size)
+{
+  return size >= fragment_header_size && data[0] == 0xf7 && data[1] == 'F' && data[2] == 'R' &&
+         data[3] == 'G';
+}
+
+inline void
+encode_fragment_header(const FragmentHeader & header, uint8_t * data)
+{
+  const uint32_t fields[] = {header.message_id, header.size, header.offset};
+  data[0] = 0xf7;
+  data[1] = 'F';
+  data[2] = 'R';
+  data[3] = 'G';
+  for (size_t i = 0; i < 3; ++i) {
+    for (size_t j = 0; j < 4; ++j) {
+      data[4 + 4 * i + j] = static_cast<uint8_t>(fields[i] >> (8 * j));
+    }
+  }
+}
+
+inline FragmentHeader
+decode_fragment_header(const uint8_t * data)
+{
+  uint32_t fields[3] = {};
+  for (size_t i = 0; i < 3; ++i) {
+    for (size_t j = 0; j < 4; ++j) {
+      fields[i] |= static_cast<uint32_t>(data[4 + 4 * i + j]) << (8 * j);
+    }
+  }
+  return FragmentHeader{fields[0], fields[1], fields[2]};
+}
+
+/// Reassembles fragmented payloads.
+/**
+ * The payload is allocated once, when its first fragment arrives and its
+ * size has been checked against the maximum, and each fragment is copied
+ * straight to its offset. Payloads whose fragments stop arriving for longer
+ * than the timeout are discarded, as is the least recently added to when
+ * more than max_messages are being reassembled, so no more than
+ * max_messages times the maximum size is held.
+ */
+class Reassembler
+{
+public:
+  explicit Reassembler(std::chrono::milliseconds timeout, size_t max_messages = 8)
+  : timeout_(timeout), max_messages_(max_messages ? max_messages : 1)
+  {
+  }
+
+  /// Add a fragment published by pub.
+  /**
+   * \param[in] max_size payloads larger than this are discarded, zero for
+   *   default_max_payload_size
+   * \param[out] payload the whole payload when the fragment completes it
+   * \return true if the fragment completes its payload
+   */
+  bool
+  add(
+    const DPS_Publication * pub, const uint8_t * data, size_t size, size_t max_size,
+    cbor::RxStream & payload)
+  {
+    FragmentHeader header = decode_fragment_header(data);
+    data += fragment_header_size;
+    size -= fragment_header_size;
+    if (!max_size) {
+      max_size = default_max_payload_size;
+    }
+    if (header.size > max_size || header.offset > header.size ||
+      size > header.size - header.offset)
+    {
+      return false;
+    }
+
+    Key key;
+    memcpy(key.first.data(), DPS_PublicationGetUUID(pub), key.first.size());
+    key.second = header.message_id;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    Clock::time_point now = Clock::now();
+    discardExpired(now);
+    auto it = messages_.find(key);
+    if (it == messages_.end()) {
+      if (messages_.size() >= max_messages_) {
+        discardOldest();
+      }
+      uint8_t * buffer = static_cast<uint8_t *>(malloc(header.size ? header.size : 1));
+      if (!buffer) {
+        return false;
+      }
+      it = messages_.emplace(key, Message()).first;
+      it->second.data = buffer;
+      it->second.size = header.size;
+    }
+    Message & message = it->second;
+    if (message.size != header.size) {
+      return false;
+    }
+    message.last = now;
+    // A fragment overlapping one already received is a duplicate, or forged
+    const size_t end = header.offset + size;
+    auto next = message.ranges.lower_bound(header.offset);
+    if ((next != message.ranges.end() && next->first < end) ||
+      (next != message.ranges.begin() && std::prev(next)->second > header.offset))
+    {
+      return false;
+    }
+    message.ranges.emplace_hint(next, header.offset, end);
+    memcpy(message.data + header.offset, data, size);
+    message.received += size;
+    if (message.received < message.size) {
+      return false;
+    }
+    payload = cbor::RxStream::adopt(message.data, message.size);
+    message.data = nullptr;
+    messages_.erase(it);
+    return true;
+  }
+
+private:
+  typedef std::chrono::steady_clock Clock;
+  typedef std::pair<std::array<uint8_t, sizeof(DPS_UUID)>, uint32_t> Key;
+
+  struct Message
+  {
+    Message() = default;
+    Message(Message && other)
+    : data(other.data), size(other.size), received(other.received),
+      ranges(std::move(other.ranges)), last(other.last)
+    {
+      other.data = nullptr;
+    }
+    ~Message()
+    {
+      free(data);
+    }
+
+    uint8_t * data = nullptr;
+    size_t size = 0;
+    size_t received = 0;
+    /// The offset and end of each fragment received.
+    std::map<size_t, size_t> ranges;
+    Clock::time_point last;
+  };
+
+  const std::chrono::milliseconds timeout_;
+  const size_t max_messages_;
+  std::mutex mutex_;
+  std::map<Key, Message> messages_;
+
+  void
+  discardExpired(Clock::time_point now)
+  {
+    for (auto it = messages_.begin(); it != messages_.end(); ) {
+      if (now - it->second.last > timeout_) {
+        it = messages_.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+
+  void
+  discardOldest()
+  {
+    auto oldest = messages_.begin();
+    for (auto it = messages_.begin(); it != messages_.end(); ++it) {
+      if (it->second.last < oldest->second.last) {
+        oldest = it;
+      }
+    }
+    if (oldest != messages_.end()) {
+      messages_.erase(oldest);
+    }
+  }
+};
+
+}  // namespace rmw_dps_cpp
+
+#endif  // RMW_DPS_CPP__FRAGMENT_HPP_
@@ -17,7 +17,9 @@
 
 #include <dps/dps.h>
 
+#include <algorithm>
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <memory>
 #include <mutex>
@@ -26,6 +28,14 @@
 #include <vector>
 
 #include "rmw_dps_cpp/CborStream.hpp"
+#include "rmw_dps_cpp/Compression.hpp"
+#include "rmw_dps_cpp/ContentFilter.hpp"
+#include "rmw_dps_cpp/Delta.hpp"
+#include "rmw_dps_cpp/EventFd.hpp"
+#include "rmw_dps_cpp/Fragment.hpp"
+#include "rmw_dps_cpp/WaitConditions.hpp"
+#include "rmw_dps_cpp/subscription_options.hpp"
+#include "rmw_dps_cpp/tracing.hpp"
 
 struct PublicationDeleter
 {
@@ -39,8 +49,12 @@ class Listener
 public:
   using Data = std::pair<Publication, rmw_dps_cpp::cbor::RxStream>;
 
-  Listener()
-  : conditionMutex_(nullptr), conditionVariable_(nullptr)
+  explicit Listener(
+    size_t maxPayloadSize = 0, size_t maxSequenceSize = 0,
+    std::chrono::milliseconds fragmentTimeout = std::chrono::milliseconds(1000))
+  : maxPayloadSize_(maxPayloadSize ? maxPayloadSize : rmw_dps_cpp::default_max_payload_size),
+    maxSequenceSize_(maxSequenceSize),
+    reassembler_(fragmentTimeout)
   {
   }
 
@@ -56,20 +70,75 @@ public:
       DPS_PublicationGetSequenceNum(pub));
 
     Listener * listener = reinterpret_cast<Listener *>(DPS_GetSubscriptionData(sub));
+    RMW_DPS_TRACEPOINT(on_publication, listener, rmw_dps_cpp::trace_uuid(pub),
+      DPS_PublicationGetSequenceNum(pub), len);
+    // Holds the payload once reassembled, decoded or uncompressed
+    rmw_dps_cpp::cbor::RxStream buffer;
+    bool buffered = false;
+    if (rmw_dps_cpp::is_fragment(payload, len)) {
+      if (!listener->reassembler_.add(pub, payload, len, listener->maxPayloadSize_, buffer)) {
+        return;  // Incomplete, or dropped
+      }
+      payload = buffer.getBuffer();
+      len = buffer.getBufferSize();
+      buffered = true;
+    } else if (len > listener->maxPayloadSize_) {
+      RCUTILS_LOG_DEBUG_NAMED(
+        "rmw_dps_cpp",
+        "  dropping publication, payload exceeds %zu bytes", listener->maxPayloadSize_);
+      return;
+    }
+    if (rmw_dps_cpp::is_delta_frame(payload, len)) {
+      // Frames are decoded as they arrive, each being the base of the next
+      switch (listener->deltaDecoder_.decode(pub, payload, len, listener->maxPayloadSize_,
+        buffer))
+      {
+        case rmw_dps_cpp::DeltaDecoder::DECODED:
+          break;
+        case rmw_dps_cpp::DeltaDecoder::MISSING_BASE:
+          RCUTILS_LOG_DEBUG_NAMED("rmw_dps_cpp", "  dropping publication, requesting keyframe");
+          DPS_AckPublication(pub, rmw_dps_cpp::keyframe_request,
+            sizeof(rmw_dps_cpp::keyframe_request));
+          return;
+        default:
+          RCUTILS_LOG_DEBUG_NAMED("rmw_dps_cpp", "  dropping publication, invalid delta");
+          return;
+      }
+      payload = buffer.getBuffer();
+      len = buffer.getBufferSize();
+      buffered = true;
+    } else if (rmw_dps_cpp::is_compressed(payload, len)) {
+      if (rmw_dps_cpp::get_uncompressed_size(payload) > listener->maxPayloadSize_) {
+        RCUTILS_LOG_DEBUG_NAMED(
+          "rmw_dps_cpp",
+          "  dropping publication, uncompressed payload exceeds %zu bytes",
+          listener->maxPayloadSize_);
+        return;
+      }
+      // The filter reads the uncompressed payload, otherwise it is uncompressed when taken
+      if (listener->filter_) {
+        if (!buffered) {
+          buffer = rmw_dps_cpp::cbor::RxStream::view(payload, len);
+        }
+        if (!rmw_dps_cpp::decompress(buffer, listener->maxPayloadSize_)) {
+          RCUTILS_LOG_DEBUG_NAMED("rmw_dps_cpp", "  dropping publication, cannot uncompress");
+          return;
+        }
+        payload = buffer.getBuffer();
+        len = buffer.getBufferSize();
+        buffered = true;
+      }
+    }
+    if (listener->filter_ && !listener->filter_->matches(payload, len)) {
+      RCUTILS_LOG_DEBUG_NAMED("rmw_dps_cpp", "  dropping publication, filtered");
+      return;
+    }
     Data data = std::make_pair(Publication(DPS_CopyPublication(pub)),
-        rmw_dps_cpp::cbor::RxStream(payload, len));
-    std::lock_guard<std::mutex> lock(listener->internalMutex_);
-
-    if (listener->conditionMutex_) {
-      std::unique_lock<std::mutex> clock(*listener->conditionMutex_);
-      // the change to data_ needs to be mutually exclusive with rmw_wait()
-      // which checks hasData() and decides if wait() needs to be called
-      listener->data_.push(std::move(data));
-      clock.unlock();
-      listener->conditionVariable_->notify_one();
-    } else {
-      listener->data_.push(std::move(data));
+        buffered ? std::move(buffer) : rmw_dps_cpp::cbor::RxStream(payload, len));
+    if (listener->maxSequenceSize_) {
+      data.second.setMaxSequenceSize(listener->maxSequenceSize_);
     }
+    listener->push(std::move(data));
   }
 
   static void
@@ -86,40 +155,49 @@ public:
     Listener * listener = reinterpret_cast<Listener *>(DPS_GetPublicationData(pub));
     Data data = std::make_pair(Publication(DPS_CopyPublication(pub)),
         rmw_dps_cpp::cbor::RxStream(payload, len));
-    std::lock_guard<std::mutex> lock(listener->internalMutex_);
-
-    if (listener->conditionMutex_) {
-      std::unique_lock<std::mutex> clock(*listener->conditionMutex_);
-      // the change to data_ needs to be mutually exclusive with rmw_wait()
-      // which checks hasData() and decides if wait() needs to be called
-      listener->data_.push(std::move(data));
-      clock.unlock();
-      listener->conditionVariable_->notify_one();
-    } else {
-      listener->data_.push(std::move(data));
-    }
+    listener->push(std::move(data));
+  }
+
+  /// Drop publications not matching filter, must be set before subscribing.
+  void
+  setContentFilter(std::unique_ptr<rmw_dps_cpp::ContentFilter> filter)
+  {
+    filter_ = std::move(filter);
   }
 
   void
   attachCondition(std::mutex * conditionMutex, std::condition_variable * conditionVariable)
   {
     std::lock_guard<std::mutex> lock(internalMutex_);
-    conditionMutex_ = conditionMutex;
-    conditionVariable_ = conditionVariable;
+    conditions_.attach(conditionMutex, conditionVariable);
   }
 
   void
-  detachCondition()
+  detachCondition(std::mutex * conditionMutex, std::condition_variable * conditionVariable)
   {
     std::lock_guard<std::mutex> lock(internalMutex_);
-    conditionMutex_ = nullptr;
-    conditionVariable_ = nullptr;
+    conditions_.detach(conditionMutex, conditionVariable);
+  }
+
+  /// The largest payload accepted, once reassembled, decoded or uncompressed.
+  size_t
+  maxPayloadSize() const
+  {
+    return maxPayloadSize_;
   }
 
+  /// Cheap enough for rmw_wait() to spin on.
   bool
   hasData()
   {
-    return data_.size() > 0;
+    return size_ > 0;
+  }
+
+  /// A file descriptor readable while hasData(), or -1 if not supported.
+  int
+  fd() const
+  {
+    return event_.fd();
   }
 
   bool
@@ -133,14 +211,58 @@ public:
     pub = std::move(data.first);
     buffer = std::move(data.second);
     data_.pop();
+    size_ = data_.size();
+    if (data_.empty()) {
+      event_.clear();
+    }
     return true;
   }
 
+  /// Move up to count queued publications to the end of data under a single lock.
+  size_t
+  takeData(std::vector<Data> & data, size_t count)
+  {
+    std::lock_guard<std::mutex> lock(internalMutex_);
+    size_t n = std::min(count, data_.size());
+    for (size_t i = 0; i < n; ++i) {
+      data.push_back(std::move(data_.front()));
+      data_.pop();
+    }
+    size_ = data_.size();
+    if (n && data_.empty()) {
+      event_.clear();
+    }
+    return n;
+  }
+
 private:
+  void
+  push(Data && data)
+  {
+    std::lock_guard<std::mutex> lock(internalMutex_);
+    bool wasEmpty = data_.empty();
+    data_.push(std::move(data));
+    size_ = data_.size();
+    RMW_DPS_TRACEPOINT(enqueue, this, rmw_dps_cpp::trace_uuid(data_.back().first.get()),
+      DPS_PublicationGetSequenceNum(data_.back().first.get()), data_.size());
+    // Waiters only wait while hasData() is false
+    if (wasEmpty) {
+      conditions_.notify();
+      event_.set();
+    }
+  }
+
   std::mutex internalMutex_;
   std::queue<Data> data_;
-  std::mutex * conditionMutex_;
-  std::condition_variable * conditionVariable_;
+  // The size of data_, read without the lock
+  std::atomic<size_t> size_{0};
+  rmw_dps_cpp::WaitConditions conditions_;
+  const size_t maxPayloadSize_;
+  const size_t maxSequenceSize_;
+  std::unique_ptr<rmw_dps_cpp::ContentFilter> filter_;
+  rmw_dps_cpp::Reassembler reassembler_;
+  rmw_dps_cpp::DeltaDecoder deltaDecoder_;
+  rmw_dps_cpp::EventFd event_;
 };
 
 #endif  // RMW_DPS_CPP__LISTENER_HPP_
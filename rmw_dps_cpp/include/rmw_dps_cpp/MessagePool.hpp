@@ -0,0 +1,127 @@
+// Copyright 2018 Intel Corporation All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef RMW_DPS_CPP__MESSAGEPOOL_HPP_
+#define RMW_DPS_CPP__MESSAGEPOOL_HPP_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace rmw_dps_cpp
+{
+
+/// A fixed number of preconstructed ROS messages lent out and given back.
+/**
+ * Messages are constructed once when the pool is created and destroyed with
+ * the pool. A message given back keeps its contents, and the memory its
+ * strings and sequences hold, for the next borrower.
+ */
+class MessagePool
+{
+public:
+  typedef std::function<void (void *)> Function;
+
+  /// Construct capacity messages of size bytes with init, to be destroyed with fini.
+  MessagePool(size_t size, size_t capacity, Function init, Function fini)
+  : stride_(std::max<size_t>(1, (size + sizeof(std::max_align_t) - 1) / sizeof(std::max_align_t))),
+    storage_(stride_ * capacity), fini_(fini)
+  {
+    free_.reserve(capacity);
+    try {
+      for (size_t i = 0; i < capacity; ++i) {
+        void * message = &storage_[i * stride_];
+        init(message);
+        free_.push_back(message);
+      }
+    } catch (...) {
+      for (void * message : free_) {
+        fini_(message);
+      }
+      throw;
+    }
+    capacity_ = capacity;
+  }
+
+  ~MessagePool()
+  {
+    // Messages still lent out are destroyed too, borrowers must not outlive the pool.
+    for (size_t i = 0; i < capacity_; ++i) {
+      fini_(&storage_[i * stride_]);
+    }
+  }
+
+  MessagePool(const MessagePool &) = delete;
+  MessagePool & operator=(const MessagePool &) = delete;
+
+  /// Return a message, or null if all are lent out.
+  void *
+  borrow()
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (free_.empty()) {
+      return nullptr;
+    }
+    void * message = free_.back();
+    free_.pop_back();
+    return message;
+  }
+
+  /// Give back a borrowed message.
+  /**
+   * \return false if the message was not borrowed from this pool.
+   */
+  bool
+  giveBack(void * message)
+  {
+    if (!owns(message)) {
+      return false;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (void * free_message : free_) {
+      if (free_message == message) {
+        return false;
+      }
+    }
+    free_.push_back(message);
+    return true;
+  }
+
+  /// Return true if the message is one of the messages of this pool.
+  bool
+  owns(const void * message) const
+  {
+    auto begin = reinterpret_cast<uintptr_t>(storage_.data());
+    auto address = reinterpret_cast<uintptr_t>(message);
+    size_t stride = stride_ * sizeof(std::max_align_t);
+    return address >= begin && address - begin < capacity_ * stride &&
+           (address - begin) % stride == 0;
+  }
+
+private:
+  const size_t stride_;
+  std::vector<std::max_align_t> storage_;
+  Function fini_;
+  size_t capacity_ = 0;
+  std::mutex mutex_;
+  std::vector<void *> free_;
+};
+
+}  // namespace rmw_dps_cpp
+
+#endif  // RMW_DPS_CPP__MESSAGEPOOL_HPP_
@@ -0,0 +1,108 @@
+// Copyright 2018 Intel Corporation All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef RMW_DPS_CPP__PACER_HPP_
+#define RMW_DPS_CPP__PACER_HPP_
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+#include "rmw_dps_cpp/pacing_statistics.hpp"
+
+namespace rmw_dps_cpp
+{
+
+/// A token bucket limiting the rate at which bytes are sent.
+/**
+ * Tokens accumulate at the target rate up to the burst size and each byte
+ * sent takes one. A sender waits for enough tokens, in order of arrival, so
+ * a burst of publications leaves at the target rate instead of overflowing
+ * the socket buffers of the receivers.
+ */
+class Pacer
+{
+public:
+  /// Pace to rate bytes per second, with bursts of up to burst bytes.
+  Pacer(uint64_t rate, size_t burst)
+  : rate_(static_cast<double>(rate)), burst_(static_cast<double>(std::max<size_t>(1, burst))),
+    tokens_(burst_), last_(Clock::now())
+  {
+  }
+
+  /// Wait until size bytes may be sent.
+  /**
+   * A send larger than the burst size waits for a full bucket and leaves a
+   * debt that the following sends wait for.
+   */
+  void
+  acquire(size_t size)
+  {
+    queued_bytes_ += size;
+    std::lock_guard<std::mutex> lock(mutex_);
+    refill();
+    double needed = std::min(static_cast<double>(size), burst_);
+    if (tokens_ < needed) {
+      std::chrono::nanoseconds delay(static_cast<int64_t>((needed - tokens_) / rate_ * 1e9));
+      delayed_bytes_ += size;
+      delay_ns_ += delay.count();
+      std::this_thread::sleep_for(delay);
+      refill();
+    }
+    tokens_ -= size;
+    queued_bytes_ -= size;
+    sent_bytes_ += size;
+  }
+
+  PacingStatistics
+  statistics() const
+  {
+    PacingStatistics statistics;
+    statistics.queued_bytes = queued_bytes_;
+    statistics.sent_bytes = sent_bytes_;
+    statistics.delayed_bytes = delayed_bytes_;
+    statistics.delay_ns = delay_ns_;
+    return statistics;
+  }
+
+private:
+  typedef std::chrono::steady_clock Clock;
+
+  const double rate_;
+  const double burst_;
+  std::mutex mutex_;
+  double tokens_;
+  Clock::time_point last_;
+  std::atomic<uint64_t> queued_bytes_{0};
+  std::atomic<uint64_t> sent_bytes_{0};
+  std::atomic<uint64_t> delayed_bytes_{0};
+  std::atomic<uint64_t> delay_ns_{0};
+
+  void
+  refill()
+  {
+    Clock::time_point now = Clock::now();
+    std::chrono::duration<double> elapsed = now - last_;
+    last_ = now;
+    tokens_ = std::min(burst_, tokens_ + elapsed.count() * rate_);
+  }
+};
+
+}  // namespace rmw_dps_cpp
+
+#endif  // RMW_DPS_CPP__PACER_HPP_
@@ -0,0 +1,116 @@
+// Copyright 2018 Intel Corporation All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef RMW_DPS_CPP__PROJECTION_HPP_
+#define RMW_DPS_CPP__PROJECTION_HPP_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "rosidl_typesupport_introspection_cpp/field_types.hpp"
+
+namespace rmw_dps_cpp
+{
+
+/// The members of a message selected for deserialization.
+/**
+ * Members that are not selected are skipped on the wire without being
+ * decoded and are left untouched in the ROS message.
+ */
+struct Projection
+{
+  /// Indexed by member; a null entry is skipped, no entries selects every member.
+  std::vector<std::unique_ptr<Projection>> members;
+
+  bool
+  selects_all() const
+  {
+    return members.empty();
+  }
+
+  /// Return the projection of a member, or null if the member is skipped.
+  const Projection *
+  member(uint32_t index) const
+  {
+    return selects_all() ? this : members[index].get();
+  }
+};
+
+/// Add a '.' separated member path, e.g. "header.stamp", to a projection.
+/**
+ * Descending into a sequence of messages selects the member in each element.
+ * \return false if the path does not name a member of the message.
+ */
+template<typename MembersType>
+bool
+add_projection_path(
+  const MembersType * members, const std::string & path, Projection & projection)
+{
+  size_t pos = path.find('.');
+  std::string name = path.substr(0, pos);
+  for (uint32_t i = 0; i < members->member_count_; ++i) {
+    const auto member = members->members_ + i;
+    if (name != member->name_) {
+      continue;
+    }
+    std::unique_ptr<Projection> & sub_projection = projection.members[i];
+    if (pos == std::string::npos) {
+      // The whole member, overriding any narrower selection.
+      sub_projection.reset(new Projection());
+      return true;
+    }
+    if (member->type_id_ != ::rosidl_typesupport_introspection_cpp::ROS_TYPE_MESSAGE) {
+      return false;
+    }
+    auto sub_members = static_cast<const MembersType *>(member->members_->data);
+    if (!sub_projection) {
+      sub_projection.reset(new Projection());
+      sub_projection->members.resize(sub_members->member_count_);
+    } else if (sub_projection->selects_all()) {
+      return true;
+    }
+    return add_projection_path(sub_members, path.substr(pos + 1), *sub_projection);
+  }
+  return false;
+}
+
+/// Create a projection from a ',' separated list of member paths.
+/**
+ * \return null if any path does not name a member of the message.
+ */
+template<typename MembersType>
+std::unique_ptr<Projection>
+create_projection(const MembersType * members, const std::string & paths)
+{
+  std::unique_ptr<Projection> projection(new Projection());
+  projection->members.resize(members->member_count_);
+  size_t pos = 0;
+  while (pos != std::string::npos) {
+    size_t end_pos = paths.find(',', pos);
+    std::string path = paths.substr(pos, end_pos == std::string::npos ? end_pos : end_pos - pos);
+    pos = end_pos == std::string::npos ? end_pos : end_pos + 1;
+    if (path.empty()) {
+      continue;
+    }
+    if (!add_projection_path(members, path, *projection)) {
+      return nullptr;
+    }
+  }
+  return projection;
+}
+
+}  // namespace rmw_dps_cpp
+
+#endif  // RMW_DPS_CPP__PROJECTION_HPP_
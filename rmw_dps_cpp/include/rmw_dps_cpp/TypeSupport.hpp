@@ -38,6 +38,10 @@
 #include "rosidl_typesupport_introspection_c/visibility_control.h"
 
 #include "CborStream.hpp"
+#include "CdrStream.hpp"
+#include "ContentFilter.hpp"
+#include "MessagePool.hpp"
+#include "Projection.hpp"
 
 namespace rmw_dps_cpp
 {
@@ -75,7 +79,8 @@ struct StringHelper<rosidl_typesupport_introspection_c__MessageMembers>
     return std::string(data.data);
   }
 
-  static void assign(cbor::RxStream & deser, void * field, bool)
+  template<typename Stream>
+  static void assign(Stream & deser, void * field, bool)
   {
     std::string str;
     deser >> str;
@@ -95,7 +100,8 @@ struct StringHelper<rosidl_typesupport_introspection_cpp::MessageMembers>
     return *(static_cast<std::string *>(data));
   }
 
-  static void assign(cbor::RxStream & deser, void * field, bool call_new)
+  template<typename Stream>
+  static void assign(Stream & deser, void * field, bool call_new)
   {
     std::string & str = *(std::string *)field;
     if (call_new) {
@@ -138,7 +144,8 @@ struct U16StringHelper<rosidl_typesupport_introspection_c__MessageMembers>
     return std::u16string(reinterpret_cast<char16_t *>(data.data));
   }
 
-  static void assign(cbor::RxStream & deser, void * field, bool)
+  template<typename Stream>
+  static void assign(Stream & deser, void * field, bool)
   {
     std::u16string str;
     deser >> str;
@@ -158,7 +165,8 @@ struct U16StringHelper<rosidl_typesupport_introspection_cpp::MessageMembers>
     return *(static_cast<std::u16string *>(data));
   }
 
-  static void assign(cbor::RxStream & deser, void * field, bool call_new)
+  template<typename Stream>
+  static void assign(Stream & deser, void * field, bool call_new)
   {
     std::u16string & str = *(std::u16string *)field;
     if (call_new) {
@@ -168,13 +176,77 @@ struct U16StringHelper<rosidl_typesupport_introspection_cpp::MessageMembers>
   }
 };
 
+// Helper class that uses template specialization to construct and destroy messages
+template<typename MembersType>
+struct MessageHelper;
+
+template<>
+struct MessageHelper<rosidl_typesupport_introspection_c__MessageMembers>
+{
+  static void init(const rosidl_typesupport_introspection_c__MessageMembers * members, void * msg)
+  {
+    members->init_function(msg, ROSIDL_RUNTIME_C_MSG_INIT_ALL);
+  }
+};
+
+template<>
+struct MessageHelper<rosidl_typesupport_introspection_cpp::MessageMembers>
+{
+  static void init(const rosidl_typesupport_introspection_cpp::MessageMembers * members, void * msg)
+  {
+    members->init_function(msg, rosidl_generator_cpp::MessageInitialization::ALL);
+  }
+};
+
 template<typename MembersType>
 class TypeSupport
 {
 public:
-  bool serializeROSmessage(const void * ros_message, cbor::TxStream & ser);
+  template<typename Stream>
+  bool serializeROSmessage(const void * ros_message, Stream & ser);
 
-  bool deserializeROSmessage(cbor::RxStream & data, void * ros_message);
+  /// Deserialize only the members selected by projection, or all if it is null.
+  template<typename Stream>
+  bool deserializeROSmessage(
+    Stream & data, void * ros_message, const Projection * projection = nullptr);
+
+  /// Create a projection from a ',' separated list of member paths.
+  std::unique_ptr<Projection> createProjection(const std::string & paths) const
+  {
+    return create_projection(members_, paths);
+  }
+
+  /// Create a pool of capacity messages of this type.
+  /**
+   * \throw std::bad_alloc if the messages cannot be constructed.
+   */
+  std::unique_ptr<MessagePool> createMessagePool(size_t capacity) const
+  {
+    const MembersType * members = members_;
+    return std::unique_ptr<MessagePool>(
+      new MessagePool(
+        members->size_of_, capacity,
+        [members](void * msg) {MessageHelper<MembersType>::init(members, msg);},
+        [members](void * msg) {members->fini_function(msg);}));
+  }
+
+  /// Create a reader of the values of fields of this message type.
+  /**
+   * \throw std::invalid_argument if a field is not a member of the message.
+   */
+  std::unique_ptr<FieldReader> createFieldReader(const std::vector<std::string> & fields) const;
+
+  /// Create a filter over the fields of this message type.
+  /**
+   * \throw std::invalid_argument if the expression is invalid for the message.
+   */
+  std::unique_ptr<ContentFilter> createContentFilter(
+    const std::string & expression, const std::vector<std::string> & parameters) const;
+
+  /// Read the values of the fields of a field reader from a serialized message.
+  template<typename Stream>
+  void readFilterFields(
+    Stream & deser, const FilterField & fields, std::vector<FilterValue> & values) const;
 
 protected:
   explicit TypeSupport(const MembersType * members);
@@ -182,12 +254,25 @@ protected:
   const MembersType * members_;
 
 private:
+  template<typename Stream>
   bool serializeROSmessage(
-    cbor::TxStream & ser, const MembersType * members, const void * ros_message);
+    Stream & ser, const MembersType * members, const void * ros_message);
 
+  template<typename Stream>
   bool deserializeROSmessage(
-    cbor::RxStream & deser, const MembersType * members, void * ros_message,
-    bool call_new);
+    Stream & deser, const MembersType * members, void * ros_message,
+    bool call_new, const Projection * projection);
+
+  template<typename Stream>
+  void skipROSmessage(Stream & deser, const MembersType * members) const;
+
+  template<typename Stream, typename MemberType>
+  void skipMember(Stream & deser, const MemberType * member) const;
+
+  template<typename Stream>
+  void readFilterFields(
+    Stream & deser, const MembersType * members, const FilterField & fields,
+    std::vector<FilterValue> & values, size_t & remaining) const;
 };
 
 }  // namespace rmw_dps_cpp
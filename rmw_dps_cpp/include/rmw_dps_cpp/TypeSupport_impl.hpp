@@ -17,6 +17,7 @@
 
 #include <stdexcept>
 #include <string>
+#include <type_traits>
 #include <vector>
 
 #include "rmw_dps_cpp/macros.hpp"
@@ -102,17 +103,22 @@ TypeSupport<MembersType>::TypeSupport(const MembersType * members)
   this->members_ = members;
 }
 
-// C++ specialization
 template<typename T>
+struct is_string : std::integral_constant<bool,
+    std::is_same<T, std::string>::value || std::is_same<T, std::u16string>::value>
+{};
+
+// C++ specialization
+template<typename T, typename Stream>
 void serialize_field(
   const rosidl_typesupport_introspection_cpp::MessageMember * member,
   void * field,
-  cbor::TxStream & ser)
+  Stream & ser)
 {
   if (!member->is_array_) {
     ser << *static_cast<T *>(field);
   } else if (member->array_size_ && !member->is_upper_bound_) {
-    ser.serializeSequence(static_cast<T *>(field), member->array_size_);
+    ser.serializeArray(static_cast<T *>(field), member->array_size_);
   } else {
     std::vector<T> & data = *reinterpret_cast<std::vector<T> *>(field);
     ser << data;
@@ -120,28 +126,29 @@ void serialize_field(
 }
 
 // C specialization
-template<typename T>
-void serialize_field(
+template<typename T, typename Stream>
+typename std::enable_if<!is_string<T>::value>::type
+serialize_field(
   const rosidl_typesupport_introspection_c__MessageMember * member,
   void * field,
-  cbor::TxStream & ser)
+  Stream & ser)
 {
   if (!member->is_array_) {
     ser << *static_cast<T *>(field);
   } else if (member->array_size_ && !member->is_upper_bound_) {
-    ser.serializeSequence(static_cast<T *>(field), member->array_size_);
+    ser.serializeArray(static_cast<T *>(field), member->array_size_);
   } else {
     auto & data = *reinterpret_cast<typename GenericCSequence<T>::type *>(field);
     ser.serializeSequence(reinterpret_cast<T *>(data.data), data.size);
   }
 }
 
-template<>
-inline
-void serialize_field<std::string>(
+template<typename T, typename Stream>
+typename std::enable_if<std::is_same<T, std::string>::value>::type
+serialize_field(
   const rosidl_typesupport_introspection_c__MessageMember * member,
   void * field,
-  cbor::TxStream & ser)
+  Stream & ser)
 {
   using CStringHelper = StringHelper<rosidl_typesupport_introspection_c__MessageMembers>;
   if (!member->is_array_) {
@@ -161,6 +168,7 @@ void serialize_field<std::string>(
         cpp_string_vector.push_back(
           CStringHelper::convert_to_std_string(string_field[i]));
       }
+      ser.serializeArray(cpp_string_vector.data(), cpp_string_vector.size());
     } else {
       auto & string_sequence_field =
         *reinterpret_cast<rosidl_generator_c__String__Sequence *>(field);
@@ -168,17 +176,17 @@ void serialize_field<std::string>(
         cpp_string_vector.push_back(
           CStringHelper::convert_to_std_string(string_sequence_field.data[i]));
       }
+      ser << cpp_string_vector;
     }
-    ser << cpp_string_vector;
   }
 }
 
-template<>
-inline
-void serialize_field<std::u16string>(
+template<typename T, typename Stream>
+typename std::enable_if<std::is_same<T, std::u16string>::value>::type
+serialize_field(
   const rosidl_typesupport_introspection_c__MessageMember * member,
   void * field,
-  cbor::TxStream & ser)
+  Stream & ser)
 {
   using CU16StringHelper = U16StringHelper<rosidl_typesupport_introspection_c__MessageMembers>;
   if (!member->is_array_) {
@@ -198,6 +206,7 @@ void serialize_field<std::u16string>(
         cpp_u16string_vector.push_back(
           CU16StringHelper::convert_to_std_u16string(u16string_field[i]));
       }
+      ser.serializeArray(cpp_u16string_vector.data(), cpp_u16string_vector.size());
     } else {
       auto & u16string_sequence_field =
         *reinterpret_cast<rosidl_generator_c__U16String__Sequence *>(field);
@@ -205,15 +214,15 @@ void serialize_field<std::u16string>(
         cpp_u16string_vector.push_back(
           CU16StringHelper::convert_to_std_u16string(u16string_sequence_field.data[i]));
       }
+      ser << cpp_u16string_vector;
     }
-    ser << cpp_u16string_vector;
   }
 }
 
-inline
+template<typename Stream>
 size_t get_submessage_sequence_serialize(
   const rosidl_typesupport_introspection_cpp::MessageMember * member,
-  cbor::TxStream & ser,
+  Stream & ser,
   void * & field,
   void * & subros_message)
 {
@@ -232,10 +241,10 @@ size_t get_submessage_sequence_serialize(
   }
 }
 
-inline
+template<typename Stream>
 size_t get_submessage_sequence_serialize(
   const rosidl_typesupport_introspection_c__MessageMember * member,
-  cbor::TxStream & ser,
+  Stream & ser,
   void * & field,
   void * & subros_message)
 {
@@ -255,13 +264,14 @@ size_t get_submessage_sequence_serialize(
 }
 
 template<typename MembersType>
+template<typename Stream>
 bool TypeSupport<MembersType>::serializeROSmessage(
-  cbor::TxStream & ser, const MembersType * members, const void * ros_message)
+  Stream & ser, const MembersType * members, const void * ros_message)
 {
   assert(ros_message);
   assert(members);
 
-  ser.serializeSequence(members->member_count_);
+  ser.serializeStructHeader(members->member_count_);
 
   for (uint32_t i = 0; i < members->member_count_; ++i) {
     const auto member = members->members_ + i;
@@ -340,39 +350,99 @@ bool TypeSupport<MembersType>::serializeROSmessage(
   return true;
 }
 
-template<typename T>
+// The bounds declared in the message definition are checked against the
+// length on the wire before anything is allocated for the field.
+template<typename MemberType, typename Stream, typename T>
+inline
+void check_string_bound(const MemberType *, Stream &, const T *)
+{
+}
+
+template<typename MemberType, typename Stream>
+inline
+void check_string_bound(const MemberType * member, Stream & deser, const std::string *)
+{
+  if (member->string_upper_bound_) {
+    size_t size = 0;
+    deser.deserializeStringSize(&size);
+    if (size > member->string_upper_bound_) {
+      throw std::runtime_error("string overcomes the maximum length");
+    }
+  }
+}
+
+template<typename MemberType, typename Stream>
+inline
+void check_string_bound(const MemberType * member, Stream & deser, const std::u16string *)
+{
+  if (member->string_upper_bound_) {
+    size_t size = 0;
+    deser.deserializeSequenceSize(&size);
+    if (size > member->string_upper_bound_) {
+      throw std::runtime_error("string overcomes the maximum length");
+    }
+  }
+}
+
+template<typename MemberType, typename Stream>
+inline
+void check_sequence_bound(const MemberType * member, Stream & deser)
+{
+  if (member->is_upper_bound_) {
+    size_t size = 0;
+    deser.deserializeSequenceSize(&size);
+    if (size > member->array_size_) {
+      throw std::runtime_error("sequence overcomes the maximum length");
+    }
+  }
+}
+
+template<typename MemberType>
+inline
+void check_sequence_length(const MemberType * member, size_t size)
+{
+  if (member->is_upper_bound_ && size > member->array_size_) {
+    throw std::runtime_error("sequence overcomes the maximum length");
+  }
+}
+
+template<typename T, typename Stream>
 void deserialize_field(
   const rosidl_typesupport_introspection_cpp::MessageMember * member,
   void * field,
-  cbor::RxStream & deser,
+  Stream & deser,
   bool)
 {
   if (!member->is_array_) {
+    check_string_bound(member, deser, static_cast<T *>(nullptr));
     deser >> *static_cast<T *>(field);
   } else if (member->array_size_ && !member->is_upper_bound_) {
-    deser.deserializeSequence(static_cast<T *>(field), member->array_size_);
+    deser.deserializeArray(static_cast<T *>(field), member->array_size_);
   } else {
-    auto & vector = *reinterpret_cast<std::vector<T> *>(field);
-    new(&vector) std::vector<T>;
-    deser >> vector;
+    check_sequence_bound(member, deser);
+    // The message is constructed, possibly by a previous take, so assign over its contents.
+    deser >> *reinterpret_cast<std::vector<T> *>(field);
   }
 }
 
-template<typename T>
-void deserialize_field(
+template<typename T, typename Stream>
+typename std::enable_if<!is_string<T>::value>::type
+deserialize_field(
   const rosidl_typesupport_introspection_c__MessageMember * member,
   void * field,
-  cbor::RxStream & deser,
+  Stream & deser,
   bool)
 {
   if (!member->is_array_) {
     deser >> *static_cast<T *>(field);
   } else if (member->array_size_ && !member->is_upper_bound_) {
-    deser.deserializeSequence(static_cast<T *>(field), member->array_size_);
+    deser.deserializeArray(static_cast<T *>(field), member->array_size_);
   } else {
     auto & data = *reinterpret_cast<typename GenericCSequence<T>::type *>(field);
     size_t dsize = 0;
     deser.deserializeSequenceSize(&dsize);
+    check_sequence_length(member, dsize);
+    GenericCSequence<T>::fini(&data);
     if (!GenericCSequence<T>::init(&data, dsize)) {
       throw std::runtime_error("unable to initialize GenericCSequence");
     }
@@ -380,20 +450,27 @@ void deserialize_field(
   }
 }
 
-template<>
-inline
-void deserialize_field<std::string>(
+template<typename T, typename Stream>
+typename std::enable_if<std::is_same<T, std::string>::value>::type
+deserialize_field(
   const rosidl_typesupport_introspection_c__MessageMember * member,
   void * field,
-  cbor::RxStream & deser,
+  Stream & deser,
   bool call_new)
 {
   using CStringHelper = StringHelper<rosidl_typesupport_introspection_c__MessageMembers>;
   if (!member->is_array_) {
+    check_string_bound(member, deser, static_cast<std::string *>(nullptr));
     CStringHelper::assign(deser, field, call_new);
   } else {
     std::vector<std::string> cpp_string_vector;
-    deser >> cpp_string_vector;
+    if (member->array_size_ && !member->is_upper_bound_) {
+      cpp_string_vector.resize(member->array_size_);
+      deser.deserializeArray(cpp_string_vector.data(), cpp_string_vector.size());
+    } else {
+      check_sequence_bound(member, deser);
+      deser >> cpp_string_vector;
+    }
 
     if (member->array_size_ && !member->is_upper_bound_) {
       auto deser_field = static_cast<rosidl_generator_c__String *>(field);
@@ -407,6 +484,7 @@ void deserialize_field<std::string>(
     } else {
       auto & string_sequence_field =
         *reinterpret_cast<rosidl_generator_c__String__Sequence *>(field);
+      rosidl_generator_c__String__Sequence__fini(&string_sequence_field);
       if (!rosidl_generator_c__String__Sequence__init(&string_sequence_field,
         cpp_string_vector.size()))
       {
@@ -423,20 +501,27 @@ void deserialize_field<std::string>(
   }
 }
 
-template<>
-inline
-void deserialize_field<std::u16string>(
+template<typename T, typename Stream>
+typename std::enable_if<std::is_same<T, std::u16string>::value>::type
+deserialize_field(
   const rosidl_typesupport_introspection_c__MessageMember * member,
   void * field,
-  cbor::RxStream & deser,
+  Stream & deser,
   bool call_new)
 {
   using CU16StringHelper = U16StringHelper<rosidl_typesupport_introspection_c__MessageMembers>;
   if (!member->is_array_) {
+    check_string_bound(member, deser, static_cast<std::u16string *>(nullptr));
     CU16StringHelper::assign(deser, field, call_new);
   } else {
     std::vector<std::u16string> cpp_u16string_vector;
-    deser >> cpp_u16string_vector;
+    if (member->array_size_ && !member->is_upper_bound_) {
+      cpp_u16string_vector.resize(member->array_size_);
+      deser.deserializeArray(cpp_u16string_vector.data(), cpp_u16string_vector.size());
+    } else {
+      check_sequence_bound(member, deser);
+      deser >> cpp_u16string_vector;
+    }
 
     if (member->array_size_ && !member->is_upper_bound_) {
       auto deser_field = static_cast<rosidl_generator_c__U16String *>(field);
@@ -450,6 +535,7 @@ void deserialize_field<std::u16string>(
     } else {
       auto & u16string_sequence_field =
         *reinterpret_cast<rosidl_generator_c__U16String__Sequence *>(field);
+      rosidl_generator_c__U16String__Sequence__fini(&u16string_sequence_field);
       if (!rosidl_generator_c__U16String__Sequence__init(&u16string_sequence_field,
         cpp_u16string_vector.size()))
       {
@@ -466,13 +552,13 @@ void deserialize_field<std::u16string>(
   }
 }
 
-inline
+template<typename Stream>
 size_t get_submessage_sequence_deserialize(
   const rosidl_typesupport_introspection_cpp::MessageMember * member,
-  cbor::RxStream & deser,
+  Stream & deser,
   void * & field,
   void * & subros_message,
-  bool & call_new)
+  bool &)
 {
   if (member->array_size_ && !member->is_upper_bound_) {
     subros_message = field;
@@ -481,19 +567,19 @@ size_t get_submessage_sequence_deserialize(
     // Deserialize length
     uint32_t array_size = 0;
     deser >> array_size;
-    auto vector = reinterpret_cast<std::vector<unsigned char> *>(field);
-    new(vector) std::vector<unsigned char>;
+    check_sequence_length(member, array_size);
+    deser.checkSequenceSize(array_size);
+    // Elements are constructed by resize_function, existing ones are reused.
     member->resize_function(field, array_size);
     subros_message = field;
-    call_new = true;
     return array_size;
   }
 }
 
-inline
+template<typename Stream>
 size_t get_submessage_sequence_deserialize(
   const rosidl_typesupport_introspection_c__MessageMember * member,
-  cbor::RxStream & deser,
+  Stream & deser,
   void * & field,
   void * & subros_message,
   bool & call_new)
@@ -505,6 +591,8 @@ size_t get_submessage_sequence_deserialize(
     // Deserialize length
     uint32_t array_size = 0;
     deser >> array_size;
+    check_sequence_length(member, array_size);
+    deser.checkSequenceSize(array_size);
     member->resize_function(field, array_size);
     subros_message = field;
     call_new = true;
@@ -512,22 +600,114 @@ size_t get_submessage_sequence_deserialize(
   }
 }
 
+template<typename T, typename MemberType, typename Stream>
+void skip_field(const MemberType * member, Stream & deser)
+{
+  if (!member->is_array_) {
+    deser.template skipValue<T>();
+  } else if (member->array_size_ && !member->is_upper_bound_) {
+    deser.template skipArray<T>(member->array_size_);
+  } else {
+    deser.template skipSequence<T>();
+  }
+}
+
+template<typename MembersType>
+template<typename Stream>
+void TypeSupport<MembersType>::skipROSmessage(
+  Stream & deser, const MembersType * members) const
+{
+  assert(members);
+
+  deser.deserializeStructHeader(members->member_count_);
+
+  for (uint32_t i = 0; i < members->member_count_; ++i) {
+    skipMember(deser, members->members_ + i);
+  }
+}
+
+template<typename MembersType>
+template<typename Stream, typename MemberType>
+void TypeSupport<MembersType>::skipMember(Stream & deser, const MemberType * member) const
+{
+  switch (member->type_id_) {
+    case ::rosidl_typesupport_introspection_cpp::ROS_TYPE_BOOLEAN:
+      skip_field<bool>(member, deser);
+      break;
+    case ::rosidl_typesupport_introspection_cpp::ROS_TYPE_OCTET:
+    case ::rosidl_typesupport_introspection_cpp::ROS_TYPE_UINT8:
+    case ::rosidl_typesupport_introspection_cpp::ROS_TYPE_CHAR:
+    case ::rosidl_typesupport_introspection_cpp::ROS_TYPE_INT8:
+      skip_field<uint8_t>(member, deser);
+      break;
+    case ::rosidl_typesupport_introspection_cpp::ROS_TYPE_INT16:
+    case ::rosidl_typesupport_introspection_cpp::ROS_TYPE_UINT16:
+      skip_field<uint16_t>(member, deser);
+      break;
+    case ::rosidl_typesupport_introspection_cpp::ROS_TYPE_FLOAT:
+    case ::rosidl_typesupport_introspection_cpp::ROS_TYPE_INT32:
+    case ::rosidl_typesupport_introspection_cpp::ROS_TYPE_UINT32:
+      skip_field<uint32_t>(member, deser);
+      break;
+    case ::rosidl_typesupport_introspection_cpp::ROS_TYPE_DOUBLE:
+    case ::rosidl_typesupport_introspection_cpp::ROS_TYPE_INT64:
+    case ::rosidl_typesupport_introspection_cpp::ROS_TYPE_UINT64:
+      skip_field<uint64_t>(member, deser);
+      break;
+    case ::rosidl_typesupport_introspection_cpp::ROS_TYPE_STRING:
+      skip_field<std::string>(member, deser);
+      break;
+    case ::rosidl_typesupport_introspection_cpp::ROS_TYPE_WSTRING:
+      skip_field<std::u16string>(member, deser);
+      break;
+    case ::rosidl_typesupport_introspection_cpp::ROS_TYPE_MESSAGE:
+      {
+        auto sub_members = (const MembersType *)member->members_->data;
+        size_t array_size = 1;
+        if (member->is_array_) {
+          if (member->array_size_ && !member->is_upper_bound_) {
+            array_size = member->array_size_;
+          } else {
+            uint32_t size = 0;
+            deser >> size;
+            check_sequence_length(member, size);
+            deser.checkSequenceSize(size);
+            array_size = size;
+          }
+        }
+        for (size_t index = 0; index < array_size; ++index) {
+          skipROSmessage(deser, sub_members);
+        }
+      }
+      break;
+    default:
+      throw std::runtime_error("unknown type");
+  }
+}
+
 template<typename MembersType>
+template<typename Stream>
 bool TypeSupport<MembersType>::deserializeROSmessage(
-  cbor::RxStream & deser, const MembersType * members, void * ros_message, bool call_new)
+  Stream & deser, const MembersType * members, void * ros_message, bool call_new,
+  const Projection * projection)
 {
   assert(members);
   assert(ros_message);
 
-  size_t member_count = 0;
-  deser.deserializeSequence(&member_count);
-  if (member_count != members->member_count_) {
-    throw std::runtime_error("failed to deserialize value");
+  if (projection && projection->selects_all()) {
+    projection = nullptr;
   }
 
+  deser.deserializeStructHeader(members->member_count_);
+
   for (uint32_t i = 0; i < members->member_count_; ++i) {
     const auto * member = members->members_ + i;
     void * field = static_cast<char *>(ros_message) + member->offset_;
+    const Projection * member_projection = projection ? projection->member(i) : nullptr;
+    if (projection && !member_projection) {
+      skipMember(deser, member);
+      continue;
+    }
     switch (member->type_id_) {
       case ::rosidl_typesupport_introspection_cpp::ROS_TYPE_BOOLEAN:
         deserialize_field<bool>(member, field, deser, call_new);
@@ -574,7 +754,7 @@ bool TypeSupport<MembersType>::deserializeROSmessage(
         {
           auto sub_members = (const MembersType *)member->members_->data;
           if (!member->is_array_) {
-            deserializeROSmessage(deser, sub_members, field, call_new);
+            deserializeROSmessage(deser, sub_members, field, call_new, member_projection);
           } else {
             void * subros_message = nullptr;
             size_t array_size = 0;
@@ -585,7 +765,8 @@ bool TypeSupport<MembersType>::deserializeROSmessage(
 
             for (size_t index = 0; index < array_size; ++index) {
               deserializeROSmessage(
-                deser, sub_members, member->get_function(subros_message, index), recall_new);
+                deser, sub_members, member->get_function(subros_message, index), recall_new,
+                member_projection);
             }
           }
         }
@@ -599,8 +780,9 @@ bool TypeSupport<MembersType>::deserializeROSmessage(
 }
 
 template<typename MembersType>
+template<typename Stream>
 bool TypeSupport<MembersType>::serializeROSmessage(
-  const void * ros_message, cbor::TxStream & ser)
+  const void * ros_message, Stream & ser)
 {
   assert(ros_message);
 
@@ -610,7 +792,7 @@ bool TypeSupport<MembersType>::serializeROSmessage(
     ser << (uint8_t)0;
   }
   if (ser.status() == DPS_ERR_OVERFLOW) {
-    ser = cbor::TxStream(ser.size_needed());
+    ser.reset(ser.size_needed());
     if (members_->member_count_ != 0) {
       TypeSupport::serializeROSmessage(ser, members_, ros_message);
     } else {
@@ -621,13 +803,14 @@ bool TypeSupport<MembersType>::serializeROSmessage(
 }
 
 template<typename MembersType>
+template<typename Stream>
 bool TypeSupport<MembersType>::deserializeROSmessage(
-  cbor::RxStream & deser, void * ros_message)
+  Stream & deser, void * ros_message, const Projection * projection)
 {
   assert(ros_message);
 
   if (members_->member_count_ != 0) {
-    TypeSupport::deserializeROSmessage(deser, members_, ros_message, false);
+    TypeSupport::deserializeROSmessage(deser, members_, ros_message, false, projection);
   } else {
     uint8_t dump = 0;
     deser >> dump;
@@ -637,6 +820,143 @@ bool TypeSupport<MembersType>::deserializeROSmessage(
   return true;
 }
 
+template<typename T, typename Stream>
+FilterValue read_filter_value(Stream & deser)
+{
+  T value;
+  deser >> value;
+  FilterValue filter_value;
+  filter_value.type = FilterValue::NUMBER;
+  filter_value.number = value;
+  return filter_value;
+}
+
+template<typename MembersType>
+template<typename Stream>
+void TypeSupport<MembersType>::readFilterFields(
+  Stream & deser, const MembersType * members, const FilterField & fields,
+  std::vector<FilterValue> & values, size_t & remaining) const
+{
+  assert(members);
+
+  deser.deserializeStructHeader(members->member_count_);
+
+  for (uint32_t i = 0; i < members->member_count_ && remaining; ++i) {
+    const auto * member = members->members_ + i;
+    const FilterField * field = fields.members[i].get();
+    if (!field) {
+      skipMember(deser, member);
+      continue;
+    }
+    FilterValue & value = values[field->slot];
+    switch (member->type_id_) {
+      case ::rosidl_typesupport_introspection_cpp::ROS_TYPE_BOOLEAN:
+        value = read_filter_value<bool>(deser);
+        break;
+      case ::rosidl_typesupport_introspection_cpp::ROS_TYPE_OCTET:
+      case ::rosidl_typesupport_introspection_cpp::ROS_TYPE_UINT8:
+        value = read_filter_value<uint8_t>(deser);
+        break;
+      case ::rosidl_typesupport_introspection_cpp::ROS_TYPE_CHAR:
+      case ::rosidl_typesupport_introspection_cpp::ROS_TYPE_INT8:
+        value = read_filter_value<int8_t>(deser);
+        break;
+      case ::rosidl_typesupport_introspection_cpp::ROS_TYPE_FLOAT:
+        value = read_filter_value<float>(deser);
+        break;
+      case ::rosidl_typesupport_introspection_cpp::ROS_TYPE_DOUBLE:
+        value = read_filter_value<double>(deser);
+        break;
+      case ::rosidl_typesupport_introspection_cpp::ROS_TYPE_INT16:
+        value = read_filter_value<int16_t>(deser);
+        break;
+      case ::rosidl_typesupport_introspection_cpp::ROS_TYPE_UINT16:
+        value = read_filter_value<uint16_t>(deser);
+        break;
+      case ::rosidl_typesupport_introspection_cpp::ROS_TYPE_INT32:
+        value = read_filter_value<int32_t>(deser);
+        break;
+      case ::rosidl_typesupport_introspection_cpp::ROS_TYPE_UINT32:
+        value = read_filter_value<uint32_t>(deser);
+        break;
+      case ::rosidl_typesupport_introspection_cpp::ROS_TYPE_INT64:
+        value = read_filter_value<int64_t>(deser);
+        break;
+      case ::rosidl_typesupport_introspection_cpp::ROS_TYPE_UINT64:
+        value = read_filter_value<uint64_t>(deser);
+        break;
+      case ::rosidl_typesupport_introspection_cpp::ROS_TYPE_STRING:
+        check_string_bound(member, deser, static_cast<const std::string *>(nullptr));
+        value.type = FilterValue::STRING;
+        deser >> value.string;
+        break;
+      case ::rosidl_typesupport_introspection_cpp::ROS_TYPE_MESSAGE:
+        readFilterFields(
+          deser, (const MembersType *)member->members_->data, *field, values, remaining);
+        continue;
+      default:
+        throw std::runtime_error("unknown type");
+    }
+    --remaining;
+  }
+}
+
+template<typename MembersType>
+template<typename Stream>
+void TypeSupport<MembersType>::readFilterFields(
+  Stream & deser, const FilterField & fields, std::vector<FilterValue> & values) const
+{
+  // Reading stops once every field has been read.
+  size_t remaining = values.size();
+  readFilterFields(deser, members_, fields, values, remaining);
+}
+
+/// Reads fields directly from CBOR or CDR payloads.
+template<typename MembersType>
+class TypeSupportFieldReader : public FieldReader, private TypeSupport<MembersType>
+{
+public:
+  TypeSupportFieldReader(const MembersType * members, const std::vector<std::string> & fields)
+  : TypeSupport<MembersType>(members)
+  {
+    resolve(members, fields);
+  }
+
+  bool
+  read(uint8_t * payload, size_t len, std::vector<FilterValue> & values) const
+  {
+    values.resize(fields_.size());
+    try {
+      if (cdr::is_cdr(payload, len)) {
+        cdr::RxStream deser(payload, len);
+        this->readFilterFields(deser, root_, values);
+      } else {
+        cbor::RxStream deser = cbor::RxStream::view(payload, len);
+        this->readFilterFields(deser, root_, values);
+      }
+    } catch (const std::exception &) {
+      return false;
+    }
+    return true;
+  }
+};
+
+template<typename MembersType>
+std::unique_ptr<FieldReader> TypeSupport<MembersType>::createFieldReader(
+  const std::vector<std::string> & fields) const
+{
+  return std::unique_ptr<FieldReader>(new TypeSupportFieldReader<MembersType>(members_, fields));
+}
+
+template<typename MembersType>
+std::unique_ptr<ContentFilter> TypeSupport<MembersType>::createContentFilter(
+  const std::string & expression, const std::vector<std::string> & parameters) const
+{
+  std::unique_ptr<ContentFilter> filter(new ContentFilter(expression, parameters));
+  filter->setReader(createFieldReader(filter->fields()));
+  return filter;
+}
+
 }  // namespace rmw_dps_cpp
 
 #endif  // RMW_DPS_CPP__TYPESUPPORT_IMPL_HPP_
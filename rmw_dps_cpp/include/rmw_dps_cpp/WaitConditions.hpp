@@ -0,0 +1,79 @@
+// Copyright 2018 Intel Corporation All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef RMW_DPS_CPP__WAITCONDITIONS_HPP_
+#define RMW_DPS_CPP__WAITCONDITIONS_HPP_
+
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace rmw_dps_cpp
+{
+
+/// The conditions of the wait sets waiting on an entity.
+/**
+ * An entity may be in several wait sets waited on at once, as by a
+ * multi-threaded executor, so each wait set attaches its own condition and
+ * is notified on it. Not synchronized, the entity guards it with its own
+ * mutex.
+ */
+class WaitConditions
+{
+public:
+  void
+  attach(std::mutex * conditionMutex, std::condition_variable * conditionVariable)
+  {
+    conditions_.emplace_back(conditionMutex, conditionVariable);
+  }
+
+  /// Detach a condition, if attached.
+  void
+  detach(std::mutex * conditionMutex, std::condition_variable * conditionVariable)
+  {
+    auto it = std::find(conditions_.begin(), conditions_.end(),
+        Condition(conditionMutex, conditionVariable));
+    if (it != conditions_.end()) {
+      *it = conditions_.back();
+      conditions_.pop_back();
+    }
+  }
+
+  /// Wake the waiters after a change of the state they wait for.
+  /**
+   * The state must be read by the waiters under their condition mutex, and
+   * changed before calling this. Taking each condition mutex in turn, rather
+   * than changing the state under all of them, ensures a waiter either sees
+   * the change or is waiting when notified, without ordering the mutexes.
+   */
+  void
+  notify()
+  {
+    for (auto & condition : conditions_) {
+      std::unique_lock<std::mutex> lock(*condition.first);
+      lock.unlock();
+      condition.second->notify_one();
+    }
+  }
+
+private:
+  typedef std::pair<std::mutex *, std::condition_variable *> Condition;
+  std::vector<Condition> conditions_;
+};
+
+}  // namespace rmw_dps_cpp
+
+#endif  // RMW_DPS_CPP__WAITCONDITIONS_HPP_
@@ -18,6 +18,9 @@
 #include <dps/discovery.h>
 #include <dps/dps.h>
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <iterator>
 #include <iostream>
 #include <map>
@@ -32,8 +35,10 @@
 #include "rmw_dps_cpp/CborStream.hpp"
 #include "rmw_dps_cpp/custom_publisher_info.hpp"
 #include "rmw_dps_cpp/custom_subscriber_info.hpp"
+#include "rmw_dps_cpp/discovery_statistics.hpp"
 #include "rmw_dps_cpp/names_common.hpp"
 #include "rmw_dps_cpp/namespace_prefix.hpp"
+#include "rmw_dps_cpp/serialization_format.hpp"
 
 class NodeListener;
 
@@ -44,6 +49,8 @@ typedef struct CustomNodeInfo
   size_t domain_id_;
   std::mutex discovery_mutex_;
   std::vector<std::string> discovery_payload_;
+  std::atomic<uint64_t> discovery_published_count_{0};
+  std::atomic<uint64_t> discovery_published_bytes_{0};
   DPS_DiscoveryService * discovery_svc_;
   NodeListener * listener_;
   std::mutex publishers_mutex_;
@@ -85,6 +92,7 @@ public:
     std::vector<Topic> publishers;
     std::vector<Topic> services;
     std::vector<Topic> clients;
+    std::vector<std::string> formats;
     bool operator==(const Node & that) const
     {
       return this->clients == that.clients &&
@@ -92,7 +100,19 @@ public:
              this->publishers == that.publishers &&
              this->subscribers == that.subscribers &&
              this->name == that.name &&
-             this->namespace_ == that.namespace_;
+             this->namespace_ == that.namespace_ &&
+             this->formats == that.formats;
+    }
+    /// Whether the subscriptions of the node decode messages of format.
+    /**
+     * Nodes that do not advertise their formats predate "cdr".
+     */
+    bool accepts(const char * format) const
+    {
+      if (formats.empty()) {
+        return strcmp(format, intel_dps_serialization_format) == 0;
+      }
+      return std::find(formats.begin(), formats.end(), format) != formats.end();
     }
   };
 
@@ -112,7 +132,12 @@ public:
 
     NodeListener * listener =
       reinterpret_cast<NodeListener *>(DPS_GetDiscoveryServiceData(service));
-    return listener->onDiscovery(pub, payload, len);
+    auto start = std::chrono::steady_clock::now();
+    listener->onDiscovery(pub, payload, len);
+    listener->received_ns_ += std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now() - start).count();
+    ++listener->received_count_;
+    listener->received_bytes_ += len;
   }
 
   void
@@ -138,6 +163,14 @@ public:
           node.name = topic.substr(pos + strlen(dps_name_prefix));
           continue;
         }
+        if (topic.compare(0, strlen(dps_formats_prefix), dps_formats_prefix) == 0) {
+          for (pos = strlen(dps_formats_prefix); pos < topic.size(); ) {
+            size_t end_pos = std::min(topic.find(",", pos), topic.size());
+            node.formats.push_back(topic.substr(pos, end_pos - pos));
+            pos = end_pos + 1;
+          }
+          continue;
+        }
         if (process_topic_info(topic, dps_subscriber_prefix, node.subscribers)) {
           continue;
         }
@@ -184,12 +217,16 @@ public:
         for (auto pub : impl->publishers_[topic]) {
           pub->subscriptions_.erase(uuid);
           pub->subscriptions_matched_count_.store(pub->subscriptions_.size());
+          if (pub->subscriptions_.empty()) {
+            pub->unmatched_since_.store(std::chrono::steady_clock::now());
+          }
         }
       }
       for (auto topic : added) {
         for (auto pub : impl->publishers_[topic]) {
           pub->subscriptions_.insert(uuid);
           pub->subscriptions_matched_count_.store(pub->subscriptions_.size());
+          warn_incompatible(pub, topic, node);
         }
       }
     }
@@ -222,6 +259,17 @@ public:
     }
   }
 
+  /// Get the counters of the payloads received and the nodes discovered.
+  void
+  get_statistics(rmw_dps_cpp::DiscoveryStatistics & statistics) const
+  {
+    statistics.received_count = received_count_;
+    statistics.received_bytes = received_bytes_;
+    statistics.received_ns = received_ns_;
+    std::lock_guard<std::mutex> lock(mutex_);
+    statistics.node_count = discovered_nodes_.size();
+  }
+
   std::vector<Node>
   get_discovered_nodes() const
   {
@@ -258,6 +306,44 @@ public:
     return count;
   }
 
+  /// The UUIDs of the discovered nodes with a subscriber to topic_name.
+  /**
+   * Warns if pub is not null and a node cannot decode its messages.
+   */
+  std::set<std::string>
+  get_subscriber_uuids(const char * topic_name, CustomPublisherInfo * pub = nullptr) const
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::set<std::string> uuids;
+    for (auto it : discovered_nodes_) {
+      if (std::any_of(it.second.subscribers.begin(), it.second.subscribers.end(),
+        [topic_name](const Topic & subscriber) {return subscriber.topic == topic_name;}))
+      {
+        uuids.insert(it.first);
+        if (pub) {
+          warn_incompatible(pub, topic_name, it.second);
+        }
+      }
+    }
+    return uuids;
+  }
+
+  /// The UUIDs of the discovered nodes with a publisher to topic_name.
+  std::set<std::string>
+  get_publisher_uuids(const char * topic_name) const
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::set<std::string> uuids;
+    for (auto it : discovered_nodes_) {
+      if (std::any_of(it.second.publishers.begin(), it.second.publishers.end(),
+        [topic_name](const Topic & publisher) {return publisher.topic == topic_name;}))
+      {
+        uuids.insert(it.first);
+      }
+    }
+    return uuids;
+  }
+
   size_t
   count_services(const char * topic_name) const
   {
@@ -368,6 +454,23 @@ public:
   }
 
 private:
+  /// Warn, once per publisher, of a subscribing node that cannot decode its messages.
+  /**
+   * Called with the publishers_mutex_ of the node held.
+   */
+  static void
+  warn_incompatible(CustomPublisherInfo * pub, const std::string & topic, const Node & node)
+  {
+    if (!pub->incompatible_subscription_warned_ && !node.accepts(pub->serialization_format_)) {
+      pub->incompatible_subscription_warned_ = true;
+      RCUTILS_LOG_WARN_NAMED(
+        "rmw_dps_cpp",
+        "the subscriptions of node '%s' in '%s' to topic '%s' cannot decode its %s messages, "
+        "they predate that serialization format",
+        node.name.c_str(), node.namespace_.c_str(), topic.c_str(), pub->serialization_format_);
+    }
+  }
+
   bool
   process_topic_info(
     const std::string & topic_str, const char * prefix,
@@ -384,14 +487,16 @@ private:
         topics.emplace_back(topic_str.substr(pos));
       }
       Topic & topic = topics.back();
-      while (pos != std::string::npos) {
+      // The types end at any further field, which peers may add
+      size_t types_end_pos = topic_str.find("&", pos);
+      while (pos != std::string::npos && pos < types_end_pos) {
         end_pos = topic_str.find(",", pos);
-        if (end_pos != std::string::npos) {
+        if (end_pos != std::string::npos && end_pos < types_end_pos) {
           topic.types.emplace_back(topic_str.substr(pos, end_pos - pos));
           pos = end_pos + 1;
         } else {
-          topic.types.emplace_back(topic_str.substr(pos));
-          pos = end_pos;
+          topic.types.emplace_back(topic_str.substr(pos, types_end_pos - pos));
+          pos = std::string::npos;
         }
       }
       return true;
@@ -421,6 +526,9 @@ private:
   mutable std::mutex mutex_;
   std::map<std::string, Node> discovered_nodes_;
   const rmw_node_t * node_;
+  std::atomic<uint64_t> received_count_{0};
+  std::atomic<uint64_t> received_bytes_{0};
+  std::atomic<uint64_t> received_ns_{0};
 };
 
 #endif  // RMW_DPS_CPP__CUSTOM_NODE_INFO_HPP_
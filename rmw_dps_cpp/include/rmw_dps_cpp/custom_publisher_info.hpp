@@ -19,21 +19,86 @@
 #include <dps/event.h>
 
 #include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <set>
 #include <string>
+#include <vector>
 
 #include "rmw/rmw.h"
 
+#include "rmw_dps_cpp/CborStream.hpp"
+#include "rmw_dps_cpp/CdrStream.hpp"
+#include "rmw_dps_cpp/Compression.hpp"
+#include "rmw_dps_cpp/ContentFilter.hpp"
+#include "rmw_dps_cpp/Delta.hpp"
+#include "rmw_dps_cpp/MessagePool.hpp"
+#include "rmw_dps_cpp/Pacer.hpp"
+
+/// The buffers publishing a message is serialized, delta encoded and compressed into.
+/**
+ * Reused from one message to the next, so that publishing a message no
+ * larger than those before it does not allocate.
+ */
+struct PublishBuffers
+{
+  rmw_dps_cpp::cbor::TxStream cbor;
+  rmw_dps_cpp::cdr::TxStream cdr;
+  std::vector<DPS_Buffer> bufs;
+  std::vector<uint8_t> delta;
+  std::vector<uint8_t> compressed;
+};
+
+/// A publication created for a combination of key values.
+struct KeyedPublication
+{
+  /// Shared with the publishes using it, which it outlives when evicted.
+  std::shared_ptr<DPS_Publication> publication;
+  /// When last published to, in keyed_publications_uses_.
+  uint64_t last;
+};
+
 typedef struct CustomPublisherInfo
 {
   DPS_Publication * publication_;
   const rmw_node_t * node_;
   void * type_support_;
   const char * typesupport_identifier_;
+  const char * serialization_format_;
+  std::string dps_topic_name_;
+  std::unique_ptr<rmw_dps_cpp::FieldReader> key_reader_;
+  std::mutex keyed_publications_mutex_;
+  std::map<std::string, KeyedPublication> keyed_publications_;
+  uint64_t keyed_publications_uses_;
+  size_t max_keyed_publications_;
+  std::unique_ptr<rmw_dps_cpp::MessagePool> loan_pool_;
+  size_t max_fragment_size_;
+  std::atomic<uint32_t> fragmented_message_id_;
+  std::unique_ptr<rmw_dps_cpp::Pacer> pacer_;
+  rmw_dps_cpp::Codec compression_;
+  size_t compression_threshold_;
+  size_t keyframe_interval_;
+  /// The encoders of the publications, which are also their publication data.
+  std::mutex delta_encoders_mutex_;
+  std::vector<std::unique_ptr<rmw_dps_cpp::DeltaEncoder>> delta_encoders_;
+  /// Held while publishing with publish_buffers_.
+  std::mutex publish_buffers_mutex_;
+  PublishBuffers publish_buffers_;
   rmw_qos_profile_t qos_;
   std::string discovery_name_;
   std::set<std::string> subscriptions_;
   std::atomic_size_t subscriptions_matched_count_;
+  /// Whether a subscription that cannot decode serialization_format_ was reported.
+  bool incompatible_subscription_warned_;
+  bool publish_unmatched_;
+  std::chrono::milliseconds unmatched_grace_period_;
+  /// When the publisher was created or its last matched subscription went away.
+  std::atomic<std::chrono::steady_clock::time_point> unmatched_since_;
+  /// When a message was last sent past the grace period without a matched subscription.
+  std::atomic<std::chrono::steady_clock::time_point> unmatched_sent_;
 } CustomPublisherInfo;
 
 #endif  // RMW_DPS_CPP__CUSTOM_PUBLISHER_INFO_HPP_
@@ -18,11 +18,15 @@
 #include <dps/dps.h>
 
 #include <atomic>
+#include <memory>
 #include <set>
 #include <string>
 
 #include "rmw/rmw.h"
 
+#include "rmw_dps_cpp/MessagePool.hpp"
+#include "rmw_dps_cpp/Projection.hpp"
+
 class Listener;
 
 typedef struct CustomSubscriberInfo
@@ -32,6 +36,9 @@ typedef struct CustomSubscriberInfo
   Listener * listener_;
   void * type_support_;
   const char * typesupport_identifier_;
+  std::unique_ptr<rmw_dps_cpp::Projection> projection_;
+  std::unique_ptr<rmw_dps_cpp::MessagePool> loan_pool_;
+  bool transfer_serialized_messages_;
   rmw_qos_profile_t qos_;
   std::string discovery_name_;
   std::set<std::string> publishers_;
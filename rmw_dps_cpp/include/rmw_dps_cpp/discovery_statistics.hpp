@@ -0,0 +1,57 @@
+// Copyright 2018 Intel Corporation All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef RMW_DPS_CPP__DISCOVERY_STATISTICS_HPP_
+#define RMW_DPS_CPP__DISCOVERY_STATISTICS_HPP_
+
+#include <cstdint>
+
+#include "rmw/macros.h"
+#include "rmw/types.h"
+#include "rmw/visibility_control.h"
+
+namespace rmw_dps_cpp
+{
+
+/// The counters of the discovery traffic of a node.
+typedef struct DiscoveryStatistics
+{
+  /// The discovery payloads published, one each time the entities of the node change.
+  uint64_t published_count;
+  /// The bytes of the payloads published, before DPS adds its headers.
+  uint64_t published_bytes;
+  /// The discovery payloads received from other nodes.
+  uint64_t received_count;
+  /// The bytes of the payloads received.
+  uint64_t received_bytes;
+  /// The time spent handling the payloads received, in nanoseconds.
+  uint64_t received_ns;
+  /// The nodes discovered.
+  uint64_t node_count;
+} DiscoveryStatistics;
+
+}  // namespace rmw_dps_cpp
+
+extern "C"
+{
+/// Get the counters of the discovery traffic of a node.
+RMW_PUBLIC
+RMW_WARN_UNUSED
+rmw_ret_t
+rmw_dps_cpp_node_get_discovery_statistics(
+  const rmw_node_t * node,
+  rmw_dps_cpp::DiscoveryStatistics * statistics);
+}  // extern "C"
+
+#endif  // RMW_DPS_CPP__DISCOVERY_STATISTICS_HPP_
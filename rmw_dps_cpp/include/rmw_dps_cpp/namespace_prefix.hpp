@@ -26,6 +26,8 @@ extern const char * const dps_subscriber_prefix;
 extern const char * const dps_publisher_prefix;
 extern const char * const dps_service_prefix;
 extern const char * const dps_client_prefix;
+/// The serialization formats the subscriptions of a node accept, ',' separated.
+extern const char * const dps_formats_prefix;
 }  // extern "C"
 
 #endif  // RMW_DPS_CPP__NAMESPACE_PREFIX_HPP_
@@ -0,0 +1,59 @@
+// Copyright 2018 Intel Corporation All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef RMW_DPS_CPP__PACING_STATISTICS_HPP_
+#define RMW_DPS_CPP__PACING_STATISTICS_HPP_
+
+#include <cstdint>
+
+#include "rmw/macros.h"
+#include "rmw/types.h"
+#include "rmw/visibility_control.h"
+
+namespace rmw_dps_cpp
+{
+
+/// The counters of a publisher sending at a limited bandwidth.
+/**
+ * See PublisherOptions::max_bandwidth.
+ */
+typedef struct PacingStatistics
+{
+  /// The bytes waiting to be sent.
+  uint64_t queued_bytes;
+  /// The bytes sent.
+  uint64_t sent_bytes;
+  /// The bytes sent that had to wait for the bandwidth limit.
+  uint64_t delayed_bytes;
+  /// The total time spent waiting for the bandwidth limit, in nanoseconds.
+  uint64_t delay_ns;
+} PacingStatistics;
+
+}  // namespace rmw_dps_cpp
+
+extern "C"
+{
+/// Get the pacing counters of a publisher.
+/**
+ * \return RMW_RET_UNSUPPORTED if the bandwidth of the publisher is not limited.
+ */
+RMW_PUBLIC
+RMW_WARN_UNUSED
+rmw_ret_t
+rmw_dps_cpp_publisher_get_pacing_statistics(
+  const rmw_publisher_t * publisher,
+  rmw_dps_cpp::PacingStatistics * statistics);
+}  // extern "C"
+
+#endif  // RMW_DPS_CPP__PACING_STATISTICS_HPP_
@@ -0,0 +1,39 @@
+// Copyright 2018 Intel Corporation All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef RMW_DPS_CPP__PENDING_REQUESTS_HPP_
+#define RMW_DPS_CPP__PENDING_REQUESTS_HPP_
+
+#include <cstddef>
+
+#include "rmw/macros.h"
+#include "rmw/types.h"
+#include "rmw/visibility_control.h"
+
+extern "C"
+{
+/// Get the number of requests taken by a service and not yet responded to.
+/**
+ * A service holds each request it takes until rmw_send_response() acknowledges
+ * it, so the count should stay within the requests its clients have in
+ * flight. Like rmw_take_request() and rmw_send_response(), must not be
+ * called concurrently with them for the same service.
+ */
+RMW_PUBLIC
+RMW_WARN_UNUSED
+rmw_ret_t
+rmw_dps_cpp_service_get_pending_request_count(const rmw_service_t * service, size_t * count);
+}  // extern "C"
+
+#endif  // RMW_DPS_CPP__PENDING_REQUESTS_HPP_
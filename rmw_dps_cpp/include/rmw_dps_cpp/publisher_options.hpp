@@ -0,0 +1,117 @@
+// Copyright 2018 Intel Corporation All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef RMW_DPS_CPP__PUBLISHER_OPTIONS_HPP_
+#define RMW_DPS_CPP__PUBLISHER_OPTIONS_HPP_
+
+#include <cstddef>
+
+namespace rmw_dps_cpp
+{
+
+/// Publisher options specific to rmw_dps_cpp.
+/**
+ * A pointer to an instance may be passed in
+ * rmw_publisher_options_t::rmw_specific_publisher_payload.
+ * A zero value for any field selects the default behavior.
+ */
+typedef struct PublisherOptions
+{
+  /// The serialization format of published messages, "cbor" or "cdr".
+  /**
+   * When null the RMW_DPS_SERIALIZATION_FORMAT environment variable is used,
+   * and "cbor" if that is not set.
+   * Subscriptions accept either format, telling it from each payload, so it
+   * is not advertised in discovery. "cdr" publishers are incompatible with
+   * subscriptions of rmw_dps_cpp versions that predate it, which drop their
+   * messages; a publisher logs a warning once when it discovers one.
+   */
+  const char * serialization_format;
+  /// A ',' separated list of member paths whose values key the topic, e.g. "robot_id".
+  /**
+   * The key values of each message are added to its DPS publication topics,
+   * so subscriptions to one key filter in the DPS network layer. The fields
+   * must be primitive or string members outside of any array and should
+   * take a small set of values, as a DPS publication is kept for each
+   * distinct combination, up to max_keyed_publications.
+   */
+  const char * key_fields;
+  /// Lend messages from a pool of QoS depth preconstructed messages.
+  /**
+   * See rmw_borrow_loaned_message(). A loaned message is given back to the
+   * pool once published, keeping the memory of its strings and sequences.
+   */
+  bool loan_messages;
+  /// Messages larger than this are published in fragments of this many bytes.
+  /**
+   * Keeping each DPS publication within a UDP datagram means losing a
+   * fragment only loses its message. The default is 32768 bytes.
+   */
+  size_t max_fragment_size;
+  /// Limit the rate at which messages and fragments are sent, in bytes per second.
+  /**
+   * When zero the RMW_DPS_MAX_BANDWIDTH environment variable is used, and
+   * the rate is not limited if that is not set. Publishing blocks until the
+   * message may be sent, see rmw_dps_cpp_publisher_get_pacing_statistics().
+   */
+  size_t max_bandwidth;
+  /// Publish messages even when no matching subscription has been discovered.
+  /**
+   * By default, once the unmatched grace period has passed since the
+   * publisher was created or lost its last matched subscription, only one
+   * message per grace period is serialized and sent while there is no
+   * matched subscription, so subscriptions not discovered yet still get
+   * messages. Subscriptions of the same node always count as matched.
+   */
+  bool publish_unmatched;
+  /// How long to keep publishing every message without matched subscriptions, in milliseconds.
+  /**
+   * This covers subscriptions that exist but have not been discovered yet,
+   * and is then the interval between the messages sent while unmatched.
+   * The default is 2000 milliseconds.
+   */
+  size_t unmatched_grace_period;
+  /// Compress messages with "lz" or, when rmw_dps_cpp is built with zstd, "zstd".
+  /**
+   * When null messages are not compressed. Subscriptions uncompress messages
+   * as they are taken, or as they arrive when they have a content filter.
+   */
+  const char * compression;
+  /// Only messages of at least this many bytes are compressed, 1024 by default.
+  /**
+   * A message that does not get smaller is sent uncompressed.
+   */
+  size_t compression_threshold;
+  /// Publish every this many messages in full, and the others as deltas.
+  /**
+   * A delta encodes the bytes of a serialized message that differ from the
+   * previous message, which suits large messages that change little. A
+   * subscription that misses the previous message requests a keyframe, a
+   * message published in full. When zero every message is published in full.
+   */
+  size_t keyframe_interval;
+  /// Keep at most this many publications for the key values, 256 by default.
+  /**
+   * See key_fields. A message with new key values once there are this many
+   * destroys the publication least recently published to, so key values
+   * that keep changing, such as floating point readings, cannot exhaust
+   * memory. Subscriptions see the publication of evicted key values that
+   * come back as a new publisher.
+   */
+  size_t max_keyed_publications;
+} PublisherOptions;
+
+}  // namespace rmw_dps_cpp
+
+#endif  // RMW_DPS_CPP__PUBLISHER_OPTIONS_HPP_
@@ -16,5 +16,13 @@
 #define RMW_DPS_CPP__SERIALIZATION_FORMAT_HPP_
 
 extern const char * const intel_dps_serialization_format;
+extern const char * const intel_dps_cdr_serialization_format;
+
+/// Return the serialization format constant matching name, or nullptr if unknown.
+/**
+ * A null or empty name selects the value of the RMW_DPS_SERIALIZATION_FORMAT
+ * environment variable, or intel_dps_serialization_format if it is not set.
+ */
+const char * _get_serialization_format(const char * name);
 
 #endif  // RMW_DPS_CPP__SERIALIZATION_FORMAT_HPP_
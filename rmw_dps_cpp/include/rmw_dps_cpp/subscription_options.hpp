@@ -0,0 +1,86 @@
+// Copyright 2018 Intel Corporation All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef RMW_DPS_CPP__SUBSCRIPTION_OPTIONS_HPP_
+#define RMW_DPS_CPP__SUBSCRIPTION_OPTIONS_HPP_
+
+#include <cstddef>
+
+namespace rmw_dps_cpp
+{
+
+/// The default of SubscriptionOptions::max_payload_size, 64 MiB.
+const size_t default_max_payload_size = size_t(64) << 20;
+
+/// Subscription options specific to rmw_dps_cpp.
+/**
+ * A pointer to an instance may be passed in
+ * rmw_subscription_options_t::rmw_specific_subscription_payload.
+ * A zero value for any field selects the default behavior.
+ */
+typedef struct SubscriptionOptions
+{
+  /// Publications with a larger payload are dropped on arrival, in bytes.
+  /**
+   * This also bounds the size a fragmented payload is reassembled to,
+   * the default being default_max_payload_size.
+   */
+  size_t max_payload_size;
+  /// The largest sequence or string length accepted while decoding.
+  size_t max_sequence_size;
+  /// A ',' separated list of member paths to deserialize, e.g. "header.stamp,data".
+  /**
+   * Members that are not listed are skipped without being decoded and keep
+   * the value they had in the message passed to rmw_take().
+   */
+  const char * projection;
+  /// A filter expression over the fields of the message, e.g. "data > %0".
+  /**
+   * Publications that do not match are dropped on arrival, before they are
+   * queued or deserialized. See rmw_dps_cpp::ContentFilter for the syntax.
+   */
+  const char * filter_expression;
+  /// The values of the %n parameters of the filter expression.
+  const char * const * expression_parameters;
+  size_t expression_parameters_count;
+  /// Only receive messages with these key values, e.g. "robot_id=7,side=left".
+  /**
+   * The publisher must key the topic by the same fields, see
+   * PublisherOptions::key_fields. Unkeyed subscriptions receive all messages.
+   */
+  const char * key;
+  /// Lend messages from a pool of QoS depth preconstructed messages.
+  /**
+   * See rmw_take_loaned_message(). A loaned message is given back to the
+   * pool when returned, keeping the memory of its strings and sequences.
+   */
+  bool loan_messages;
+  /// Hand the received buffer to rmw_take_serialized_message() instead of copying it.
+  /**
+   * The buffer of the serialized message is freed and replaced by the
+   * received one, so its capacity becomes the length of the message. This
+   * only applies when the serialized message uses the default allocator,
+   * other serialized messages are copied into.
+   */
+  bool transfer_serialized_messages;
+  /// Discard a fragmented message when no fragment arrives for this long, in milliseconds.
+  /**
+   * The default is 1000 milliseconds. See PublisherOptions::max_fragment_size.
+   */
+  size_t fragment_timeout;
+} SubscriptionOptions;
+
+}  // namespace rmw_dps_cpp
+
+#endif  // RMW_DPS_CPP__SUBSCRIPTION_OPTIONS_HPP_
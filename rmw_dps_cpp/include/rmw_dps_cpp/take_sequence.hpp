@@ -0,0 +1,66 @@
+// Copyright 2018 Intel Corporation All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef RMW_DPS_CPP__TAKE_SEQUENCE_HPP_
+#define RMW_DPS_CPP__TAKE_SEQUENCE_HPP_
+
+#include <cstddef>
+
+#include "rmw/macros.h"
+#include "rmw/serialized_message.h"
+#include "rmw/types.h"
+#include "rmw/visibility_control.h"
+
+extern "C"
+{
+/// Take up to count queued messages from a subscription.
+/**
+ * The messages are removed from the subscription queue under a single lock,
+ * so draining a burst costs one call, and one rmw_wait(), instead of one per
+ * message. Messages are taken in arrival order into ros_messages[0] up to
+ * ros_messages[*taken - 1]; messages that cannot be decoded are dropped.
+ *
+ * \param[in] subscription the subscription to take from
+ * \param[in] count the number of ros_messages, and of message_infos if not null
+ * \param[out] ros_messages the messages to deserialize into
+ * \param[out] message_infos the info of each message taken, may be null
+ * \param[out] taken the number of messages taken
+ */
+RMW_PUBLIC
+RMW_WARN_UNUSED
+rmw_ret_t
+rmw_dps_cpp_take_sequence(
+  const rmw_subscription_t * subscription,
+  size_t count,
+  void * const * ros_messages,
+  rmw_message_info_t * message_infos,
+  size_t * taken);
+
+/// Take up to count queued messages from a subscription without deserializing them.
+/**
+ * As rmw_dps_cpp_take_sequence(), with each serialized message resized as
+ * needed to hold its payload.
+ */
+RMW_PUBLIC
+RMW_WARN_UNUSED
+rmw_ret_t
+rmw_dps_cpp_take_serialized_message_sequence(
+  const rmw_subscription_t * subscription,
+  size_t count,
+  rmw_serialized_message_t * serialized_messages,
+  rmw_message_info_t * message_infos,
+  size_t * taken);
+}  // extern "C"
+
+#endif  // RMW_DPS_CPP__TAKE_SEQUENCE_HPP_
@@ -0,0 +1,166 @@
+// Copyright 2018 Intel Corporation All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// The LTTng tracepoint provider of rmw_dps_cpp, see rmw_dps_cpp/tracing.hpp.
+// Publications are identified by the UUID of their DPS publication and
+// their sequence number, as on the wire; messages by their address.
+
+#undef TRACEPOINT_PROVIDER
+#define TRACEPOINT_PROVIDER rmw_dps_cpp
+
+#undef TRACEPOINT_INCLUDE
+#define TRACEPOINT_INCLUDE "rmw_dps_cpp/tracepoints.h"
+
+#if !defined(RMW_DPS_CPP__TRACEPOINTS_H_) || defined(TRACEPOINT_HEADER_MULTI_READ)
+#define RMW_DPS_CPP__TRACEPOINTS_H_
+
+#include <lttng/tracepoint.h>
+
+#include <stdint.h>
+
+// rmw_publish() is called with a message
+TRACEPOINT_EVENT(
+  TRACEPOINT_PROVIDER,
+  rmw_publish,
+  TP_ARGS(
+    const void *, publisher_handle_arg,
+    const void *, message_arg
+  ),
+  TP_FIELDS(
+    ctf_integer_hex(const void *, publisher_handle, publisher_handle_arg)
+    ctf_integer_hex(const void *, message, message_arg)
+  )
+)
+
+// The message is serialized, to be published by the DPS publication
+TRACEPOINT_EVENT(
+  TRACEPOINT_PROVIDER,
+  serialized,
+  TP_ARGS(
+    const void *, message_arg,
+    const uint8_t *, publication_uuid_arg,
+    uint64_t, size_arg
+  ),
+  TP_FIELDS(
+    ctf_integer_hex(const void *, message, message_arg)
+    ctf_array(uint8_t, publication_uuid, publication_uuid_arg, 16)
+    ctf_integer(uint64_t, size, size_arg)
+  )
+)
+
+// DPS has sent a publication, or a fragment of a message
+TRACEPOINT_EVENT(
+  TRACEPOINT_PROVIDER,
+  published,
+  TP_ARGS(
+    const uint8_t *, publication_uuid_arg,
+    uint32_t, sequence_number_arg,
+    uint64_t, size_arg,
+    int, status_arg
+  ),
+  TP_FIELDS(
+    ctf_array(uint8_t, publication_uuid, publication_uuid_arg, 16)
+    ctf_integer(uint32_t, sequence_number, sequence_number_arg)
+    ctf_integer(uint64_t, size, size_arg)
+    ctf_integer(int, status, status_arg)
+  )
+)
+
+// A subscription, or service, has received a publication
+TRACEPOINT_EVENT(
+  TRACEPOINT_PROVIDER,
+  on_publication,
+  TP_ARGS(
+    const void *, listener_arg,
+    const uint8_t *, publication_uuid_arg,
+    uint32_t, sequence_number_arg,
+    uint64_t, size_arg
+  ),
+  TP_FIELDS(
+    ctf_integer_hex(const void *, listener, listener_arg)
+    ctf_array(uint8_t, publication_uuid, publication_uuid_arg, 16)
+    ctf_integer(uint32_t, sequence_number, sequence_number_arg)
+    ctf_integer(uint64_t, size, size_arg)
+  )
+)
+
+// A publication, reassembled and decoded, is queued to be taken
+TRACEPOINT_EVENT(
+  TRACEPOINT_PROVIDER,
+  enqueue,
+  TP_ARGS(
+    const void *, listener_arg,
+    const uint8_t *, publication_uuid_arg,
+    uint32_t, sequence_number_arg,
+    uint64_t, queue_size_arg
+  ),
+  TP_FIELDS(
+    ctf_integer_hex(const void *, listener, listener_arg)
+    ctf_array(uint8_t, publication_uuid, publication_uuid_arg, 16)
+    ctf_integer(uint32_t, sequence_number, sequence_number_arg)
+    ctf_integer(uint64_t, queue_size, queue_size_arg)
+  )
+)
+
+// rmw_wait() returns, status being RMW_RET_OK or RMW_RET_TIMEOUT
+TRACEPOINT_EVENT(
+  TRACEPOINT_PROVIDER,
+  rmw_wait_wake,
+  TP_ARGS(
+    const void *, wait_set_handle_arg,
+    int, status_arg
+  ),
+  TP_FIELDS(
+    ctf_integer_hex(const void *, wait_set_handle, wait_set_handle_arg)
+    ctf_integer(int, status, status_arg)
+  )
+)
+
+// A publication taken from a subscription is to be deserialized into a message
+TRACEPOINT_EVENT(
+  TRACEPOINT_PROVIDER,
+  take_deserialize_start,
+  TP_ARGS(
+    const void *, listener_arg,
+    const uint8_t *, publication_uuid_arg,
+    uint32_t, sequence_number_arg,
+    const void *, message_arg,
+    uint64_t, size_arg
+  ),
+  TP_FIELDS(
+    ctf_integer_hex(const void *, listener, listener_arg)
+    ctf_array(uint8_t, publication_uuid, publication_uuid_arg, 16)
+    ctf_integer(uint32_t, sequence_number, sequence_number_arg)
+    ctf_integer_hex(const void *, message, message_arg)
+    ctf_integer(uint64_t, size, size_arg)
+  )
+)
+
+// The message is deserialized, or dropped if not taken
+TRACEPOINT_EVENT(
+  TRACEPOINT_PROVIDER,
+  take_deserialize_end,
+  TP_ARGS(
+    const void *, message_arg,
+    int, taken_arg
+  ),
+  TP_FIELDS(
+    ctf_integer_hex(const void *, message, message_arg)
+    ctf_integer(int, taken, taken_arg)
+  )
+)
+
+#endif  // RMW_DPS_CPP__TRACEPOINTS_H_
+
+#include <lttng/tracepoint-event.h>
@@ -0,0 +1,48 @@
+// Copyright 2018 Intel Corporation All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef RMW_DPS_CPP__TRACING_HPP_
+#define RMW_DPS_CPP__TRACING_HPP_
+
+#include <dps/dps.h>
+
+#include <cstdint>
+
+/// Trace an event of the rmw_dps_cpp LTTng provider, see rmw_dps_cpp/tracepoints.h.
+/**
+ * Built with RMW_DPS_CPP_TRACING, a tracepoint costs a branch while its
+ * event is not enabled in an LTTng session; built without it, and by
+ * default, tracepoints and the evaluation of their arguments are compiled
+ * out.
+ */
+#ifdef RMW_DPS_CPP_TRACING
+#include "rmw_dps_cpp/tracepoints.h"
+#define RMW_DPS_TRACEPOINT(event, ...) tracepoint(rmw_dps_cpp, event, __VA_ARGS__)
+#else
+#define RMW_DPS_TRACEPOINT(event, ...) ((void)0)
+#endif
+
+namespace rmw_dps_cpp
+{
+
+/// The 16 bytes of the UUID of a publication, as traced.
+inline const uint8_t *
+trace_uuid(const DPS_Publication * pub)
+{
+  return DPS_PublicationGetUUID(pub)->val;
+}
+
+}  // namespace rmw_dps_cpp
+
+#endif  // RMW_DPS_CPP__TRACING_HPP_
@@ -0,0 +1,70 @@
+// Copyright 2018 Intel Corporation All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef RMW_DPS_CPP__WAIT_FDS_HPP_
+#define RMW_DPS_CPP__WAIT_FDS_HPP_
+
+#include "rmw/macros.h"
+#include "rmw/types.h"
+#include "rmw/visibility_control.h"
+
+/*
+ * Each subscription, client, service and guard condition has a file
+ * descriptor that is readable while it has data to take, or while it has
+ * triggered, so executors may poll for them together with other file
+ * descriptors. The file descriptors may only be polled, not read or written,
+ * and are closed when their entity is destroyed. A triggered guard condition
+ * stays readable until rmw_wait() reports it.
+ */
+
+extern "C"
+{
+/// Get the file descriptor readable while a subscription has messages to take.
+/**
+ * \return RMW_RET_UNSUPPORTED if file descriptors are not supported on this platform.
+ */
+RMW_PUBLIC
+RMW_WARN_UNUSED
+rmw_ret_t
+rmw_dps_cpp_subscription_get_fd(const rmw_subscription_t * subscription, int * fd);
+
+/// Get the file descriptor readable while a client has responses to take.
+/**
+ * \return RMW_RET_UNSUPPORTED if file descriptors are not supported on this platform.
+ */
+RMW_PUBLIC
+RMW_WARN_UNUSED
+rmw_ret_t
+rmw_dps_cpp_client_get_fd(const rmw_client_t * client, int * fd);
+
+/// Get the file descriptor readable while a service has requests to take.
+/**
+ * \return RMW_RET_UNSUPPORTED if file descriptors are not supported on this platform.
+ */
+RMW_PUBLIC
+RMW_WARN_UNUSED
+rmw_ret_t
+rmw_dps_cpp_service_get_fd(const rmw_service_t * service, int * fd);
+
+/// Get the file descriptor readable while a guard condition has triggered.
+/**
+ * \return RMW_RET_UNSUPPORTED if file descriptors are not supported on this platform.
+ */
+RMW_PUBLIC
+RMW_WARN_UNUSED
+rmw_ret_t
+rmw_dps_cpp_guard_condition_get_fd(const rmw_guard_condition_t * guard_condition, int * fd);
+}  // extern "C"
+
+#endif  // RMW_DPS_CPP__WAIT_FDS_HPP_
@@ -0,0 +1,63 @@
+// Copyright 2018 Intel Corporation All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef RMW_DPS_CPP__WAIT_POLICY_HPP_
+#define RMW_DPS_CPP__WAIT_POLICY_HPP_
+
+#include <cstdint>
+
+#include "rmw/macros.h"
+#include "rmw/types.h"
+#include "rmw/visibility_control.h"
+
+namespace rmw_dps_cpp
+{
+
+/// The counters of the paths taken by rmw_wait() for a wait set.
+typedef struct WaitStatistics
+{
+  /// The waits that returned without waiting, an entity being ready or the timeout zero.
+  uint64_t immediate_count;
+  /// The waits that returned while spinning.
+  uint64_t spin_count;
+  /// The waits that blocked, after spinning if they did.
+  uint64_t block_count;
+} WaitStatistics;
+
+}  // namespace rmw_dps_cpp
+
+extern "C"
+{
+/// Spin for data for up to spin_period before blocking in rmw_wait().
+/**
+ * Spinning trades a CPU core for waking up within microseconds of data
+ * arriving, rather than after the wake up latency of blocking. A zero
+ * spin_period, the default unless set by RMW_DPS_WAIT_SPIN_PERIOD, blocks
+ * at once. Must not be called while the wait set is being waited on.
+ */
+RMW_PUBLIC
+RMW_WARN_UNUSED
+rmw_ret_t
+rmw_dps_cpp_wait_set_set_spin_period(rmw_wait_set_t * wait_set, rmw_time_t spin_period);
+
+/// Get the counters of the paths taken by rmw_wait() for a wait set.
+RMW_PUBLIC
+RMW_WARN_UNUSED
+rmw_ret_t
+rmw_dps_cpp_wait_set_get_statistics(
+  const rmw_wait_set_t * wait_set,
+  rmw_dps_cpp::WaitStatistics * statistics);
+}  // extern "C"
+
+#endif  // RMW_DPS_CPP__WAIT_POLICY_HPP_
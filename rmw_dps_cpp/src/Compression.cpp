@@ -0,0 +1,291 @@
+// Copyright 2018 Intel Corporation All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+#ifdef RMW_DPS_CPP_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+#include "rmw_dps_cpp/Compression.hpp"
+#include "rmw_dps_cpp/subscription_options.hpp"
+
+namespace rmw_dps_cpp
+{
+
+/*
+ * The LZ codec encodes a series of sequences, each a token byte, literals
+ * and a match. The high nibble of the token is the number of literals and
+ * the low nibble the length of the match less min_match; a nibble of 15 is
+ * followed by bytes adding to it up to and including the first byte that is
+ * not 255. The literals are followed by the little endian uint16 distance
+ * back to the match. The last sequence has literals only.
+ */
+static const size_t min_match = 4;
+static const size_t max_distance = 65535;
+static const size_t hash_bits = 14;
+// Matches stop short of the end so that the last sequence has literals
+static const size_t last_literals = 5;
+static const size_t match_limit = 12;
+
+static inline uint32_t
+read32(const uint8_t * p)
+{
+  uint32_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+static inline size_t
+hash(uint32_t v)
+{
+  return static_cast<uint32_t>(v * 2654435761u) >> (32 - hash_bits);
+}
+
+static void
+lz_write_length(std::vector<uint8_t> & out, size_t length)
+{
+  for (; length >= 255; length -= 255) {
+    out.push_back(255);
+  }
+  out.push_back(static_cast<uint8_t>(length));
+}
+
+static void
+lz_write_sequence(
+  std::vector<uint8_t> & out, const uint8_t * literals, size_t literals_size,
+  size_t distance, size_t match_size)
+{
+  size_t token = out.size();
+  out.push_back(static_cast<uint8_t>(std::min<size_t>(literals_size, 15) << 4));
+  if (literals_size >= 15) {
+    lz_write_length(out, literals_size - 15);
+  }
+  out.insert(out.end(), literals, literals + literals_size);
+  if (match_size) {
+    out.push_back(static_cast<uint8_t>(distance));
+    out.push_back(static_cast<uint8_t>(distance >> 8));
+    match_size -= min_match;
+    out[token] |= static_cast<uint8_t>(std::min<size_t>(match_size, 15));
+    if (match_size >= 15) {
+      lz_write_length(out, match_size - 15);
+    }
+  }
+}
+
+static bool
+lz_compress(const uint8_t * data, size_t size, std::vector<uint8_t> & out)
+{
+  size_t max_size = out.size() + size;
+  std::vector<uint32_t> table(size_t(1) << hash_bits, 0);
+  size_t anchor = 0;
+  size_t pos = 0;
+  size_t misses = 0;
+  while (size > match_limit && pos < size - match_limit) {
+    uint32_t v = read32(data + pos);
+    size_t h = hash(v);
+    size_t candidate = table[h];
+    table[h] = static_cast<uint32_t>(pos);
+    if (candidate >= pos || pos - candidate > max_distance || read32(data + candidate) != v) {
+      // Skip ahead faster through data that does not compress
+      pos += 1 + (misses++ >> 6);
+      continue;
+    }
+    size_t match_size = min_match;
+    while (pos + match_size < size - last_literals &&
+      data[candidate + match_size] == data[pos + match_size])
+    {
+      ++match_size;
+    }
+    lz_write_sequence(out, data + anchor, pos - anchor, pos - candidate, match_size);
+    if (out.size() >= max_size) {
+      return false;
+    }
+    pos += match_size;
+    anchor = pos;
+    misses = 0;
+  }
+  lz_write_sequence(out, data + anchor, size - anchor, 0, 0);
+  return out.size() < max_size;
+}
+
+static bool
+lz_read_length(const uint8_t * in, size_t in_size, size_t & pos, size_t & length)
+{
+  uint8_t b;
+  do {
+    if (pos == in_size) {
+      return false;
+    }
+    b = in[pos++];
+    length += b;
+  } while (b == 255);
+  return true;
+}
+
+static bool
+lz_decompress(const uint8_t * in, size_t in_size, uint8_t * out, size_t out_size)
+{
+  size_t ip = 0;
+  size_t op = 0;
+  while (ip < in_size) {
+    uint8_t token = in[ip++];
+    size_t literals_size = token >> 4;
+    if (literals_size == 15 && !lz_read_length(in, in_size, ip, literals_size)) {
+      return false;
+    }
+    if (literals_size > in_size - ip || literals_size > out_size - op) {
+      return false;
+    }
+    memcpy(out + op, in + ip, literals_size);
+    ip += literals_size;
+    op += literals_size;
+    if (ip == in_size) {
+      break;  // The last sequence
+    }
+    if (in_size - ip < 2) {
+      return false;
+    }
+    size_t distance = in[ip] | (in[ip + 1] << 8);
+    ip += 2;
+    size_t match_size = token & 15;
+    if (match_size == 15 && !lz_read_length(in, in_size, ip, match_size)) {
+      return false;
+    }
+    match_size += min_match;
+    if (distance == 0 || distance > op || match_size > out_size - op) {
+      return false;
+    }
+    const uint8_t * match = out + op - distance;
+    if (distance >= match_size) {
+      memcpy(out + op, match, match_size);
+    } else {
+      // The match overlaps what it repeats
+      for (size_t i = 0; i < match_size; ++i) {
+        out[op + i] = match[i];
+      }
+    }
+    op += match_size;
+  }
+  return op == out_size;
+}
+
+bool
+get_codec(const char * name, Codec & codec)
+{
+  if (!strcmp(name, "lz")) {
+    codec = Codec::LZ;
+    return true;
+  }
+#ifdef RMW_DPS_CPP_HAVE_ZSTD
+  if (!strcmp(name, "zstd")) {
+    codec = Codec::ZSTD;
+    return true;
+  }
+#endif
+  return false;
+}
+
+bool
+compress(Codec codec, const uint8_t * data, size_t size, std::vector<uint8_t> & compressed)
+{
+  if (size > std::numeric_limits<uint32_t>::max()) {
+    return false;
+  }
+  compressed.assign(compression_header_size, 0);
+  compressed[0] = 0xf7;
+  compressed[1] = 'C';
+  compressed[2] = 'M';
+  compressed[3] = 'P';
+  compressed[4] = static_cast<uint8_t>(codec);
+  for (size_t j = 0; j < 4; ++j) {
+    compressed[8 + j] = static_cast<uint8_t>(size >> (8 * j));
+  }
+  switch (codec) {
+    case Codec::LZ:
+      compressed.reserve(compression_header_size + size);
+      if (!lz_compress(data, size, compressed)) {
+        return false;
+      }
+      break;
+#ifdef RMW_DPS_CPP_HAVE_ZSTD
+    case Codec::ZSTD:
+      {
+        compressed.resize(compression_header_size + ZSTD_compressBound(size));
+        // The fastest level, as compressing is in the path of publishing
+        size_t n = ZSTD_compress(
+          compressed.data() + compression_header_size, compressed.size() - compression_header_size,
+          data, size, 1);
+        if (ZSTD_isError(n)) {
+          return false;
+        }
+        compressed.resize(compression_header_size + n);
+      }
+      break;
+#endif
+    default:
+      return false;
+  }
+  return compressed.size() < size;
+}
+
+bool
+decompress(cbor::RxStream & payload, size_t max_size)
+{
+  const uint8_t * data = payload.getBuffer();
+  size_t size = payload.getBufferSize();
+  if (!is_compressed(data, size)) {
+    return true;
+  }
+  size_t uncompressed_size = get_uncompressed_size(data);
+  if (uncompressed_size > (max_size ? max_size : default_max_payload_size)) {
+    return false;
+  }
+  uint8_t * buffer = static_cast<uint8_t *>(malloc(uncompressed_size ? uncompressed_size : 1));
+  if (!buffer) {
+    return false;
+  }
+  bool ret = false;
+  switch (static_cast<Codec>(data[4])) {
+    case Codec::LZ:
+      ret = lz_decompress(data + compression_header_size, size - compression_header_size,
+          buffer, uncompressed_size);
+      break;
+#ifdef RMW_DPS_CPP_HAVE_ZSTD
+    case Codec::ZSTD:
+      {
+        size_t n = ZSTD_decompress(buffer, uncompressed_size,
+            data + compression_header_size, size - compression_header_size);
+        ret = !ZSTD_isError(n) && n == uncompressed_size;
+      }
+      break;
+#endif
+    default:
+      break;
+  }
+  if (!ret) {
+    free(buffer);
+    return false;
+  }
+  size_t max_sequence_size = payload.getMaxSequenceSize();
+  payload = cbor::RxStream::adopt(buffer, uncompressed_size);
+  payload.setMaxSequenceSize(max_sequence_size);
+  return true;
+}
+
+}  // namespace rmw_dps_cpp
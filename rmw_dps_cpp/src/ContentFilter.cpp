@@ -0,0 +1,472 @@
+// Copyright 2018 Intel Corporation All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "rmw_dps_cpp/ContentFilter.hpp"
+
+namespace rmw_dps_cpp
+{
+
+FieldReader::~FieldReader()
+{
+}
+
+std::string
+to_topic_string(const FilterValue & value)
+{
+  if (value.type == FilterValue::STRING) {
+    return value.string;
+  }
+  char buf[64];
+  if (std::trunc(value.number) == value.number && std::fabs(value.number) < 1e19L) {
+    // Integers are formatted exactly, whatever type they were read from.
+    if (value.number < 0) {
+      snprintf(buf, sizeof(buf), "-%llu", static_cast<unsigned long long>(-value.number));
+    } else {
+      snprintf(buf, sizeof(buf), "%llu", static_cast<unsigned long long>(value.number));
+    }
+  } else {
+    snprintf(buf, sizeof(buf), "%.17Lg", value.number);
+  }
+  return buf;
+}
+
+struct ContentFilter::Node
+{
+  enum Op
+  {
+    AND,
+    OR,
+    NOT,
+    EQ,
+    NE,
+    LT,
+    LE,
+    GT,
+    GE
+  };
+  Op op;
+  std::unique_ptr<Node> lhs;
+  std::unique_ptr<Node> rhs;
+  /// The field compared.
+  size_t slot = 0;
+  /// The literal the field is compared to.
+  FilterValue value;
+};
+
+class ContentFilterParser
+{
+public:
+  ContentFilterParser(
+    ContentFilter & filter, const std::string & text, const std::vector<std::string> & parameters)
+  : filter_(filter), text_(text), parameters_(parameters), pos_(0)
+  {
+  }
+
+  std::unique_ptr<ContentFilter::Node>
+  parse()
+  {
+    next();
+    std::unique_ptr<ContentFilter::Node> node = parse_expression();
+    if (token_.kind != Token::END) {
+      error("unexpected '" + token_.text + "'");
+    }
+    return node;
+  }
+
+private:
+  typedef ContentFilter::Node Node;
+
+  struct Token
+  {
+    enum Kind
+    {
+      END,
+      FIELD,
+      NUMBER,
+      STRING,
+      PARAMETER,
+      OP,
+      LPAREN,
+      RPAREN,
+      AND,
+      OR,
+      NOT,
+      BOOLEAN
+    };
+    Kind kind = END;
+    std::string text;
+    FilterValue value;
+  };
+
+  struct Operand
+  {
+    bool is_field = false;
+    size_t slot = 0;
+    FilterValue value;
+  };
+
+  ContentFilter & filter_;
+  const std::string & text_;
+  const std::vector<std::string> & parameters_;
+  size_t pos_;
+  Token token_;
+
+  [[noreturn]] void
+  error(const std::string & what) const
+  {
+    throw std::invalid_argument("invalid filter expression \"" + text_ + "\": " + what);
+  }
+
+  void
+  next()
+  {
+    while (pos_ < text_.size() && isspace(static_cast<unsigned char>(text_[pos_]))) {
+      ++pos_;
+    }
+    token_ = Token();
+    if (pos_ == text_.size()) {
+      return;
+    }
+    size_t begin = pos_;
+    char c = text_[pos_];
+    if (isalpha(static_cast<unsigned char>(c)) || c == '_') {
+      while (pos_ < text_.size() &&
+        (isalnum(static_cast<unsigned char>(text_[pos_])) || text_[pos_] == '_' ||
+        text_[pos_] == '.'))
+      {
+        ++pos_;
+      }
+      token_.text = text_.substr(begin, pos_ - begin);
+      std::string keyword = token_.text;
+      std::transform(keyword.begin(), keyword.end(), keyword.begin(), ::toupper);
+      if (keyword == "AND") {
+        token_.kind = Token::AND;
+      } else if (keyword == "OR") {
+        token_.kind = Token::OR;
+      } else if (keyword == "NOT") {
+        token_.kind = Token::NOT;
+      } else if (keyword == "TRUE" || keyword == "FALSE") {
+        token_.kind = Token::BOOLEAN;
+        token_.value.type = FilterValue::NUMBER;
+        token_.value.number = keyword == "TRUE";
+      } else {
+        token_.kind = Token::FIELD;
+      }
+    } else if (isdigit(static_cast<unsigned char>(c)) || c == '-' || c == '+' || c == '.') {
+      const char * begin_ptr = text_.c_str() + begin;
+      char * end_ptr = nullptr;
+      token_.kind = Token::NUMBER;
+      token_.value.type = FilterValue::NUMBER;
+      token_.value.number = strtold(begin_ptr, &end_ptr);
+      if (end_ptr == begin_ptr) {
+        error("invalid number");
+      }
+      pos_ += end_ptr - begin_ptr;
+      token_.text = text_.substr(begin, pos_ - begin);
+    } else if (c == '\'' || c == '"') {
+      size_t end = text_.find(c, begin + 1);
+      if (end == std::string::npos) {
+        error("unterminated string");
+      }
+      token_.kind = Token::STRING;
+      token_.value.type = FilterValue::STRING;
+      token_.value.string = text_.substr(begin + 1, end - begin - 1);
+      pos_ = end + 1;
+      token_.text = text_.substr(begin, pos_ - begin);
+    } else if (c == '%') {
+      ++pos_;
+      while (pos_ < text_.size() && isdigit(static_cast<unsigned char>(text_[pos_]))) {
+        ++pos_;
+      }
+      token_.kind = Token::PARAMETER;
+      token_.text = text_.substr(begin, pos_ - begin);
+      if (token_.text.size() == 1) {
+        error("missing parameter index");
+      }
+    } else if (c == '(' || c == ')') {
+      token_.kind = c == '(' ? Token::LPAREN : Token::RPAREN;
+      token_.text = c;
+      ++pos_;
+    } else if (c == '=' || c == '!' || c == '<' || c == '>') {
+      ++pos_;
+      if (pos_ < text_.size() && (text_[pos_] == '=' || (c == '<' && text_[pos_] == '>'))) {
+        ++pos_;
+      }
+      token_.kind = Token::OP;
+      token_.text = text_.substr(begin, pos_ - begin);
+      if (token_.text == "!") {
+        error("unexpected '!'");
+      }
+    } else {
+      error(std::string("unexpected '") + c + "'");
+    }
+  }
+
+  std::unique_ptr<Node>
+  parse_expression()
+  {
+    std::unique_ptr<Node> node = parse_term();
+    while (token_.kind == Token::OR) {
+      next();
+      std::unique_ptr<Node> parent(new Node());
+      parent->op = Node::OR;
+      parent->lhs = std::move(node);
+      parent->rhs = parse_term();
+      node = std::move(parent);
+    }
+    return node;
+  }
+
+  std::unique_ptr<Node>
+  parse_term()
+  {
+    std::unique_ptr<Node> node = parse_factor();
+    while (token_.kind == Token::AND) {
+      next();
+      std::unique_ptr<Node> parent(new Node());
+      parent->op = Node::AND;
+      parent->lhs = std::move(node);
+      parent->rhs = parse_factor();
+      node = std::move(parent);
+    }
+    return node;
+  }
+
+  std::unique_ptr<Node>
+  parse_factor()
+  {
+    if (token_.kind == Token::NOT) {
+      next();
+      std::unique_ptr<Node> node(new Node());
+      node->op = Node::NOT;
+      node->lhs = parse_factor();
+      return node;
+    }
+    if (token_.kind == Token::LPAREN) {
+      next();
+      std::unique_ptr<Node> node = parse_expression();
+      if (token_.kind != Token::RPAREN) {
+        error("missing ')'");
+      }
+      next();
+      return node;
+    }
+    Operand lhs = parse_operand();
+    if (token_.kind != Token::OP) {
+      error("expected a comparison operator");
+    }
+    std::unique_ptr<Node> node(new Node());
+    node->op = comparison(token_.text);
+    next();
+    Operand rhs = parse_operand();
+    if (lhs.is_field == rhs.is_field) {
+      error("a comparison must be between a field and a literal");
+    }
+    if (!lhs.is_field) {
+      // Mirror the comparison so that the field is always on the left.
+      std::swap(lhs, rhs);
+      switch (node->op) {
+        case Node::LT:
+          node->op = Node::GT;
+          break;
+        case Node::LE:
+          node->op = Node::GE;
+          break;
+        case Node::GT:
+          node->op = Node::LT;
+          break;
+        case Node::GE:
+          node->op = Node::LE;
+          break;
+        default:
+          break;
+      }
+    }
+    node->slot = lhs.slot;
+    node->value = rhs.value;
+    return node;
+  }
+
+  Operand
+  parse_operand()
+  {
+    Operand operand;
+    switch (token_.kind) {
+      case Token::FIELD:
+        {
+          auto & fields = filter_.fields_;
+          auto it = std::find(fields.begin(), fields.end(), token_.text);
+          operand.is_field = true;
+          operand.slot = it - fields.begin();
+          if (it == fields.end()) {
+            fields.push_back(token_.text);
+          }
+        }
+        break;
+      case Token::NUMBER:
+      case Token::STRING:
+      case Token::BOOLEAN:
+        operand.value = token_.value;
+        break;
+      case Token::PARAMETER:
+        operand.value = parameter(strtoul(token_.text.c_str() + 1, nullptr, 10));
+        break;
+      default:
+        error(token_.kind == Token::END ? "unexpected end" : "unexpected '" + token_.text + "'");
+    }
+    next();
+    return operand;
+  }
+
+  FilterValue
+  parameter(size_t index) const
+  {
+    if (index >= parameters_.size()) {
+      error("missing parameter %" + std::to_string(index));
+    }
+    static const std::vector<std::string> no_parameters;
+    ContentFilterParser parser(filter_, parameters_[index], no_parameters);
+    parser.next();
+    Token literal = parser.token_;
+    parser.next();
+    if ((literal.kind != Token::NUMBER && literal.kind != Token::STRING &&
+      literal.kind != Token::BOOLEAN) || parser.token_.kind != Token::END)
+    {
+      error("parameter %" + std::to_string(index) + " is not a literal");
+    }
+    return literal.value;
+  }
+
+  static Node::Op
+  comparison(const std::string & op)
+  {
+    if (op == "=" || op == "==") {
+      return Node::EQ;
+    } else if (op == "<>" || op == "!=") {
+      return Node::NE;
+    } else if (op == "<") {
+      return Node::LT;
+    } else if (op == "<=") {
+      return Node::LE;
+    } else if (op == ">") {
+      return Node::GT;
+    }
+    return Node::GE;
+  }
+};
+
+ContentFilter::ContentFilter(
+  const std::string & expression, const std::vector<std::string> & parameters)
+{
+  expression_ = ContentFilterParser(*this, expression, parameters).parse();
+}
+
+ContentFilter::~ContentFilter()
+{
+}
+
+void
+ContentFilter::setReader(std::unique_ptr<FieldReader> reader)
+{
+  reader_ = std::move(reader);
+  check_types(*expression_);
+}
+
+bool
+ContentFilter::matches(uint8_t * payload, size_t len) const
+{
+  std::vector<FilterValue> values(fields_.size());
+  return reader_->read(payload, len, values) && evaluate(values);
+}
+
+void
+ContentFilter::check_types(const Node & node) const
+{
+  switch (node.op) {
+    case Node::AND:
+    case Node::OR:
+      check_types(*node.lhs);
+      check_types(*node.rhs);
+      break;
+    case Node::NOT:
+      check_types(*node.lhs);
+      break;
+    default:
+      if (reader_->types()[node.slot] != node.value.type) {
+        throw std::invalid_argument(
+                "field '" + fields_[node.slot] + "' is compared to a literal of another type");
+      }
+      break;
+  }
+}
+
+bool
+ContentFilter::evaluate(const std::vector<FilterValue> & values) const
+{
+  return evaluate(*expression_, values);
+}
+
+bool
+ContentFilter::evaluate(const Node & node, const std::vector<FilterValue> & values) const
+{
+  switch (node.op) {
+    case Node::AND:
+      return evaluate(*node.lhs, values) && evaluate(*node.rhs, values);
+    case Node::OR:
+      return evaluate(*node.lhs, values) || evaluate(*node.rhs, values);
+    case Node::NOT:
+      return !evaluate(*node.lhs, values);
+    default:
+      break;
+  }
+
+  const FilterValue & value = values[node.slot];
+  int order = 0;
+  if (value.type != node.value.type) {
+    return false;
+  } else if (value.type == FilterValue::STRING) {
+    order = value.string.compare(node.value.string);
+  } else if (std::isnan(value.number) || std::isnan(node.value.number)) {
+    return node.op == Node::NE;
+  } else {
+    order = value.number < node.value.number ? -1 : value.number > node.value.number;
+  }
+  switch (node.op) {
+    case Node::EQ:
+      return order == 0;
+    case Node::NE:
+      return order != 0;
+    case Node::LT:
+      return order < 0;
+    case Node::LE:
+      return order <= 0;
+    case Node::GT:
+      return order > 0;
+    default:
+      return order >= 0;
+  }
+}
+
+}  // namespace rmw_dps_cpp
@@ -23,4 +23,5 @@ const char * const dps_subscriber_prefix = "subscriber&topic=";
 const char * const dps_publisher_prefix = "publisher&topic=";
 const char * const dps_service_prefix = "service&topic=";
 const char * const dps_client_prefix = "client&topic=";
+const char * const dps_formats_prefix = "formats=";
 }  // extern "C"
@@ -12,8 +12,25 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+#include "rmw_dps_cpp/Fragment.hpp"
+#include "rmw_dps_cpp/tracing.hpp"
+
 #include "publish_common.hpp"
 
+static size_t
+_size(const DPS_Buffer * bufs, size_t numBufs)
+{
+  size_t size = 0;
+  for (size_t i = 0; i < numBufs; ++i) {
+    size += bufs[i].len;
+  }
+  return size;
+}
+
 void
 _published(
   DPS_Publication * pub,
@@ -25,6 +42,8 @@ _published(
   (void)pub;
   (void)bufs;
   (void)numBufs;
+  RMW_DPS_TRACEPOINT(published, rmw_dps_cpp::trace_uuid(pub), DPS_PublicationGetSequenceNum(pub),
+    _size(bufs, numBufs), status);
   DPS_SignalEvent(reinterpret_cast<DPS_Event *>(data), status);
 }
 
@@ -32,14 +51,72 @@ DPS_Status
 publish(DPS_Publication * pub, const uint8_t * data, size_t size)
 {
   DPS_Buffer buf = {const_cast<uint8_t *>(data), size};
+  return publish(pub, &buf, 1);
+}
+
+DPS_Status
+publish(DPS_Publication * pub, const DPS_Buffer * bufs, size_t numBufs)
+{
   DPS_Event * event = DPS_CreateEvent();
   if (!event) {
     return DPS_ERR_RESOURCES;
   }
-  DPS_Status ret = DPS_PublishBufs(pub, &buf, 1, 0, _published, event);
+  DPS_Status ret = DPS_PublishBufs(pub, bufs, numBufs, 0, _published, event);
   if (ret == DPS_OK) {
     ret = DPS_WaitForEvent(event);
   }
   DPS_DestroyEvent(event);
   return ret;
 }
+
+DPS_Status
+publish(
+  DPS_Publication * pub, const DPS_Buffer * bufs, size_t numBufs, size_t fragmentSize,
+  uint32_t messageId, rmw_dps_cpp::Pacer * pacer)
+{
+  size_t size = _size(bufs, numBufs);
+  if (size <= fragmentSize) {
+    if (pacer) {
+      pacer->acquire(size);
+    }
+    return publish(pub, bufs, numBufs);
+  }
+  if (size > std::numeric_limits<uint32_t>::max()) {
+    return DPS_ERR_OVERFLOW;
+  }
+
+  uint8_t header[rmw_dps_cpp::fragment_header_size];
+  std::vector<DPS_Buffer> fragment;
+  size_t buf = 0;
+  size_t bufOffset = 0;
+  for (size_t offset = 0; offset < size; ) {
+    rmw_dps_cpp::encode_fragment_header(
+      {messageId, static_cast<uint32_t>(size), static_cast<uint32_t>(offset)}, header);
+    fragment.clear();
+    fragment.push_back({header, sizeof(header)});
+    // The slice of bufs following offset, without copying it
+    size_t fragmentLen = std::min(fragmentSize, size - offset);
+    size_t remaining = fragmentLen;
+    offset += fragmentLen;
+    while (remaining) {
+      size_t len = std::min(remaining, bufs[buf].len - bufOffset);
+      if (len) {
+        fragment.push_back({bufs[buf].base + bufOffset, len});
+      }
+      remaining -= len;
+      bufOffset += len;
+      if (bufOffset == bufs[buf].len) {
+        ++buf;
+        bufOffset = 0;
+      }
+    }
+    if (pacer) {
+      pacer->acquire(sizeof(header) + fragmentLen);
+    }
+    DPS_Status ret = publish(pub, fragment.data(), fragment.size());
+    if (ret != DPS_OK) {
+      return ret;
+    }
+  }
+  return DPS_OK;
+}
@@ -18,7 +18,24 @@
 #include <dps/dps.h>
 #include <dps/event.h>
 
+#include "rmw_dps_cpp/Pacer.hpp"
+
 DPS_Status
 publish(DPS_Publication * pub, const uint8_t * data, size_t size);
 
+/// Publish the concatenation of bufs, which need only remain valid until this returns.
+DPS_Status
+publish(DPS_Publication * pub, const DPS_Buffer * bufs, size_t numBufs);
+
+/// Publish the concatenation of bufs, in fragments of at most fragmentSize bytes if larger.
+/**
+ * See rmw_dps_cpp::FragmentHeader; messageId must differ from the ids of
+ * the other fragmented messages recently published with pub. Each
+ * publication waits for pacer, if not null.
+ */
+DPS_Status
+publish(
+  DPS_Publication * pub, const DPS_Buffer * bufs, size_t numBufs, size_t fragmentSize,
+  uint32_t messageId, rmw_dps_cpp::Pacer * pacer);
+
 #endif  // PUBLISH_COMMON_HPP_
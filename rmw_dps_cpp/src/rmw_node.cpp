@@ -26,8 +26,10 @@
 #include "rmw/rmw.h"
 
 #include "rmw_dps_cpp/custom_node_info.hpp"
+#include "rmw_dps_cpp/discovery_statistics.hpp"
 #include "rmw_dps_cpp/identifier.hpp"
 #include "rmw_dps_cpp/names_common.hpp"
+#include "rmw_dps_cpp/serialization_format.hpp"
 
 rmw_ret_t
 _publish_discovery_payload(CustomNodeInfo * impl)
@@ -41,6 +43,8 @@ _publish_discovery_payload(CustomNodeInfo * impl)
   DPS_Status status = DPS_DiscoveryPublish(impl->discovery_svc_, ser.data(), ser.size(),
       NodeListener::onDiscovery);
   if (status == DPS_OK) {
+    ++impl->discovery_published_count_;
+    impl->discovery_published_bytes_ += ser.size();
     return RMW_RET_OK;
   } else {
     RMW_SET_ERROR_MSG_WITH_FORMAT_STRING("failed to publish to discovery - %s", DPS_ErrTxt(status));
@@ -243,6 +247,9 @@ create_node(
 
   discovery_topics.push_back(dps_namespace_prefix + std::string(namespace_));
   discovery_topics.push_back(dps_name_prefix + std::string(name));
+  // Older peers ignore this, so publishers treat their absence as "cbor" only
+  discovery_topics.push_back(dps_formats_prefix + std::string(intel_dps_serialization_format) +
+    "," + intel_dps_cdr_serialization_format);
   if (_add_discovery_topics(node_impl, discovery_topics) != RMW_RET_OK) {
     goto fail;
   }
@@ -337,4 +344,24 @@ rmw_node_get_graph_guard_condition(const rmw_node_t * node)
   }
   return impl->graph_guard_condition_;
 }
+
+rmw_ret_t
+rmw_dps_cpp_node_get_discovery_statistics(
+  const rmw_node_t * node,
+  rmw_dps_cpp::DiscoveryStatistics * statistics)
+{
+  RMW_CHECK_ARGUMENT_FOR_NULL(node, RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_ARGUMENT_FOR_NULL(statistics, RMW_RET_INVALID_ARGUMENT);
+
+  if (node->implementation_identifier != intel_dps_identifier) {
+    RMW_SET_ERROR_MSG("node handle not from this implementation");
+    return RMW_RET_ERROR;
+  }
+
+  auto impl = static_cast<CustomNodeInfo *>(node->data);
+  statistics->published_count = impl->discovery_published_count_;
+  statistics->published_bytes = impl->discovery_published_bytes_;
+  impl->listener_->get_statistics(*statistics);
+  return RMW_RET_OK;
+}
 }  // extern "C"
@@ -13,6 +13,10 @@
 // limitations under the License.
 
 #include <cassert>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <vector>
 
 #include "rcutils/logging_macros.h"
 
@@ -20,10 +24,158 @@
 #include "rmw/rmw.h"
 
 #include "rmw_dps_cpp/CborStream.hpp"
+#include "rmw_dps_cpp/CdrStream.hpp"
+#include "rmw_dps_cpp/Compression.hpp"
+#include "rmw_dps_cpp/Delta.hpp"
+#include "rmw_dps_cpp/custom_node_info.hpp"
 #include "rmw_dps_cpp/custom_publisher_info.hpp"
 #include "rmw_dps_cpp/identifier.hpp"
+#include "rmw_dps_cpp/serialization_format.hpp"
+#include "rmw_dps_cpp/tracing.hpp"
 #include "publish_common.hpp"
 #include "ros_message_serialization.hpp"
+#include "topic_keys.hpp"
+
+// Arrays at least this large are sent from the message instead of being serialized into a copy
+static const size_t min_reference_size = 4096;
+
+/// Return false if no subscription can receive what the publisher sends.
+static bool
+_is_matched(CustomPublisherInfo * info, const char * topic_name)
+{
+  if (info->publish_unmatched_ || info->subscriptions_matched_count_.load()) {
+    return true;
+  }
+  // Subscriptions may exist before they are discovered
+  auto now = std::chrono::steady_clock::now();
+  if (now - info->unmatched_since_.load() < info->unmatched_grace_period_) {
+    return true;
+  }
+  auto impl = static_cast<CustomNodeInfo *>(info->node_->data);
+  {
+    std::lock_guard<std::mutex> lock(impl->subscribers_mutex_);
+    auto it = impl->subscribers_.find(topic_name);
+    if (it != impl->subscribers_.end() && !it->second.empty()) {
+      return true;
+    }
+  }
+  // Keep sending one message per grace period for those that join later
+  auto sent = info->unmatched_sent_.load();
+  return now - sent >= info->unmatched_grace_period_ &&
+         info->unmatched_sent_.compare_exchange_strong(sent, now);
+}
+
+/// Compress a serialized message if the publisher compresses messages of its size.
+/**
+ * \return false if the message is to be sent uncompressed.
+ */
+static bool
+_compress(
+  CustomPublisherInfo * info, const uint8_t * data, size_t size,
+  std::vector<uint8_t> & compressed)
+{
+  return info->compression_ != rmw_dps_cpp::Codec::NONE &&
+         size >= info->compression_threshold_ &&
+         rmw_dps_cpp::compress(info->compression_, data, size, compressed);
+}
+
+/// Publish a serialized message, delta encoded and compressed as the publisher is configured to.
+/**
+ * buffers.bufs is the serialized message, and must be a single buffer when
+ * the publisher delta encodes or compresses messages.
+ */
+static rmw_ret_t
+_publish(CustomPublisherInfo * info, DPS_Publication * pub, PublishBuffers & buffers)
+{
+  std::vector<DPS_Buffer> & bufs = buffers.bufs;
+  rmw_dps_cpp::DeltaEncoder * encoder = _get_delta_encoder(info, pub);
+  std::unique_lock<std::mutex> lock;
+  uint8_t header[rmw_dps_cpp::delta_header_size];
+
+  if (encoder) {
+    lock = std::unique_lock<std::mutex>(encoder->mutex());
+    rmw_dps_cpp::DeltaHeader delta_header =
+      encoder->encode(bufs[0].base, bufs[0].len, buffers.delta);
+    DPS_Buffer body = bufs[0];
+    if (!(delta_header.flags & rmw_dps_cpp::DeltaHeader::KEYFRAME)) {
+      body = DPS_Buffer{buffers.delta.data(), buffers.delta.size()};
+    }
+    if (_compress(info, body.base, body.len, buffers.compressed)) {
+      body = DPS_Buffer{buffers.compressed.data(), buffers.compressed.size()};
+      delta_header.flags |= rmw_dps_cpp::DeltaHeader::COMPRESSED;
+    }
+    rmw_dps_cpp::encode_delta_header(delta_header, header);
+    bufs.resize(2);
+    bufs[0] = DPS_Buffer{header, sizeof(header)};
+    bufs[1] = body;
+  } else if (bufs.size() == 1 && _compress(info, bufs[0].base, bufs[0].len, buffers.compressed)) {
+    bufs[0] = DPS_Buffer{buffers.compressed.data(), buffers.compressed.size()};
+  }
+  DPS_Status status = publish(pub, bufs.data(), bufs.size(), info->max_fragment_size_,
+      info->fragmented_message_id_++, info->pacer_.get());
+  if (status != DPS_OK) {
+    RMW_SET_ERROR_MSG_WITH_FORMAT_STRING("cannot publish data - %s", DPS_ErrTxt(status));
+    return RMW_RET_ERROR;
+  }
+  return RMW_RET_OK;
+}
+
+/// Call publish_with with the buffers of the publisher.
+/**
+ * A publish that finds them in use by another uses buffers of its own
+ * rather than wait for the other's send to complete.
+ */
+template<typename Function>
+static rmw_ret_t
+_with_publish_buffers(CustomPublisherInfo * info, Function publish_with)
+{
+  std::unique_lock<std::mutex> lock(info->publish_buffers_mutex_, std::try_to_lock);
+  if (lock.owns_lock()) {
+    return publish_with(info->publish_buffers_);
+  }
+  PublishBuffers buffers;
+  return publish_with(buffers);
+}
+
+template<typename Stream>
+static rmw_ret_t
+_publish(
+  CustomPublisherInfo * info, const void * ros_message, Stream & ser, PublishBuffers & buffers)
+{
+  ser.clear();
+  // Key fields are read from, and delta encoding and compression read, the
+  // serialized message, which must then be contiguous
+  if (!info->key_reader_ && !info->keyframe_interval_ &&
+    info->compression_ == rmw_dps_cpp::Codec::NONE)
+  {
+    ser.setMinReferenceSize(min_reference_size);
+  }
+  if (!_serialize_ros_message(ros_message, ser, info->type_support_,
+    info->typesupport_identifier_))
+  {
+    RMW_SET_ERROR_MSG("cannot serialize data");
+    return RMW_RET_ERROR;
+  }
+  std::shared_ptr<DPS_Publication> hold;
+  DPS_Publication * pub = _get_keyed_publication(info, ser.data(), ser.size(), hold);
+  if (!pub) {
+    return RMW_RET_ERROR;  // Error message already set
+  }
+  RMW_DPS_TRACEPOINT(serialized, ros_message, rmw_dps_cpp::trace_uuid(pub), ser.size());
+  ser.buffers(buffers.bufs);
+  return _publish(info, pub, buffers);
+}
+
+static rmw_ret_t
+_publish(CustomPublisherInfo * info, const void * ros_message)
+{
+  return _with_publish_buffers(info, [info, ros_message](PublishBuffers & buffers) {
+        if (info->serialization_format_ == intel_dps_cdr_serialization_format) {
+          return _publish(info, ros_message, buffers.cdr, buffers);
+        }
+        return _publish(info, ros_message, buffers.cbor, buffers);
+      });
+}
 
 extern "C"
 {
@@ -39,7 +191,6 @@ rmw_publish(
     "%s(publisher=%p,ros_message=%p,allocation=%p)",
     __FUNCTION__, (void *)publisher, (void *)ros_message, (void *)allocation);
 
-  rmw_ret_t returnedValue = RMW_RET_ERROR;
   RCUTILS_CHECK_FOR_NULL_WITH_MSG(publisher, "publisher pointer is null", return RMW_RET_ERROR);
   RCUTILS_CHECK_FOR_NULL_WITH_MSG(
     ros_message, "ros_message pointer is null", return RMW_RET_ERROR);
@@ -52,22 +203,11 @@ rmw_publish(
   auto info = static_cast<CustomPublisherInfo *>(publisher->data);
   assert(info);
 
-  rmw_dps_cpp::cbor::TxStream ser;
-
-  if (_serialize_ros_message(ros_message, ser, info->type_support_,
-    info->typesupport_identifier_))
-  {
-    DPS_Status status = publish(info->publication_, ser.data(), ser.size());
-    if (status == DPS_OK) {
-      returnedValue = RMW_RET_OK;
-    } else {
-      RMW_SET_ERROR_MSG_WITH_FORMAT_STRING("cannot publish data - %s", DPS_ErrTxt(status));
-    }
-  } else {
-    RMW_SET_ERROR_MSG("cannot serialize data");
+  RMW_DPS_TRACEPOINT(rmw_publish, publisher, ros_message);
+  if (!_is_matched(info, publisher->topic_name)) {
+    return RMW_RET_OK;
   }
-
-  return returnedValue;
+  return _publish(info, ros_message);
 }
 
 rmw_ret_t
@@ -94,14 +234,20 @@ rmw_publish_serialized_message(
   RCUTILS_CHECK_FOR_NULL_WITH_MSG(
     info, "publisher info pointer is null", return RMW_RET_ERROR);
 
-  DPS_Status status = publish(info->publication_, serialized_message->buffer,
-      serialized_message->buffer_length);
-  if (status != DPS_OK) {
-    RMW_SET_ERROR_MSG_WITH_FORMAT_STRING("cannot publish data - %s", DPS_ErrTxt(status));
-    return RMW_RET_ERROR;
+  if (!_is_matched(info, publisher->topic_name)) {
+    return RMW_RET_OK;
   }
-
-  return RMW_RET_OK;
+  std::shared_ptr<DPS_Publication> hold;
+  DPS_Publication * pub = _get_keyed_publication(info, serialized_message->buffer,
+      serialized_message->buffer_length, hold);
+  if (!pub) {
+    return RMW_RET_ERROR;  // Error message already set
+  }
+  return _with_publish_buffers(info, [info, pub, serialized_message](PublishBuffers & buffers) {
+        buffers.bufs.assign(
+          1, DPS_Buffer{serialized_message->buffer, serialized_message->buffer_length});
+        return _publish(info, pub, buffers);
+      });
 }
 
 rmw_ret_t
@@ -110,11 +256,35 @@ rmw_publish_loaned_message(
   void * ros_message,
   rmw_publisher_allocation_t * allocation)
 {
-  (void) publisher;
-  (void) ros_message;
-  (void) allocation;
+  (void)allocation;
+  RCUTILS_LOG_DEBUG_NAMED(
+    "rmw_dps_cpp",
+    "%s(publisher=%p,ros_message=%p,allocation=%p)",
+    __FUNCTION__, (void *)publisher, (void *)ros_message, (void *)allocation);
+
+  RCUTILS_CHECK_FOR_NULL_WITH_MSG(publisher, "publisher pointer is null", return RMW_RET_ERROR);
+  RCUTILS_CHECK_FOR_NULL_WITH_MSG(
+    ros_message, "ros_message pointer is null", return RMW_RET_ERROR);
+
+  if (publisher->implementation_identifier != intel_dps_identifier) {
+    RMW_SET_ERROR_MSG("publisher handle not from this implementation");
+    return RMW_RET_ERROR;
+  }
 
-  RMW_SET_ERROR_MSG("rmw_publish_loaned_message not implemented for rmw_dps_cpp");
-  return RMW_RET_UNSUPPORTED;
+  auto info = static_cast<CustomPublisherInfo *>(publisher->data);
+  assert(info);
+
+  if (!info->loan_pool_ || !info->loan_pool_->owns(ros_message)) {
+    RMW_SET_ERROR_MSG("message not loaned by this publisher");
+    return RMW_RET_ERROR;
+  }
+  // The message has been sent when publishing returns, so the loan ends here
+  // whether or not publishing succeeded.
+  rmw_ret_t ret = RMW_RET_OK;
+  if (_is_matched(info, publisher->topic_name)) {
+    ret = _publish(info, ros_message);
+  }
+  info->loan_pool_->giveBack(ros_message);
+  return ret;
 }
 }  // extern "C"
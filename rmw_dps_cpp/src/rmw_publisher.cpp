@@ -12,8 +12,13 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <limits>
 #include <string>
 
+#include "rcutils/get_env.h"
 #include "rcutils/logging_macros.h"
 
 #include "rmw/allocators.h"
@@ -21,12 +26,49 @@
 #include "rmw/rmw.h"
 
 #include "rmw_dps_cpp/custom_node_info.hpp"
+#include "rmw_dps_cpp/Compression.hpp"
+#include "rmw_dps_cpp/Fragment.hpp"
 #include "rmw_dps_cpp/custom_publisher_info.hpp"
 #include "rmw_dps_cpp/identifier.hpp"
 #include "rmw_dps_cpp/names_common.hpp"
+#include "rmw_dps_cpp/pacing_statistics.hpp"
+#include "rmw_dps_cpp/publisher_options.hpp"
+#include "rmw_dps_cpp/serialization_format.hpp"
 #include "qos_common.hpp"
+#include "ros_message_serialization.hpp"
+#include "topic_keys.hpp"
 #include "type_support_common.hpp"
 
+// The number of loaned messages when the QoS depth is unspecified
+static const size_t default_loan_pool_size = 10;
+// Leaves room for the DPS headers within the largest UDP datagram
+static const size_t default_max_fragment_size = 32768;
+// Longer than it takes to discover the subscriptions of a new publisher
+static const size_t default_unmatched_grace_period = 2000;
+// Smaller messages seldom shrink by more than the cost of compressing them
+static const size_t default_compression_threshold = 1024;
+// Enough for the key values of a fleet of robots
+static const size_t default_max_keyed_publications = 256;
+
+/// Read the default bandwidth limit of publishers, zero if unlimited.
+static bool
+_get_env_max_bandwidth(size_t * max_bandwidth)
+{
+  const char * value = nullptr;
+  *max_bandwidth = 0;
+  if (rcutils_get_env("RMW_DPS_MAX_BANDWIDTH", &value) || !*value) {
+    return true;
+  }
+  char * end = nullptr;
+  errno = 0;
+  unsigned long long n = strtoull(value, &end, 10);  // NOLINT(runtime/int)
+  if (errno || *end || n > std::numeric_limits<size_t>::max()) {
+    return false;
+  }
+  *max_bandwidth = static_cast<size_t>(n);
+  return true;
+}
+
 extern "C"
 {
 rmw_ret_t
@@ -118,11 +160,57 @@ rmw_create_publisher(
   const char * topic = dps_topic.c_str();
   rmw_publisher_t * rmw_publisher = nullptr;
   rmw_dps_cpp::cbor::TxStream ser;
+  rmw_dps_cpp::PublisherOptions options = {};
+  const char * serialization_format = nullptr;
+  size_t max_bandwidth = 0;
+  rmw_dps_cpp::Codec compression = rmw_dps_cpp::Codec::NONE;
   DPS_Status ret;
 
+  if (publisher_options && publisher_options->rmw_specific_publisher_payload) {
+    options = *static_cast<const rmw_dps_cpp::PublisherOptions *>(
+      publisher_options->rmw_specific_publisher_payload);
+  }
+  serialization_format = _get_serialization_format(options.serialization_format);
+  if (!serialization_format) {
+    RMW_SET_ERROR_MSG("unknown serialization format");
+    return nullptr;
+  }
+  max_bandwidth = options.max_bandwidth;
+  if (!max_bandwidth && !_get_env_max_bandwidth(&max_bandwidth)) {
+    RMW_SET_ERROR_MSG("invalid RMW_DPS_MAX_BANDWIDTH");
+    return nullptr;
+  }
+  if (options.compression && *options.compression &&
+    !rmw_dps_cpp::get_codec(options.compression, compression))
+  {
+    RMW_SET_ERROR_MSG_WITH_FORMAT_STRING("unsupported compression '%s'", options.compression);
+    return nullptr;
+  }
+
   info = new CustomPublisherInfo();
   info->node_ = node;
   info->typesupport_identifier_ = type_support->typesupport_identifier;
+  info->serialization_format_ = serialization_format;
+  info->dps_topic_name_ = dps_topic;
+  info->max_fragment_size_ =
+    options.max_fragment_size ? options.max_fragment_size : default_max_fragment_size;
+  info->publish_unmatched_ = options.publish_unmatched;
+  info->unmatched_grace_period_ = std::chrono::milliseconds(
+    options.unmatched_grace_period ?
+    options.unmatched_grace_period : default_unmatched_grace_period);
+  info->unmatched_since_.store(std::chrono::steady_clock::now());
+  info->unmatched_sent_.store(info->unmatched_since_.load());
+  info->compression_ = compression;
+  info->compression_threshold_ = options.compression_threshold ?
+    options.compression_threshold : default_compression_threshold;
+  info->keyframe_interval_ = options.keyframe_interval;
+  info->max_keyed_publications_ = options.max_keyed_publications ?
+    options.max_keyed_publications : default_max_keyed_publications;
+  if (max_bandwidth) {
+    // A full bucket lets a whole fragment leave at once
+    info->pacer_.reset(new rmw_dps_cpp::Pacer(
+        max_bandwidth, info->max_fragment_size_ + rmw_dps_cpp::fragment_header_size));
+  }
 
   std::string type_name = _create_type_name(
     type_support->data, info->typesupport_identifier_);
@@ -131,6 +219,21 @@ rmw_create_publisher(
         info->typesupport_identifier_);
     _register_type(impl->node_, info->type_support_, info->typesupport_identifier_);
   }
+  if (options.key_fields && *options.key_fields) {
+    info->key_reader_ = _create_key_reader(
+      options.key_fields, info->type_support_, info->typesupport_identifier_);
+    if (!info->key_reader_) {
+      goto fail;  // Error message already set
+    }
+  }
+  if (options.loan_messages) {
+    info->loan_pool_ = _create_message_pool(
+      qos_policies->depth ? qos_policies->depth : default_loan_pool_size,
+      info->type_support_, info->typesupport_identifier_);
+    if (!info->loan_pool_) {
+      goto fail;  // Error message already set
+    }
+  }
 
   info->qos_ = *qos_policies;
   /* Set to best-effort & volatile since QoS features are not supported by DPS at the moment. */
@@ -143,7 +246,7 @@ rmw_create_publisher(
     RMW_SET_ERROR_MSG("failed to create publication");
     goto fail;
   }
-  ret = DPS_InitPublication(info->publication_, &topic, 1, DPS_TRUE, nullptr);
+  ret = _init_publication(info, info->publication_, &topic, 1);
   if (ret != DPS_OK) {
     RMW_SET_ERROR_MSG("failed to initialize publication");
     goto fail;
@@ -156,6 +259,7 @@ rmw_create_publisher(
   }
   rmw_publisher->implementation_identifier = intel_dps_identifier;
   rmw_publisher->data = info;
+  rmw_publisher->can_loan_messages = info->loan_pool_ != nullptr;
   rmw_publisher->topic_name = reinterpret_cast<char *>(
     rmw_allocate(strlen(topic_name) + 1));
   if (!rmw_publisher->topic_name) {
@@ -164,6 +268,7 @@ rmw_create_publisher(
   }
   memcpy(const_cast<char *>(rmw_publisher->topic_name), topic_name, strlen(topic_name) + 1);
 
+  // The serialization format is not advertised, subscriptions tell it from each payload
   info->discovery_name_ = dps_publisher_prefix + std::string(topic_name) +
     "&types=" + type_name;
   if (_add_discovery_topic(impl, info->discovery_name_) != RMW_RET_OK) {
@@ -171,13 +276,17 @@ rmw_create_publisher(
   }
 
   {
+    // Subscriptions discovered before the publisher was created are matched here
     std::lock_guard<std::mutex> lock(impl->publishers_mutex_);
+    info->subscriptions_ = impl->listener_->get_subscriber_uuids(topic_name, info);
+    info->subscriptions_matched_count_.store(info->subscriptions_.size());
     impl->publishers_[topic_name].insert(info);
   }
   return rmw_publisher;
 
 fail:
   _delete_typesupport(info->type_support_, info->typesupport_identifier_);
+  _destroy_keyed_publications(info);
   if (info->publication_) {
     DPS_DestroyPublication(info->publication_, nullptr);
   }
@@ -250,6 +359,7 @@ rmw_destroy_publisher(rmw_node_t * node, rmw_publisher_t * publisher)
       impl->publishers_[publisher->topic_name].erase(info);
     }
     _remove_discovery_topic(impl, info->discovery_name_);
+    _destroy_keyed_publications(info);
     if (info->publication_) {
       DPS_DestroyPublication(info->publication_, nullptr);
     }
@@ -293,12 +403,31 @@ rmw_borrow_loaned_message(
   const rosidl_message_type_support_t * type_support,
   void ** ros_message)
 {
-  (void) publisher;
-  (void) type_support;
-  (void) ros_message;
+  RCUTILS_LOG_DEBUG_NAMED(
+    "rmw_dps_cpp",
+    "%s(publisher=%p,type_support=%p,ros_message=%p)", __FUNCTION__, (void *)publisher,
+    (void *)type_support, (void *)ros_message);
+
+  RMW_CHECK_ARGUMENT_FOR_NULL(publisher, RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_ARGUMENT_FOR_NULL(type_support, RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_ARGUMENT_FOR_NULL(ros_message, RMW_RET_INVALID_ARGUMENT);
 
-  RMW_SET_ERROR_MSG("rmw_borrow_loaned_message not implemented for rmw_dps_cpp");
-  return RMW_RET_UNSUPPORTED;
+  if (publisher->implementation_identifier != intel_dps_identifier) {
+    RMW_SET_ERROR_MSG("publisher handle not from this implementation");
+    return RMW_RET_ERROR;
+  }
+
+  auto info = static_cast<CustomPublisherInfo *>(publisher->data);
+  if (!info->loan_pool_) {
+    RMW_SET_ERROR_MSG("publisher does not lend messages");
+    return RMW_RET_UNSUPPORTED;
+  }
+  *ros_message = info->loan_pool_->borrow();
+  if (!*ros_message) {
+    RMW_SET_ERROR_MSG("all loaned messages are in use");
+    return RMW_RET_ERROR;
+  }
+  return RMW_RET_OK;
 }
 
 rmw_ret_t
@@ -306,11 +435,45 @@ rmw_return_loaned_message_from_publisher(
   const rmw_publisher_t * publisher,
   void * loaned_message)
 {
-  (void) publisher;
-  (void) loaned_message;
+  RCUTILS_LOG_DEBUG_NAMED(
+    "rmw_dps_cpp",
+    "%s(publisher=%p,loaned_message=%p)", __FUNCTION__, (void *)publisher, loaned_message);
+
+  RMW_CHECK_ARGUMENT_FOR_NULL(publisher, RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_ARGUMENT_FOR_NULL(loaned_message, RMW_RET_INVALID_ARGUMENT);
+
+  if (publisher->implementation_identifier != intel_dps_identifier) {
+    RMW_SET_ERROR_MSG("publisher handle not from this implementation");
+    return RMW_RET_ERROR;
+  }
 
-  RMW_SET_ERROR_MSG(
-    "rmw_return_loaned_message_from_publisher not implemented for rmw_dps_cpp");
-  return RMW_RET_UNSUPPORTED;
+  auto info = static_cast<CustomPublisherInfo *>(publisher->data);
+  if (!info->loan_pool_ || !info->loan_pool_->giveBack(loaned_message)) {
+    RMW_SET_ERROR_MSG("message not loaned by this publisher");
+    return RMW_RET_ERROR;
+  }
+  return RMW_RET_OK;
+}
+
+rmw_ret_t
+rmw_dps_cpp_publisher_get_pacing_statistics(
+  const rmw_publisher_t * publisher,
+  rmw_dps_cpp::PacingStatistics * statistics)
+{
+  RMW_CHECK_ARGUMENT_FOR_NULL(publisher, RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_ARGUMENT_FOR_NULL(statistics, RMW_RET_INVALID_ARGUMENT);
+
+  if (publisher->implementation_identifier != intel_dps_identifier) {
+    RMW_SET_ERROR_MSG("publisher handle not from this implementation");
+    return RMW_RET_ERROR;
+  }
+
+  auto info = static_cast<CustomPublisherInfo *>(publisher->data);
+  if (!info->pacer_) {
+    RMW_SET_ERROR_MSG("publisher bandwidth is not limited");
+    return RMW_RET_UNSUPPORTED;
+  }
+  *statistics = info->pacer_->statistics();
+  return RMW_RET_OK;
 }
 }  // extern "C"
@@ -104,8 +104,17 @@ rmw_take_request(
   Publication pub;
 
   if (info->listener_->takeNextData(buffer, pub)) {
-    _deserialize_ros_message(buffer, ros_request, info->request_type_support_,
-      info->typesupport_identifier_);
+    if (!_deserialize_ros_message(buffer, ros_request, info->request_type_support_,
+      info->typesupport_identifier_))
+    {
+      // The request is dropped as messages are; a malformed one must not stop the executor.
+      RCUTILS_LOG_WARN_NAMED(
+        "rmw_dps_cpp",
+        "dropping request from %s: %s", DPS_UUIDToString(DPS_PublicationGetUUID(pub.get())),
+        rmw_get_error_string().str);
+      rmw_reset_error();
+      return RMW_RET_OK;
+    }
 
     // Get header
     memset(request_header->writer_guid, 0, sizeof(request_header->writer_guid));
@@ -59,8 +59,17 @@ rmw_take_response(
   Publication pub;
 
   if (info->listener_->takeNextData(buffer, pub)) {
-    _deserialize_ros_message(buffer, ros_response, info->response_type_support_,
-      info->typesupport_identifier_);
+    if (!_deserialize_ros_message(buffer, ros_response, info->response_type_support_,
+      info->typesupport_identifier_))
+    {
+      // The response is dropped as messages are; a malformed one must not stop the executor.
+      RCUTILS_LOG_WARN_NAMED(
+        "rmw_dps_cpp",
+        "dropping response from %s: %s", DPS_UUIDToString(DPS_PublicationGetUUID(pub.get())),
+        rmw_get_error_string().str);
+      rmw_reset_error();
+      return RMW_RET_OK;
+    }
 
     // Get header
     memset(request_header->writer_guid, 0, sizeof(request_header->writer_guid));
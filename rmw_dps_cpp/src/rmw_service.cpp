@@ -25,6 +25,7 @@
 #include "rmw_dps_cpp/custom_service_info.hpp"
 #include "rmw_dps_cpp/identifier.hpp"
 #include "rmw_dps_cpp/names_common.hpp"
+#include "rmw_dps_cpp/pending_requests.hpp"
 #include "client_service_common.hpp"
 #include "type_support_common.hpp"
 
@@ -240,4 +241,20 @@ rmw_destroy_service(rmw_node_t * node, rmw_service_t * service)
 
   return RMW_RET_OK;
 }
+
+rmw_ret_t
+rmw_dps_cpp_service_get_pending_request_count(const rmw_service_t * service, size_t * count)
+{
+  RMW_CHECK_ARGUMENT_FOR_NULL(service, RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_ARGUMENT_FOR_NULL(count, RMW_RET_INVALID_ARGUMENT);
+
+  if (service->implementation_identifier != intel_dps_identifier) {
+    RMW_SET_ERROR_MSG("service handle not from this implementation");
+    return RMW_RET_ERROR;
+  }
+
+  auto info = static_cast<CustomServiceInfo *>(service->data);
+  *count = info->requests_.size();
+  return RMW_RET_OK;
+}
 }  // extern "C"
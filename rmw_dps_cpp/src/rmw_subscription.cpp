@@ -12,7 +12,11 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <chrono>
+#include <memory>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "rcutils/logging_macros.h"
 
@@ -25,9 +29,17 @@
 #include "rmw_dps_cpp/custom_subscriber_info.hpp"
 #include "rmw_dps_cpp/identifier.hpp"
 #include "rmw_dps_cpp/names_common.hpp"
+#include "rmw_dps_cpp/subscription_options.hpp"
 #include "qos_common.hpp"
+#include "ros_message_serialization.hpp"
+#include "topic_keys.hpp"
 #include "type_support_common.hpp"
 
+// The number of loaned messages when the QoS depth is unspecified
+static const size_t default_loan_pool_size = 10;
+// How long to wait for the missing fragments of a message
+static const size_t default_fragment_timeout = 1000;
+
 extern "C"
 {
 rmw_ret_t
@@ -114,10 +126,20 @@ rmw_create_subscription(
   const char * topic = dps_topic.c_str();
   rmw_subscription_t * rmw_subscription = nullptr;
   rmw_dps_cpp::cbor::TxStream ser;
+  rmw_dps_cpp::SubscriptionOptions options = {};
+  std::unique_ptr<rmw_dps_cpp::ContentFilter> filter;
+  std::vector<std::string> key_topics;
+  std::vector<const char *> topics;
   DPS_Status ret;
 
+  if (subscription_options && subscription_options->rmw_specific_subscription_payload) {
+    options = *static_cast<const rmw_dps_cpp::SubscriptionOptions *>(
+      subscription_options->rmw_specific_subscription_payload);
+  }
+
   info = new CustomSubscriberInfo();
   info->node_ = node;
+  info->transfer_serialized_messages_ = options.transfer_serialized_messages;
   info->typesupport_identifier_ = type_support->typesupport_identifier;
 
   std::string type_name = _create_type_name(
@@ -127,7 +149,36 @@ rmw_create_subscription(
         info->typesupport_identifier_);
     _register_type(impl->node_, info->type_support_, info->typesupport_identifier_);
   }
-
+  if (options.projection && *options.projection) {
+    info->projection_ = _create_projection(
+      options.projection, info->type_support_, info->typesupport_identifier_);
+    if (!info->projection_) {
+      goto fail;  // Error message already set
+    }
+  }
+  if (options.filter_expression && *options.filter_expression) {
+    filter = _create_content_filter(
+      options.filter_expression, options.expression_parameters,
+      options.expression_parameters_count, info->type_support_, info->typesupport_identifier_);
+    if (!filter) {
+      goto fail;  // Error message already set
+    }
+  }
+  if (options.key && *options.key) {
+    if (!_get_dps_key_topic_names(
+        dps_topic, options.key, info->type_support_, info->typesupport_identifier_, key_topics))
+    {
+      goto fail;  // Error message already set
+    }
+  }
+  if (options.loan_messages) {
+    info->loan_pool_ = _create_message_pool(
+      qos_policies->depth ? qos_policies->depth : default_loan_pool_size,
+      info->type_support_, info->typesupport_identifier_);
+    if (!info->loan_pool_) {
+      goto fail;  // Error message already set
+    }
+  }
 
   info->qos_ = *qos_policies;
   /* Set to best-effort & volatile since QoS features are not supported by DPS at the moment. */
@@ -135,12 +186,22 @@ rmw_create_subscription(
   info->qos_.durability = RMW_QOS_POLICY_DURABILITY_VOLATILE;
   info->qos_.reliability = RMW_QOS_POLICY_RELIABILITY_BEST_EFFORT;
 
-  info->subscription_ = DPS_CreateSubscription(impl->node_, &topic, 1);
+  // A keyed subscription only matches publications with all of its key topics
+  if (key_topics.empty()) {
+    topics.push_back(topic);
+  }
+  for (const std::string & key_topic : key_topics) {
+    topics.push_back(key_topic.c_str());
+  }
+  info->subscription_ = DPS_CreateSubscription(impl->node_, topics.data(), topics.size());
   if (!info->subscription_) {
     RMW_SET_ERROR_MSG("failed to create subscription");
     goto fail;
   }
-  info->listener_ = new Listener;
+  info->listener_ = new Listener(options.max_payload_size, options.max_sequence_size,
+      std::chrono::milliseconds(
+        options.fragment_timeout ? options.fragment_timeout : default_fragment_timeout));
+  info->listener_->setContentFilter(std::move(filter));
   ret = DPS_SetSubscriptionData(info->subscription_, info->listener_);
   if (ret != DPS_OK) {
     RMW_SET_ERROR_MSG("failed to set subscription data");
@@ -159,6 +220,7 @@ rmw_create_subscription(
   }
   rmw_subscription->implementation_identifier = intel_dps_identifier;
   rmw_subscription->data = info;
+  rmw_subscription->can_loan_messages = info->loan_pool_ != nullptr;
   rmw_subscription->topic_name =
     reinterpret_cast<const char *>(rmw_allocate(strlen(topic_name) + 1));
   if (!rmw_subscription->topic_name) {
@@ -175,7 +237,10 @@ rmw_create_subscription(
   }
 
   {
+    // Publishers discovered before the subscription was created are matched here
     std::lock_guard<std::mutex> lock(impl->subscribers_mutex_);
+    info->publishers_ = impl->listener_->get_publisher_uuids(topic_name);
+    info->publishers_matched_count_.store(info->publishers_.size());
     impl->subscribers_[topic_name].insert(info);
   }
   return rmw_subscription;
@@ -13,7 +13,9 @@
 // limitations under the License.
 
 #include <cassert>
+#include <vector>
 
+#include "rcutils/allocator.h"
 #include "rcutils/logging_macros.h"
 
 #include "rmw/error_handling.h"
@@ -22,9 +24,12 @@
 #include "rmw/event.h"
 
 #include "rmw_dps_cpp/CborStream.hpp"
+#include "rmw_dps_cpp/Compression.hpp"
 #include "rmw_dps_cpp/Listener.hpp"
 #include "rmw_dps_cpp/custom_subscriber_info.hpp"
 #include "rmw_dps_cpp/identifier.hpp"
+#include "rmw_dps_cpp/take_sequence.hpp"
+#include "rmw_dps_cpp/tracing.hpp"
 #include "ros_message_serialization.hpp"
 
 extern "C"
@@ -43,6 +48,53 @@ _assign_message_info(
   }
 }
 
+static bool
+_deserialize(
+  CustomSubscriberInfo * info,
+  rmw_dps_cpp::cbor::RxStream & buffer,
+  const Publication & pub,
+  void * ros_message)
+{
+  if (!rmw_dps_cpp::decompress(buffer, info->listener_->maxPayloadSize())) {
+    RCUTILS_LOG_WARN_NAMED(
+      "rmw_dps_cpp",
+      "dropping message from %s: cannot uncompress payload",
+      DPS_UUIDToString(DPS_PublicationGetUUID(pub.get())));
+    return false;
+  }
+  if (!_deserialize_ros_message(buffer, ros_message, info->type_support_,
+    info->typesupport_identifier_, info->projection_.get()))
+  {
+    // The message is dropped; a malformed publication must not stop the executor.
+    RCUTILS_LOG_WARN_NAMED(
+      "rmw_dps_cpp",
+      "dropping message from %s: %s", DPS_UUIDToString(DPS_PublicationGetUUID(pub.get())),
+      rmw_get_error_string().str);
+    rmw_reset_error();
+    return false;
+  }
+  return true;
+}
+
+static bool
+_take_data(
+  CustomSubscriberInfo * info,
+  rmw_dps_cpp::cbor::RxStream & buffer,
+  const Publication & pub,
+  void * ros_message,
+  rmw_message_info_t * message_info)
+{
+  RMW_DPS_TRACEPOINT(take_deserialize_start, info->listener_,
+    rmw_dps_cpp::trace_uuid(pub.get()), DPS_PublicationGetSequenceNum(pub.get()), ros_message,
+    buffer.getBufferSize());
+  bool taken = _deserialize(info, buffer, pub, ros_message);
+  RMW_DPS_TRACEPOINT(take_deserialize_end, ros_message, taken);
+  if (taken && message_info) {
+    _assign_message_info(message_info, pub.get());
+  }
+  return taken;
+}
+
 rmw_ret_t
 _take(
   const rmw_subscription_t * subscription,
@@ -64,12 +116,7 @@ _take(
   Publication pub;
 
   if (info->listener_->takeNextData(buffer, pub)) {
-    _deserialize_ros_message(buffer, ros_message, info->type_support_,
-      info->typesupport_identifier_);
-    if (message_info) {
-      _assign_message_info(message_info, pub.get());
-    }
-    *taken = true;
+    *taken = _take_data(info, buffer, pub, ros_message, message_info);
   }
 
   return RMW_RET_OK;
@@ -126,6 +173,66 @@ rmw_take_with_info(
   return _take(subscription, ros_message, taken, message_info);
 }
 
+static bool
+_is_default_allocator(const rcutils_allocator_t & allocator)
+{
+  rcutils_allocator_t default_allocator = rcutils_get_default_allocator();
+  return allocator.allocate == default_allocator.allocate &&
+         allocator.deallocate == default_allocator.deallocate &&
+         allocator.reallocate == default_allocator.reallocate;
+}
+
+static rmw_ret_t
+_take_serialized_data(
+  CustomSubscriberInfo * info,
+  rmw_dps_cpp::cbor::RxStream & buffer,
+  const Publication & pub,
+  rmw_serialized_message_t * serialized_message,
+  bool * taken,
+  rmw_message_info_t * message_info)
+{
+  *taken = false;
+  if (!rmw_dps_cpp::decompress(buffer, info->listener_->maxPayloadSize())) {
+    // The message is dropped, as when it cannot be deserialized
+    RCUTILS_LOG_WARN_NAMED(
+      "rmw_dps_cpp",
+      "dropping message from %s: cannot uncompress payload",
+      DPS_UUIDToString(DPS_PublicationGetUUID(pub.get())));
+    return RMW_RET_OK;
+  }
+  auto buffer_size = static_cast<size_t>(buffer.getBufferSize());
+  // The received buffer is allocated with malloc(), as is the memory of the default allocator
+  uint8_t * data = nullptr;
+  if (info->transfer_serialized_messages_ && buffer_size &&
+    _is_default_allocator(serialized_message->allocator))
+  {
+    data = buffer.release();
+  }
+  if (data) {
+    if (serialized_message->buffer) {
+      serialized_message->allocator.deallocate(
+        serialized_message->buffer, serialized_message->allocator.state);
+    }
+    serialized_message->buffer = data;
+    serialized_message->buffer_capacity = buffer_size;
+  } else if (serialized_message->buffer_capacity < buffer_size) {
+    auto ret = rmw_serialized_message_resize(serialized_message, buffer_size);
+    if (ret != RMW_RET_OK) {
+      return ret;  // Error message already set
+    }
+  }
+  serialized_message->buffer_length = buffer_size;
+  if (!data) {
+    memcpy(serialized_message->buffer, buffer.getBuffer(), serialized_message->buffer_length);
+  }
+
+  if (message_info) {
+    _assign_message_info(message_info, pub.get());
+  }
+  *taken = true;
+  return RMW_RET_OK;
+}
+
 rmw_ret_t
 _take_serialized_message(
   const rmw_subscription_t * subscription,
@@ -147,20 +254,7 @@ _take_serialized_message(
   Publication pub;
 
   if (info->listener_->takeNextData(buffer, pub)) {
-    auto buffer_size = static_cast<size_t>(buffer.getBufferSize());
-    if (serialized_message->buffer_capacity < buffer_size) {
-      auto ret = rmw_serialized_message_resize(serialized_message, buffer_size);
-      if (ret != RMW_RET_OK) {
-        return ret;  // Error message already set
-      }
-    }
-    serialized_message->buffer_length = buffer_size;
-    memcpy(serialized_message->buffer, buffer.getBuffer(), serialized_message->buffer_length);
-
-    if (message_info) {
-      _assign_message_info(message_info, pub.get());
-    }
-    *taken = true;
+    return _take_serialized_data(info, buffer, pub, serialized_message, taken, message_info);
   }
 
   return RMW_RET_OK;
@@ -220,6 +314,93 @@ rmw_take_serialized_message_with_info(
   return _take_serialized_message(subscription, serialized_message, taken, message_info);
 }
 
+rmw_ret_t
+rmw_dps_cpp_take_sequence(
+  const rmw_subscription_t * subscription,
+  size_t count,
+  void * const * ros_messages,
+  rmw_message_info_t * message_infos,
+  size_t * taken)
+{
+  RCUTILS_LOG_DEBUG_NAMED(
+    "rmw_dps_cpp",
+    "%s(subscription=%p,count=%zu,ros_messages=%p,message_infos=%p,taken=%p)", __FUNCTION__,
+    (void *)subscription, count, (void *)ros_messages, (void *)message_infos, (void *)taken);
+
+  RMW_CHECK_ARGUMENT_FOR_NULL(subscription, RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_ARGUMENT_FOR_NULL(ros_messages, RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_ARGUMENT_FOR_NULL(taken, RMW_RET_INVALID_ARGUMENT);
+
+  *taken = 0;
+
+  if (subscription->implementation_identifier != intel_dps_identifier) {
+    RMW_SET_ERROR_MSG("subscription handle not from this implementation");
+    return RMW_RET_ERROR;
+  }
+
+  CustomSubscriberInfo * info = static_cast<CustomSubscriberInfo *>(subscription->data);
+  RCUTILS_CHECK_FOR_NULL_WITH_MSG(info, "custom subscriber info is null", return RMW_RET_ERROR);
+
+  std::vector<Listener::Data> data;
+  data.reserve(count);
+  info->listener_->takeData(data, count);
+  for (Listener::Data & d : data) {
+    if (_take_data(info, d.second, d.first, ros_messages[*taken],
+      message_infos ? &message_infos[*taken] : nullptr))
+    {
+      ++*taken;
+    }
+  }
+
+  return RMW_RET_OK;
+}
+
+rmw_ret_t
+rmw_dps_cpp_take_serialized_message_sequence(
+  const rmw_subscription_t * subscription,
+  size_t count,
+  rmw_serialized_message_t * serialized_messages,
+  rmw_message_info_t * message_infos,
+  size_t * taken)
+{
+  RCUTILS_LOG_DEBUG_NAMED(
+    "rmw_dps_cpp",
+    "%s(subscription=%p,count=%zu,serialized_messages=%p,message_infos=%p,taken=%p)",
+    __FUNCTION__, (void *)subscription, count, (void *)serialized_messages,
+    (void *)message_infos, (void *)taken);
+
+  RMW_CHECK_ARGUMENT_FOR_NULL(subscription, RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_ARGUMENT_FOR_NULL(serialized_messages, RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_ARGUMENT_FOR_NULL(taken, RMW_RET_INVALID_ARGUMENT);
+
+  *taken = 0;
+
+  if (subscription->implementation_identifier != intel_dps_identifier) {
+    RMW_SET_ERROR_MSG("subscription handle not from this implementation");
+    return RMW_RET_ERROR;
+  }
+
+  CustomSubscriberInfo * info = static_cast<CustomSubscriberInfo *>(subscription->data);
+  RCUTILS_CHECK_FOR_NULL_WITH_MSG(info, "custom subscriber info is null", return RMW_RET_ERROR);
+
+  std::vector<Listener::Data> data;
+  data.reserve(count);
+  info->listener_->takeData(data, count);
+  for (Listener::Data & d : data) {
+    bool taken_one = false;
+    rmw_ret_t ret = _take_serialized_data(info, d.second, d.first, &serialized_messages[*taken],
+        &taken_one, message_infos ? &message_infos[*taken] : nullptr);
+    if (ret != RMW_RET_OK) {
+      return ret;  // The messages not yet copied are dropped
+    }
+    if (taken_one) {
+      ++*taken;
+    }
+  }
+
+  return RMW_RET_OK;
+}
+
 rmw_ret_t
 rmw_take_event(
   const rmw_event_t * event_handle,
@@ -233,6 +414,43 @@ rmw_take_event(
   return RMW_RET_ERROR;
 }
 
+rmw_ret_t
+_take_loaned_message(
+  const rmw_subscription_t * subscription,
+  void ** loaned_message,
+  bool * taken,
+  rmw_message_info_t * message_info)
+{
+  *taken = false;
+
+  if (subscription->implementation_identifier != intel_dps_identifier) {
+    RMW_SET_ERROR_MSG("subscription handle not from this implementation");
+    return RMW_RET_ERROR;
+  }
+
+  CustomSubscriberInfo * info = static_cast<CustomSubscriberInfo *>(subscription->data);
+  RCUTILS_CHECK_FOR_NULL_WITH_MSG(info, "custom subscriber info is null", return RMW_RET_ERROR);
+
+  if (!info->loan_pool_) {
+    RMW_SET_ERROR_MSG("subscription does not lend messages");
+    return RMW_RET_UNSUPPORTED;
+  }
+  void * ros_message = info->loan_pool_->borrow();
+  if (!ros_message) {
+    RMW_SET_ERROR_MSG("all loaned messages are in use");
+    return RMW_RET_ERROR;
+  }
+
+  // Deserializing into the previous contents of the message reuses their memory
+  rmw_ret_t ret = _take(subscription, ros_message, taken, message_info);
+  if (*taken) {
+    *loaned_message = ros_message;
+  } else {
+    info->loan_pool_->giveBack(ros_message);
+  }
+  return ret;
+}
+
 rmw_ret_t
 rmw_take_loaned_message(
   const rmw_subscription_t * subscription,
@@ -240,13 +458,18 @@ rmw_take_loaned_message(
   bool * taken,
   rmw_subscription_allocation_t * allocation)
 {
-  (void) subscription;
-  (void) loaned_message;
-  (void) taken;
-  (void) allocation;
+  (void)allocation;
 
-  RMW_SET_ERROR_MSG("rmw_take_loaned_message not implemented for rmw_dps_cpp");
-  return RMW_RET_UNSUPPORTED;
+  RCUTILS_LOG_DEBUG_NAMED(
+    "rmw_dps_cpp",
+    "%s(subscription=%p,loaned_message=%p,taken=%p,allocation=%p)", __FUNCTION__,
+    (void *)subscription, (void *)loaned_message, (void *)taken, (void *)allocation);
+
+  RMW_CHECK_ARGUMENT_FOR_NULL(subscription, RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_ARGUMENT_FOR_NULL(loaned_message, RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_ARGUMENT_FOR_NULL(taken, RMW_RET_INVALID_ARGUMENT);
+
+  return _take_loaned_message(subscription, loaned_message, taken, nullptr);
 }
 
 rmw_ret_t
@@ -257,14 +480,20 @@ rmw_take_loaned_message_with_info(
   rmw_message_info_t * message_info,
   rmw_subscription_allocation_t * allocation)
 {
-  (void) subscription;
-  (void) loaned_message;
-  (void) taken;
-  (void) message_info;
-  (void) allocation;
-
-  RMW_SET_ERROR_MSG("rmw_take_loaned_message_with_info not implemented for rmw_dps_cpp");
-  return RMW_RET_UNSUPPORTED;
+  (void)allocation;
+
+  RCUTILS_LOG_DEBUG_NAMED(
+    "rmw_dps_cpp",
+    "%s(subscription=%p,loaned_message=%p,taken=%p,message_info=%p,allocation=%p)",
+    __FUNCTION__, (void *)subscription, (void *)loaned_message, (void *)taken,
+    (void *)message_info, (void *)allocation);
+
+  RMW_CHECK_ARGUMENT_FOR_NULL(subscription, RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_ARGUMENT_FOR_NULL(loaned_message, RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_ARGUMENT_FOR_NULL(taken, RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_ARGUMENT_FOR_NULL(message_info, RMW_RET_INVALID_ARGUMENT);
+
+  return _take_loaned_message(subscription, loaned_message, taken, message_info);
 }
 
 rmw_ret_t
@@ -272,11 +501,24 @@ rmw_return_loaned_message_from_subscription(
   const rmw_subscription_t * subscription,
   void * loaned_message)
 {
-  (void) subscription;
-  (void) loaned_message;
+  RCUTILS_LOG_DEBUG_NAMED(
+    "rmw_dps_cpp",
+    "%s(subscription=%p,loaned_message=%p)", __FUNCTION__, (void *)subscription,
+    loaned_message);
+
+  RMW_CHECK_ARGUMENT_FOR_NULL(subscription, RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_ARGUMENT_FOR_NULL(loaned_message, RMW_RET_INVALID_ARGUMENT);
 
-  RMW_SET_ERROR_MSG(
-    "rmw_return_loaned_message_from_subscription not implemented for rmw_dps_cpp");
-  return RMW_RET_UNSUPPORTED;
+  if (subscription->implementation_identifier != intel_dps_identifier) {
+    RMW_SET_ERROR_MSG("subscription handle not from this implementation");
+    return RMW_RET_ERROR;
+  }
+
+  auto info = static_cast<CustomSubscriberInfo *>(subscription->data);
+  if (!info->loan_pool_ || !info->loan_pool_->giveBack(loaned_message)) {
+    RMW_SET_ERROR_MSG("message not loaned by this subscription");
+    return RMW_RET_ERROR;
+  }
+  return RMW_RET_OK;
 }
 }  // extern "C"
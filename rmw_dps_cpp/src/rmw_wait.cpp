@@ -12,6 +12,16 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#ifdef __linux__
+#include <poll.h>
+#endif
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <vector>
+
 #include "rcutils/logging_macros.h"
 
 #include "rmw/error_handling.h"
@@ -20,6 +30,9 @@
 #include "rmw_dps_cpp/custom_client_info.hpp"
 #include "rmw_dps_cpp/custom_service_info.hpp"
 #include "rmw_dps_cpp/custom_subscriber_info.hpp"
+#include "rmw_dps_cpp/identifier.hpp"
+#include "rmw_dps_cpp/tracing.hpp"
+#include "rmw_dps_cpp/wait_fds.hpp"
 #include "types/custom_wait_set_info.hpp"
 #include "types/guard_condition.hpp"
 
@@ -74,47 +87,155 @@ check_wait_set_for_data(
   return false;
 }
 
-extern "C"
+static inline void
+_cpu_relax()
 {
-rmw_ret_t
-rmw_wait(
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+  __builtin_ia32_pause();
+#elif defined(__GNUC__) && defined(__aarch64__)
+  __asm__ __volatile__ ("yield");
+#endif
+}
+
+/// Spin until an entity of the wait set has data or spin_period has elapsed.
+/**
+ * \return true if an entity has data.
+ */
+static bool
+_spin(
+  const rmw_subscriptions_t * subscriptions,
+  const rmw_guard_conditions_t * guard_conditions,
+  const rmw_services_t * services,
+  const rmw_clients_t * clients,
+  std::chrono::nanoseconds spin_period)
+{
+  auto deadline = std::chrono::steady_clock::now() + spin_period;
+  do {
+    if (check_wait_set_for_data(subscriptions, guard_conditions, services, clients)) {
+      return true;
+    }
+    _cpu_relax();
+  } while (std::chrono::steady_clock::now() < deadline);
+  return false;
+}
+
+#ifdef __linux__
+/// Get the file descriptors of the entities of a wait set, replacing those in fds.
+/**
+ * \return false if an entity has no file descriptor.
+ */
+static bool
+_get_wait_set_fds(
+  const rmw_subscriptions_t * subscriptions,
+  const rmw_guard_conditions_t * guard_conditions,
+  const rmw_services_t * services,
+  const rmw_clients_t * clients,
+  std::vector<pollfd> & fds)
+{
+  auto add = [&fds](int fd) {
+      fds.push_back(pollfd{fd, POLLIN, 0});
+      return fd >= 0;
+    };
+  fds.clear();
+  if (subscriptions) {
+    for (size_t i = 0; i < subscriptions->subscriber_count; ++i) {
+      auto info = static_cast<CustomSubscriberInfo *>(subscriptions->subscribers[i]);
+      if (info && !add(info->listener_->fd())) {
+        return false;
+      }
+    }
+  }
+  if (clients) {
+    for (size_t i = 0; i < clients->client_count; ++i) {
+      auto info = static_cast<CustomClientInfo *>(clients->clients[i]);
+      if (info && !add(info->listener_->fd())) {
+        return false;
+      }
+    }
+  }
+  if (services) {
+    for (size_t i = 0; i < services->service_count; ++i) {
+      auto info = static_cast<CustomServiceInfo *>(services->services[i]);
+      if (info && !add(info->listener_->fd())) {
+        return false;
+      }
+    }
+  }
+  if (guard_conditions) {
+    for (size_t i = 0; i < guard_conditions->guard_condition_count; ++i) {
+      auto guard_condition = static_cast<GuardCondition *>(guard_conditions->guard_conditions[i]);
+      if (guard_condition && !add(guard_condition->fd())) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+/// Wait for a file descriptor to become readable.
+/**
+ * The file descriptors stay readable while their entity has data, so data
+ * arriving after the wait set was checked is not missed.
+ * \return RMW_RET_TIMEOUT if none became readable before wait_timeout.
+ */
+static rmw_ret_t
+_poll(std::vector<pollfd> & fds, const rmw_time_t * wait_timeout)
+{
+  std::chrono::steady_clock::time_point deadline;
+  if (wait_timeout) {
+    deadline = std::chrono::steady_clock::now() + std::chrono::seconds(wait_timeout->sec) +
+      std::chrono::nanoseconds(wait_timeout->nsec);
+  }
+  while (true) {
+    timespec timeout;
+    timespec * timeout_ptr = nullptr;
+    if (wait_timeout) {
+      auto remaining = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        deadline - std::chrono::steady_clock::now());
+      if (remaining.count() < 0) {
+        remaining = std::chrono::nanoseconds(0);
+      }
+      timeout.tv_sec = static_cast<time_t>(remaining.count() / 1000000000);
+      timeout.tv_nsec = static_cast<long>(remaining.count() % 1000000000);  // NOLINT(runtime/int)
+      timeout_ptr = &timeout;
+    }
+    int ret = ppoll(fds.data(), fds.size(), timeout_ptr, nullptr);
+    if (ret > 0) {
+      return RMW_RET_OK;
+    } else if (ret == 0) {
+      return RMW_RET_TIMEOUT;
+    } else if (errno != EINTR) {
+      RMW_SET_ERROR_MSG_WITH_FORMAT_STRING("failed to poll wait set - %s", strerror(errno));
+      return RMW_RET_ERROR;
+    }
+  }
+}
+#endif
+
+/// Wait on the condition variable of a wait set for an entity to have data.
+/**
+ * Where an entity of the wait set has no file descriptor to poll.
+ * \return true if no entity had data before wait_timeout.
+ */
+static bool
+_wait_condition(
+  CustomWaitsetInfo * wait_set_info,
   rmw_subscriptions_t * subscriptions,
   rmw_guard_conditions_t * guard_conditions,
   rmw_services_t * services,
   rmw_clients_t * clients,
-  rmw_events_t * events,
-  rmw_wait_set_t * wait_set,
   const rmw_time_t * wait_timeout)
 {
-  if (events && events->event_count) {
-    RMW_SET_ERROR_MSG("unimplemented");
-    return RMW_RET_ERROR;
-  }
-  if (!wait_set) {
-    RMW_SET_ERROR_MSG("wait set handle is null");
-    return RMW_RET_ERROR;
-  }
-  CustomWaitsetInfo * wait_set_info = static_cast<CustomWaitsetInfo *>(wait_set->data);
-  if (!wait_set_info) {
-    RMW_SET_ERROR_MSG("Waitset info struct is null");
-    return RMW_RET_ERROR;
-  }
   std::mutex * conditionMutex = &wait_set_info->condition_mutex;
   std::condition_variable * conditionVariable = &wait_set_info->condition;
-  if (!conditionMutex) {
-    RMW_SET_ERROR_MSG("Mutex for wait set was null");
-    return RMW_RET_ERROR;
-  }
-  if (!conditionVariable) {
-    RMW_SET_ERROR_MSG("Condition variable for wait set was null");
-    return RMW_RET_ERROR;
-  }
 
   if (subscriptions) {
     for (size_t i = 0; i < subscriptions->subscriber_count; ++i) {
       void * data = subscriptions->subscribers[i];
       auto custom_subscriber_info = static_cast<CustomSubscriberInfo *>(data);
-      custom_subscriber_info->listener_->attachCondition(conditionMutex, conditionVariable);
+      if (custom_subscriber_info) {
+        custom_subscriber_info->listener_->attachCondition(conditionMutex, conditionVariable);
+      }
     }
   }
 
@@ -122,7 +243,9 @@ rmw_wait(
     for (size_t i = 0; i < clients->client_count; ++i) {
       void * data = clients->clients[i];
       CustomClientInfo * custom_client_info = static_cast<CustomClientInfo *>(data);
-      custom_client_info->listener_->attachCondition(conditionMutex, conditionVariable);
+      if (custom_client_info) {
+        custom_client_info->listener_->attachCondition(conditionMutex, conditionVariable);
+      }
     }
   }
 
@@ -130,7 +253,9 @@ rmw_wait(
     for (size_t i = 0; i < services->service_count; ++i) {
       void * data = services->services[i];
       auto custom_service_info = static_cast<CustomServiceInfo *>(data);
-      custom_service_info->listener_->attachCondition(conditionMutex, conditionVariable);
+      if (custom_service_info) {
+        custom_service_info->listener_->attachCondition(conditionMutex, conditionVariable);
+      }
     }
   }
 
@@ -138,13 +263,15 @@ rmw_wait(
     for (size_t i = 0; i < guard_conditions->guard_condition_count; ++i) {
       void * data = guard_conditions->guard_conditions[i];
       auto guard_condition = static_cast<GuardCondition *>(data);
-      guard_condition->attachCondition(conditionMutex, conditionVariable);
+      if (guard_condition) {
+        guard_condition->attachCondition(conditionMutex, conditionVariable);
+      }
     }
   }
 
-  // This mutex prevents any of the listeners
-  // to change the internal state and notify the condition
-  // between the call to hasData() / hasTriggered() and wait()
+  // Listeners take this mutex between changing their internal state and
+  // notifying the condition, so a change after the call to hasData() /
+  // hasTriggered() is notified once wait() has released the mutex,
   // otherwise the decision to wait might be incorrect
   std::unique_lock<std::mutex> lock(*conditionMutex);
 
@@ -179,8 +306,135 @@ rmw_wait(
     for (size_t i = 0; i < subscriptions->subscriber_count; ++i) {
       void * data = subscriptions->subscribers[i];
       auto custom_subscriber_info = static_cast<CustomSubscriberInfo *>(data);
-      custom_subscriber_info->listener_->detachCondition();
-      if (!custom_subscriber_info->listener_->hasData()) {
+      if (custom_subscriber_info) {
+        custom_subscriber_info->listener_->detachCondition(conditionMutex, conditionVariable);
+      }
+    }
+  }
+
+  if (clients) {
+    for (size_t i = 0; i < clients->client_count; ++i) {
+      void * data = clients->clients[i];
+      CustomClientInfo * custom_client_info = static_cast<CustomClientInfo *>(data);
+      if (custom_client_info) {
+        custom_client_info->listener_->detachCondition(conditionMutex, conditionVariable);
+      }
+    }
+  }
+
+  if (services) {
+    for (size_t i = 0; i < services->service_count; ++i) {
+      void * data = services->services[i];
+      auto custom_service_info = static_cast<CustomServiceInfo *>(data);
+      if (custom_service_info) {
+        custom_service_info->listener_->detachCondition(conditionMutex, conditionVariable);
+      }
+    }
+  }
+
+  if (guard_conditions) {
+    for (size_t i = 0; i < guard_conditions->guard_condition_count; ++i) {
+      void * data = guard_conditions->guard_conditions[i];
+      auto guard_condition = static_cast<GuardCondition *>(data);
+      if (guard_condition) {
+        guard_condition->detachCondition(conditionMutex, conditionVariable);
+      }
+    }
+  }
+
+  return timeout;
+}
+
+extern "C"
+{
+rmw_ret_t
+rmw_wait(
+  rmw_subscriptions_t * subscriptions,
+  rmw_guard_conditions_t * guard_conditions,
+  rmw_services_t * services,
+  rmw_clients_t * clients,
+  rmw_events_t * events,
+  rmw_wait_set_t * wait_set,
+  const rmw_time_t * wait_timeout)
+{
+  if (events && events->event_count) {
+    RMW_SET_ERROR_MSG("unimplemented");
+    return RMW_RET_ERROR;
+  }
+  if (!wait_set) {
+    RMW_SET_ERROR_MSG("wait set handle is null");
+    return RMW_RET_ERROR;
+  }
+  CustomWaitsetInfo * wait_set_info = static_cast<CustomWaitsetInfo *>(wait_set->data);
+  if (!wait_set_info) {
+    RMW_SET_ERROR_MSG("Waitset info struct is null");
+    return RMW_RET_ERROR;
+  }
+  bool timeout = false;
+  bool block = false;
+  rmw_time_t remaining;
+  if (check_wait_set_for_data(subscriptions, guard_conditions, services, clients)) {
+    ++wait_set_info->immediate_count;
+  } else if (wait_timeout && wait_timeout->sec == 0 && wait_timeout->nsec == 0) {
+    ++wait_set_info->immediate_count;
+    timeout = true;
+  } else if (wait_set_info->spin_period.count() > 0) {
+    auto spin_period = wait_set_info->spin_period;
+    std::chrono::nanoseconds timeout_period(0);
+    if (wait_timeout) {
+      timeout_period = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::seconds(wait_timeout->sec)) + std::chrono::nanoseconds(wait_timeout->nsec);
+      spin_period = std::min(spin_period, timeout_period);
+    }
+    auto start = std::chrono::steady_clock::now();
+    if (_spin(subscriptions, guard_conditions, services, clients, spin_period)) {
+      ++wait_set_info->spin_count;
+    } else if (wait_timeout && spin_period == timeout_period) {
+      ++wait_set_info->spin_count;
+      timeout = true;
+    } else {
+      block = true;
+      if (wait_timeout) {
+        // Block for what remains of the timeout
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        auto n = std::max(std::chrono::duration_cast<std::chrono::nanoseconds>(
+              timeout_period - elapsed), std::chrono::nanoseconds(1));
+        remaining.sec = static_cast<uint64_t>(n.count() / 1000000000);
+        remaining.nsec = static_cast<uint64_t>(n.count() % 1000000000);
+        wait_timeout = &remaining;
+      }
+    }
+  } else {
+    block = true;
+  }
+  if (block) {
+    ++wait_set_info->block_count;
+#ifdef __linux__
+    // The file descriptors of the entities need no condition to be attached
+    std::vector<pollfd> & fds = wait_set_info->fds;
+    if (_get_wait_set_fds(subscriptions, guard_conditions, services, clients, fds)) {
+      rmw_ret_t ret = _poll(fds, wait_timeout);
+      if (ret == RMW_RET_ERROR) {
+        return ret;  // Error message already set
+      }
+      timeout = ret == RMW_RET_TIMEOUT;
+    } else {
+      // eventfd() failed for an entity, e.g. out of file descriptors
+      timeout = _wait_condition(
+        wait_set_info, subscriptions, guard_conditions, services, clients, wait_timeout);
+    }
+#else
+    timeout = _wait_condition(
+      wait_set_info, subscriptions, guard_conditions, services, clients, wait_timeout);
+#endif
+  }
+  RMW_DPS_TRACEPOINT(rmw_wait_wake, wait_set, timeout ? RMW_RET_TIMEOUT : RMW_RET_OK);
+
+  if (subscriptions) {
+    for (size_t i = 0; i < subscriptions->subscriber_count; ++i) {
+      void * data = subscriptions->subscribers[i];
+      auto custom_subscriber_info = static_cast<CustomSubscriberInfo *>(data);
+      if (custom_subscriber_info && !custom_subscriber_info->listener_->hasData()) {
         subscriptions->subscribers[i] = 0;
       }
     }
@@ -190,8 +444,7 @@ rmw_wait(
     for (size_t i = 0; i < clients->client_count; ++i) {
       void * data = clients->clients[i];
       CustomClientInfo * custom_client_info = static_cast<CustomClientInfo *>(data);
-      custom_client_info->listener_->detachCondition();
-      if (!custom_client_info->listener_->hasData()) {
+      if (custom_client_info && !custom_client_info->listener_->hasData()) {
         clients->clients[i] = 0;
       }
     }
@@ -201,8 +454,7 @@ rmw_wait(
     for (size_t i = 0; i < services->service_count; ++i) {
       void * data = services->services[i];
       auto custom_service_info = static_cast<CustomServiceInfo *>(data);
-      custom_service_info->listener_->detachCondition();
-      if (!custom_service_info->listener_->hasData()) {
+      if (custom_service_info && !custom_service_info->listener_->hasData()) {
         services->services[i] = 0;
       }
     }
@@ -212,8 +464,7 @@ rmw_wait(
     for (size_t i = 0; i < guard_conditions->guard_condition_count; ++i) {
       void * data = guard_conditions->guard_conditions[i];
       auto guard_condition = static_cast<GuardCondition *>(data);
-      guard_condition->detachCondition();
-      if (!guard_condition->getHasTriggered()) {
+      if (guard_condition && !guard_condition->getHasTriggered()) {
         guard_conditions->guard_conditions[i] = 0;
       }
     }
@@ -221,4 +472,75 @@ rmw_wait(
 
   return timeout ? RMW_RET_TIMEOUT : RMW_RET_OK;
 }
+
+static rmw_ret_t
+_get_fd(int entity_fd, int * fd)
+{
+  if (entity_fd < 0) {
+    RMW_SET_ERROR_MSG("file descriptors are not supported");
+    return RMW_RET_UNSUPPORTED;
+  }
+  *fd = entity_fd;
+  return RMW_RET_OK;
+}
+
+rmw_ret_t
+rmw_dps_cpp_subscription_get_fd(const rmw_subscription_t * subscription, int * fd)
+{
+  RMW_CHECK_ARGUMENT_FOR_NULL(subscription, RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_ARGUMENT_FOR_NULL(fd, RMW_RET_INVALID_ARGUMENT);
+
+  if (subscription->implementation_identifier != intel_dps_identifier) {
+    RMW_SET_ERROR_MSG("subscription handle not from this implementation");
+    return RMW_RET_ERROR;
+  }
+
+  auto info = static_cast<CustomSubscriberInfo *>(subscription->data);
+  return _get_fd(info->listener_->fd(), fd);
+}
+
+rmw_ret_t
+rmw_dps_cpp_client_get_fd(const rmw_client_t * client, int * fd)
+{
+  RMW_CHECK_ARGUMENT_FOR_NULL(client, RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_ARGUMENT_FOR_NULL(fd, RMW_RET_INVALID_ARGUMENT);
+
+  if (client->implementation_identifier != intel_dps_identifier) {
+    RMW_SET_ERROR_MSG("client handle not from this implementation");
+    return RMW_RET_ERROR;
+  }
+
+  auto info = static_cast<CustomClientInfo *>(client->data);
+  return _get_fd(info->listener_->fd(), fd);
+}
+
+rmw_ret_t
+rmw_dps_cpp_service_get_fd(const rmw_service_t * service, int * fd)
+{
+  RMW_CHECK_ARGUMENT_FOR_NULL(service, RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_ARGUMENT_FOR_NULL(fd, RMW_RET_INVALID_ARGUMENT);
+
+  if (service->implementation_identifier != intel_dps_identifier) {
+    RMW_SET_ERROR_MSG("service handle not from this implementation");
+    return RMW_RET_ERROR;
+  }
+
+  auto info = static_cast<CustomServiceInfo *>(service->data);
+  return _get_fd(info->listener_->fd(), fd);
+}
+
+rmw_ret_t
+rmw_dps_cpp_guard_condition_get_fd(const rmw_guard_condition_t * guard_condition, int * fd)
+{
+  RMW_CHECK_ARGUMENT_FOR_NULL(guard_condition, RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_ARGUMENT_FOR_NULL(fd, RMW_RET_INVALID_ARGUMENT);
+
+  if (guard_condition->implementation_identifier != intel_dps_identifier) {
+    RMW_SET_ERROR_MSG("guard condition handle not from this implementation");
+    return RMW_RET_ERROR;
+  }
+
+  auto info = static_cast<GuardCondition *>(guard_condition->data);
+  return _get_fd(info->fd(), fd);
+}
 }  // extern "C"
@@ -12,6 +12,11 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+
+#include "rcutils/get_env.h"
 #include "rcutils/logging_macros.h"
 
 #include "rmw/allocators.h"
@@ -20,8 +25,29 @@
 #include "rmw/impl/cpp/macros.hpp"
 
 #include "rmw_dps_cpp/identifier.hpp"
+#include "rmw_dps_cpp/wait_policy.hpp"
 #include "types/custom_wait_set_info.hpp"
 
+/// Read the default spin period of wait sets, in microseconds, zero if not set.
+static bool
+_get_env_spin_period(std::chrono::nanoseconds * spin_period)
+{
+  const char * value = nullptr;
+  *spin_period = std::chrono::nanoseconds(0);
+  if (rcutils_get_env("RMW_DPS_WAIT_SPIN_PERIOD", &value) || !*value) {
+    return true;
+  }
+  char * end = nullptr;
+  errno = 0;
+  unsigned long long n = strtoull(value, &end, 10);  // NOLINT(runtime/int)
+  // Longer than a second is certainly a mistake
+  if (errno || *end || n > 1000000) {
+    return false;
+  }
+  *spin_period = std::chrono::microseconds(n);
+  return true;
+}
+
 extern "C"
 {
 rmw_wait_set_t *
@@ -46,6 +72,10 @@ rmw_create_wait_set(rmw_context_t * context, size_t max_conditions)
     RMW_SET_ERROR_MSG("failed to construct wait set info struct");
     goto fail;
   }
+  if (!_get_env_spin_period(&wait_set_info->spin_period)) {
+    RMW_SET_ERROR_MSG("invalid RMW_DPS_WAIT_SPIN_PERIOD");
+    goto fail;
+  }
 
   return wait_set;
 
@@ -95,4 +125,40 @@ rmw_destroy_wait_set(rmw_wait_set_t * wait_set)
   rmw_wait_set_free(wait_set);
   return result;
 }
+
+rmw_ret_t
+rmw_dps_cpp_wait_set_set_spin_period(rmw_wait_set_t * wait_set, rmw_time_t spin_period)
+{
+  RMW_CHECK_ARGUMENT_FOR_NULL(wait_set, RMW_RET_INVALID_ARGUMENT);
+
+  if (wait_set->implementation_identifier != intel_dps_identifier) {
+    RMW_SET_ERROR_MSG("wait set handle not from this implementation");
+    return RMW_RET_ERROR;
+  }
+
+  auto wait_set_info = static_cast<CustomWaitsetInfo *>(wait_set->data);
+  wait_set_info->spin_period = std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::seconds(spin_period.sec)) + std::chrono::nanoseconds(spin_period.nsec);
+  return RMW_RET_OK;
+}
+
+rmw_ret_t
+rmw_dps_cpp_wait_set_get_statistics(
+  const rmw_wait_set_t * wait_set,
+  rmw_dps_cpp::WaitStatistics * statistics)
+{
+  RMW_CHECK_ARGUMENT_FOR_NULL(wait_set, RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_ARGUMENT_FOR_NULL(statistics, RMW_RET_INVALID_ARGUMENT);
+
+  if (wait_set->implementation_identifier != intel_dps_identifier) {
+    RMW_SET_ERROR_MSG("wait set handle not from this implementation");
+    return RMW_RET_ERROR;
+  }
+
+  auto wait_set_info = static_cast<CustomWaitsetInfo *>(wait_set->data);
+  statistics->immediate_count = wait_set_info->immediate_count;
+  statistics->spin_count = wait_set_info->spin_count;
+  statistics->block_count = wait_set_info->block_count;
+  return RMW_RET_OK;
+}
 }  // extern "C"
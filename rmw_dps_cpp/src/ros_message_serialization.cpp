@@ -12,15 +12,20 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <exception>
+#include <string>
+#include <vector>
+
 #include "rmw/error_handling.h"
 
 #include "ros_message_serialization.hpp"
 #include "type_support_common.hpp"
 
-bool
-_serialize_ros_message(
+template<typename Stream>
+static bool
+_serialize(
   const void * ros_message,
-  rmw_dps_cpp::cbor::TxStream & ser,
+  Stream & ser,
   void * untyped_typesupport,
   const char * typesupport_identifier)
 {
@@ -35,20 +40,171 @@ _serialize_ros_message(
   return false;
 }
 
+template<typename Stream>
+static bool
+_deserialize(
+  Stream & buffer,
+  void * ros_message,
+  void * untyped_typesupport,
+  const char * typesupport_identifier,
+  const rmw_dps_cpp::Projection * projection)
+{
+  try {
+    if (using_introspection_c_typesupport(typesupport_identifier)) {
+      auto typed_typesupport = static_cast<TypeSupport_c *>(untyped_typesupport);
+      return typed_typesupport->deserializeROSmessage(buffer, ros_message, projection);
+    } else if (using_introspection_cpp_typesupport(typesupport_identifier)) {
+      auto typed_typesupport = static_cast<TypeSupport_cpp *>(untyped_typesupport);
+      return typed_typesupport->deserializeROSmessage(buffer, ros_message, projection);
+    }
+  } catch (const std::bad_alloc &) {
+    RMW_SET_ERROR_MSG("failed to allocate memory for message");
+    return false;
+  } catch (const std::exception & e) {
+    RMW_SET_ERROR_MSG(e.what());
+    return false;
+  }
+  RMW_SET_ERROR_MSG("Unknown typesupport identifier");
+  return false;
+}
+
+bool
+_serialize_ros_message(
+  const void * ros_message,
+  rmw_dps_cpp::cbor::TxStream & ser,
+  void * untyped_typesupport,
+  const char * typesupport_identifier)
+{
+  return _serialize(ros_message, ser, untyped_typesupport, typesupport_identifier);
+}
+
+bool
+_serialize_ros_message(
+  const void * ros_message,
+  rmw_dps_cpp::cdr::TxStream & ser,
+  void * untyped_typesupport,
+  const char * typesupport_identifier)
+{
+  return _serialize(ros_message, ser, untyped_typesupport, typesupport_identifier);
+}
+
 bool
 _deserialize_ros_message(
   rmw_dps_cpp::cbor::RxStream & buffer,
   void * ros_message,
   void * untyped_typesupport,
+  const char * typesupport_identifier,
+  const rmw_dps_cpp::Projection * projection)
+{
+  if (rmw_dps_cpp::cdr::is_cdr(buffer.getBuffer(), buffer.getBufferSize())) {
+    rmw_dps_cpp::cdr::RxStream cdr_buffer(buffer.getBuffer(), buffer.getBufferSize());
+    cdr_buffer.setMaxSequenceSize(buffer.getMaxSequenceSize());
+    return _deserialize(
+      cdr_buffer, ros_message, untyped_typesupport, typesupport_identifier, projection);
+  }
+  return _deserialize(
+    buffer, ros_message, untyped_typesupport, typesupport_identifier, projection);
+}
+
+std::unique_ptr<rmw_dps_cpp::Projection>
+_create_projection(
+  const char * paths,
+  void * untyped_typesupport,
   const char * typesupport_identifier)
 {
-  if (using_introspection_c_typesupport(typesupport_identifier)) {
-    auto typed_typesupport = static_cast<TypeSupport_c *>(untyped_typesupport);
-    return typed_typesupport->deserializeROSmessage(buffer, ros_message);
-  } else if (using_introspection_cpp_typesupport(typesupport_identifier)) {
-    auto typed_typesupport = static_cast<TypeSupport_cpp *>(untyped_typesupport);
-    return typed_typesupport->deserializeROSmessage(buffer, ros_message);
+  std::unique_ptr<rmw_dps_cpp::Projection> projection;
+  try {
+    if (using_introspection_c_typesupport(typesupport_identifier)) {
+      auto typed_typesupport = static_cast<TypeSupport_c *>(untyped_typesupport);
+      projection = typed_typesupport->createProjection(paths);
+    } else if (using_introspection_cpp_typesupport(typesupport_identifier)) {
+      auto typed_typesupport = static_cast<TypeSupport_cpp *>(untyped_typesupport);
+      projection = typed_typesupport->createProjection(paths);
+    } else {
+      RMW_SET_ERROR_MSG("Unknown typesupport identifier");
+      return nullptr;
+    }
+  } catch (const std::bad_alloc &) {
+    RMW_SET_ERROR_MSG("failed to allocate memory for projection");
+    return nullptr;
+  }
+  if (!projection) {
+    RMW_SET_ERROR_MSG_WITH_FORMAT_STRING("invalid projection '%s'", paths);
+  }
+  return projection;
+}
+
+std::unique_ptr<rmw_dps_cpp::ContentFilter>
+_create_content_filter(
+  const char * expression,
+  const char * const * parameters,
+  size_t parameters_count,
+  void * untyped_typesupport,
+  const char * typesupport_identifier)
+{
+  try {
+    std::vector<std::string> parameters_vector(parameters, parameters + parameters_count);
+    if (using_introspection_c_typesupport(typesupport_identifier)) {
+      auto typed_typesupport = static_cast<TypeSupport_c *>(untyped_typesupport);
+      return typed_typesupport->createContentFilter(expression, parameters_vector);
+    } else if (using_introspection_cpp_typesupport(typesupport_identifier)) {
+      auto typed_typesupport = static_cast<TypeSupport_cpp *>(untyped_typesupport);
+      return typed_typesupport->createContentFilter(expression, parameters_vector);
+    }
+  } catch (const std::bad_alloc &) {
+    RMW_SET_ERROR_MSG("failed to allocate memory for content filter");
+    return nullptr;
+  } catch (const std::exception & e) {
+    RMW_SET_ERROR_MSG(e.what());
+    return nullptr;
   }
   RMW_SET_ERROR_MSG("Unknown typesupport identifier");
-  return false;
+  return nullptr;
+}
+
+std::unique_ptr<rmw_dps_cpp::FieldReader>
+_create_field_reader(
+  const std::vector<std::string> & fields,
+  void * untyped_typesupport,
+  const char * typesupport_identifier)
+{
+  try {
+    if (using_introspection_c_typesupport(typesupport_identifier)) {
+      auto typed_typesupport = static_cast<TypeSupport_c *>(untyped_typesupport);
+      return typed_typesupport->createFieldReader(fields);
+    } else if (using_introspection_cpp_typesupport(typesupport_identifier)) {
+      auto typed_typesupport = static_cast<TypeSupport_cpp *>(untyped_typesupport);
+      return typed_typesupport->createFieldReader(fields);
+    }
+  } catch (const std::bad_alloc &) {
+    RMW_SET_ERROR_MSG("failed to allocate memory for field reader");
+    return nullptr;
+  } catch (const std::exception & e) {
+    RMW_SET_ERROR_MSG(e.what());
+    return nullptr;
+  }
+  RMW_SET_ERROR_MSG("Unknown typesupport identifier");
+  return nullptr;
+}
+
+std::unique_ptr<rmw_dps_cpp::MessagePool>
+_create_message_pool(
+  size_t capacity,
+  void * untyped_typesupport,
+  const char * typesupport_identifier)
+{
+  try {
+    if (using_introspection_c_typesupport(typesupport_identifier)) {
+      auto typed_typesupport = static_cast<TypeSupport_c *>(untyped_typesupport);
+      return typed_typesupport->createMessagePool(capacity);
+    } else if (using_introspection_cpp_typesupport(typesupport_identifier)) {
+      auto typed_typesupport = static_cast<TypeSupport_cpp *>(untyped_typesupport);
+      return typed_typesupport->createMessagePool(capacity);
+    }
+  } catch (const std::bad_alloc &) {
+    RMW_SET_ERROR_MSG("failed to allocate memory for message pool");
+    return nullptr;
+  }
+  RMW_SET_ERROR_MSG("Unknown typesupport identifier");
+  return nullptr;
 }
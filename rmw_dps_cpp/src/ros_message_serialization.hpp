@@ -15,7 +15,15 @@
 #ifndef ROS_MESSAGE_SERIALIZATION_HPP_
 #define ROS_MESSAGE_SERIALIZATION_HPP_
 
+#include <memory>
+#include <string>
+#include <vector>
+
 #include "rmw_dps_cpp/CborStream.hpp"
+#include "rmw_dps_cpp/CdrStream.hpp"
+#include "rmw_dps_cpp/ContentFilter.hpp"
+#include "rmw_dps_cpp/MessagePool.hpp"
+#include "rmw_dps_cpp/Projection.hpp"
 
 bool
 _serialize_ros_message(
@@ -25,10 +33,64 @@ _serialize_ros_message(
   const char * typesupport_identifier);
 
 bool
+_serialize_ros_message(
+  const void * ros_message,
+  rmw_dps_cpp::cdr::TxStream & ser,
+  void * untyped_members,
+  const char * typesupport_identifier);
+
+/// Deserialize a CBOR or CDR encoded message, as determined by the payload.
+/**
+ * Only the members selected by projection are deserialized, or all if it is null.
+ */
+bool
 _deserialize_ros_message(
   rmw_dps_cpp::cbor::RxStream & buffer,
   void * ros_message,
   void * untyped_members,
+  const char * typesupport_identifier,
+  const rmw_dps_cpp::Projection * projection = nullptr);
+
+/// Create a projection from a ',' separated list of member paths.
+/**
+ * \return null if a path is invalid, with the error message set.
+ */
+std::unique_ptr<rmw_dps_cpp::Projection>
+_create_projection(
+  const char * paths,
+  void * untyped_members,
+  const char * typesupport_identifier);
+
+/// Create a pool of capacity preconstructed messages.
+/**
+ * \return null on failure, with the error message set.
+ */
+std::unique_ptr<rmw_dps_cpp::MessagePool>
+_create_message_pool(
+  size_t capacity,
+  void * untyped_members,
+  const char * typesupport_identifier);
+
+/// Create a reader of the values of fields of the message.
+/**
+ * \return null if a field is invalid, with the error message set.
+ */
+std::unique_ptr<rmw_dps_cpp::FieldReader>
+_create_field_reader(
+  const std::vector<std::string> & fields,
+  void * untyped_members,
+  const char * typesupport_identifier);
+
+/// Create a content filter from an expression over the fields of the message.
+/**
+ * \return null if the expression is invalid, with the error message set.
+ */
+std::unique_ptr<rmw_dps_cpp::ContentFilter>
+_create_content_filter(
+  const char * expression,
+  const char * const * parameters,
+  size_t parameters_count,
+  void * untyped_members,
   const char * typesupport_identifier);
 
 #endif  // ROS_MESSAGE_SERIALIZATION_HPP_
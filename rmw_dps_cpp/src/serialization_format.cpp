@@ -12,6 +12,28 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <cstring>
+
+#include "rcutils/get_env.h"
+
 #include "rmw_dps_cpp/serialization_format.hpp"
 
 const char * const intel_dps_serialization_format = "cbor";
+const char * const intel_dps_cdr_serialization_format = "cdr";
+
+const char *
+_get_serialization_format(const char * name)
+{
+  if (!name || !*name) {
+    if (rcutils_get_env("RMW_DPS_SERIALIZATION_FORMAT", &name) || !*name) {
+      return intel_dps_serialization_format;
+    }
+  }
+  if (strcmp(name, intel_dps_serialization_format) == 0) {
+    return intel_dps_serialization_format;
+  }
+  if (strcmp(name, intel_dps_cdr_serialization_format) == 0) {
+    return intel_dps_cdr_serialization_format;
+  }
+  return nullptr;
+}
@@ -0,0 +1,240 @@
+// Copyright 2019 Intel Corporation All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "rmw/error_handling.h"
+
+#include "rmw_dps_cpp/ContentFilter.hpp"
+#include "rmw_dps_cpp/custom_node_info.hpp"
+#include "ros_message_serialization.hpp"
+#include "topic_keys.hpp"
+
+static std::vector<std::string>
+_split(const std::string & list, char separator)
+{
+  std::vector<std::string> items;
+  size_t pos = 0;
+  while (pos != std::string::npos) {
+    size_t end = list.find(separator, pos);
+    std::string item = list.substr(pos, end == std::string::npos ? end : end - pos);
+    pos = end == std::string::npos ? end : end + 1;
+    if (!item.empty()) {
+      items.push_back(item);
+    }
+  }
+  return items;
+}
+
+std::unique_ptr<rmw_dps_cpp::FieldReader>
+_create_key_reader(
+  const char * key_fields,
+  void * untyped_typesupport,
+  const char * typesupport_identifier)
+{
+  return _create_field_reader(_split(key_fields, ','), untyped_typesupport, typesupport_identifier);
+}
+
+std::string
+_get_dps_key_topic_name(
+  const std::string & dps_topic_name, const std::string & field, const std::string & value)
+{
+  return dps_topic_name + "&" + field + "=" + value;
+}
+
+bool
+_get_dps_key_topic_names(
+  const std::string & dps_topic_name,
+  const char * key,
+  void * untyped_typesupport,
+  const char * typesupport_identifier,
+  std::vector<std::string> & topics)
+{
+  std::vector<std::string> fields;
+  std::vector<std::string> values;
+  for (const std::string & item : _split(key, ',')) {
+    size_t pos = item.find('=');
+    if (pos == std::string::npos) {
+      RMW_SET_ERROR_MSG_WITH_FORMAT_STRING("invalid key '%s', expected field=value", key);
+      return false;
+    }
+    fields.push_back(item.substr(0, pos));
+    values.push_back(item.substr(pos + 1));
+  }
+  std::unique_ptr<rmw_dps_cpp::FieldReader> reader = _create_field_reader(
+    fields, untyped_typesupport, typesupport_identifier);
+  if (!reader) {
+    return false;  // Error message already set
+  }
+  for (size_t i = 0; i < fields.size(); ++i) {
+    // Format values as they are when read from a message by the publisher.
+    rmw_dps_cpp::FilterValue value;
+    value.type = reader->types()[i];
+    if (value.type == rmw_dps_cpp::FilterValue::STRING) {
+      value.string = values[i];
+    } else if (values[i] == "true" || values[i] == "false") {
+      value.number = values[i] == "true";
+    } else {
+      char * end = nullptr;
+      errno = 0;
+      value.number = strtold(values[i].c_str(), &end);
+      if (end == values[i].c_str() || *end || errno) {
+        RMW_SET_ERROR_MSG_WITH_FORMAT_STRING(
+          "invalid value '%s' for key field '%s'", values[i].c_str(), fields[i].c_str());
+        return false;
+      }
+    }
+    topics.push_back(
+      _get_dps_key_topic_name(dps_topic_name, fields[i], rmw_dps_cpp::to_topic_string(value)));
+  }
+  return true;
+}
+
+DPS_Status
+_init_publication(
+  CustomPublisherInfo * info, DPS_Publication * pub, const char ** topics, size_t numTopics)
+{
+  if (!info->keyframe_interval_) {
+    return DPS_InitPublication(pub, topics, numTopics, DPS_TRUE, nullptr);
+  }
+  std::unique_ptr<rmw_dps_cpp::DeltaEncoder> encoder(
+    new rmw_dps_cpp::DeltaEncoder(info->keyframe_interval_));
+  // Subscriptions missing the base of a delta acknowledge it to request a keyframe
+  DPS_Status ret = DPS_SetPublicationData(pub, encoder.get());
+  if (ret == DPS_OK) {
+    ret = DPS_InitPublication(
+      pub, topics, numTopics, DPS_TRUE, rmw_dps_cpp::DeltaEncoder::onAcknowledgement);
+  }
+  if (ret == DPS_OK) {
+    std::lock_guard<std::mutex> lock(info->delta_encoders_mutex_);
+    info->delta_encoders_.push_back(std::move(encoder));
+  }
+  return ret;
+}
+
+rmw_dps_cpp::DeltaEncoder *
+_get_delta_encoder(CustomPublisherInfo * info, const DPS_Publication * pub)
+{
+  if (!info->keyframe_interval_) {
+    return nullptr;
+  }
+  return static_cast<rmw_dps_cpp::DeltaEncoder *>(DPS_GetPublicationData(pub));
+}
+
+/// Destroy a keyed publication, and its delta encoder.
+static void
+_destroy_keyed_publication(CustomPublisherInfo * info, DPS_Publication * pub)
+{
+  rmw_dps_cpp::DeltaEncoder * encoder = _get_delta_encoder(info, pub);
+  DPS_DestroyPublication(pub, nullptr);
+  if (encoder) {
+    std::lock_guard<std::mutex> lock(info->delta_encoders_mutex_);
+    auto it = std::find_if(info->delta_encoders_.begin(), info->delta_encoders_.end(),
+        [encoder](const std::unique_ptr<rmw_dps_cpp::DeltaEncoder> & e) {
+          return e.get() == encoder;
+        });
+    if (it != info->delta_encoders_.end()) {
+      info->delta_encoders_.erase(it);
+    }
+  }
+}
+
+/// Forget the least recently used keyed publication.
+static void
+_evict_keyed_publication(CustomPublisherInfo * info)
+{
+  auto oldest = std::min_element(info->keyed_publications_.begin(),
+      info->keyed_publications_.end(),
+      [](const std::pair<const std::string, KeyedPublication> & a,
+      const std::pair<const std::string, KeyedPublication> & b) {
+        return a.second.last < b.second.last;
+      });
+  if (oldest != info->keyed_publications_.end()) {
+    info->keyed_publications_.erase(oldest);
+  }
+}
+
+DPS_Publication *
+_get_keyed_publication(
+  CustomPublisherInfo * info, const uint8_t * data, size_t size,
+  std::shared_ptr<DPS_Publication> & hold)
+{
+  if (!info->key_reader_) {
+    return info->publication_;
+  }
+
+  const std::vector<std::string> & fields = info->key_reader_->fields();
+  std::vector<rmw_dps_cpp::FilterValue> values;
+  if (!info->key_reader_->read(const_cast<uint8_t *>(data), size, values)) {
+    RMW_SET_ERROR_MSG("cannot read key fields");
+    return nullptr;
+  }
+  std::vector<std::string> topics;
+  std::string key;
+  topics.push_back(info->dps_topic_name_);
+  for (size_t i = 0; i < fields.size(); ++i) {
+    topics.push_back(
+      _get_dps_key_topic_name(
+        info->dps_topic_name_, fields[i], rmw_dps_cpp::to_topic_string(values[i])));
+    key += topics.back();
+  }
+
+  std::lock_guard<std::mutex> lock(info->keyed_publications_mutex_);
+  auto it = info->keyed_publications_.find(key);
+  if (it != info->keyed_publications_.end()) {
+    it->second.last = ++info->keyed_publications_uses_;
+    hold = it->second.publication;
+    return hold.get();
+  }
+  if (info->keyed_publications_.size() >= info->max_keyed_publications_) {
+    _evict_keyed_publication(info);
+  }
+  auto impl = static_cast<CustomNodeInfo *>(info->node_->data);
+  DPS_Publication * pub = DPS_CreatePublication(impl->node_);
+  if (!pub) {
+    RMW_SET_ERROR_MSG("failed to create publication");
+    return nullptr;
+  }
+  std::vector<const char *> topic_ptrs;
+  for (const std::string & topic : topics) {
+    topic_ptrs.push_back(topic.c_str());
+  }
+  DPS_Status ret = _init_publication(info, pub, topic_ptrs.data(), topic_ptrs.size());
+  if (ret != DPS_OK) {
+    RMW_SET_ERROR_MSG("failed to initialize publication");
+    DPS_DestroyPublication(pub, nullptr);
+    return nullptr;
+  }
+  KeyedPublication & keyed_publication = info->keyed_publications_[key];
+  keyed_publication.publication.reset(pub, [info](DPS_Publication * publication) {
+      _destroy_keyed_publication(info, publication);
+    });
+  keyed_publication.last = ++info->keyed_publications_uses_;
+  hold = keyed_publication.publication;
+  return pub;
+}
+
+void
+_destroy_keyed_publications(CustomPublisherInfo * info)
+{
+  std::lock_guard<std::mutex> lock(info->keyed_publications_mutex_);
+  info->keyed_publications_.clear();
+}
@@ -0,0 +1,90 @@
+// Copyright 2019 Intel Corporation All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef TOPIC_KEYS_HPP_
+#define TOPIC_KEYS_HPP_
+
+#include <dps/dps.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "rmw_dps_cpp/ContentFilter.hpp"
+#include "rmw_dps_cpp/Delta.hpp"
+#include "rmw_dps_cpp/custom_publisher_info.hpp"
+
+/// Create a reader of the key fields of a message, a ',' separated list of member paths.
+/**
+ * \return null if a field is invalid, with the error message set.
+ */
+std::unique_ptr<rmw_dps_cpp::FieldReader>
+_create_key_reader(
+  const char * key_fields,
+  void * untyped_typesupport,
+  const char * typesupport_identifier);
+
+/// Get the DPS topic of a key field value, e.g. "0/chatter&robot_id=7".
+/**
+ * Keyed publications carry one such topic for each key field in addition to
+ * the topic of the ROS topic, so a subscription to a key is only matched,
+ * and only receives traffic, for the publications with that key value.
+ */
+std::string
+_get_dps_key_topic_name(
+  const std::string & dps_topic_name, const std::string & field, const std::string & value);
+
+/// Get the DPS topics of a subscription to a key, e.g. "robot_id=7,side=left".
+/**
+ * \return false if the key is invalid for the message, with the error message set.
+ */
+bool
+_get_dps_key_topic_names(
+  const std::string & dps_topic_name,
+  const char * key,
+  void * untyped_typesupport,
+  const char * typesupport_identifier,
+  std::vector<std::string> & topics);
+
+/// Initialize a publication of a publisher, see DPS_InitPublication().
+/**
+ * The publication is given a delta encoder when the publisher delta encodes.
+ */
+DPS_Status
+_init_publication(
+  CustomPublisherInfo * info, DPS_Publication * pub, const char ** topics, size_t numTopics);
+
+/// Return the delta encoder of a publication, or null if the publisher does not delta encode.
+rmw_dps_cpp::DeltaEncoder *
+_get_delta_encoder(CustomPublisherInfo * info, const DPS_Publication * pub);
+
+/// Get the publication for the key values of a serialized message.
+/**
+ * Unkeyed publishers always use their single publication. Keyed publishers
+ * create a publication for each distinct combination of key values, up to
+ * their maximum, beyond which the least recently used one is destroyed.
+ * \param[out] hold keeps a keyed publication from being destroyed until
+ *   the caller is done with it
+ * \return null on failure, with the error message set.
+ */
+DPS_Publication *
+_get_keyed_publication(
+  CustomPublisherInfo * info, const uint8_t * data, size_t size,
+  std::shared_ptr<DPS_Publication> & hold);
+
+/// Destroy the publications created for the key values of a publisher.
+void
+_destroy_keyed_publications(CustomPublisherInfo * info);
+
+#endif  // TOPIC_KEYS_HPP_
@@ -15,13 +15,30 @@
 #ifndef TYPES__CUSTOM_WAIT_SET_INFO_HPP_
 #define TYPES__CUSTOM_WAIT_SET_INFO_HPP_
 
+#ifdef __linux__
+#include <poll.h>
+#endif
+
+#include <atomic>
+#include <chrono>
 #include <condition_variable>
+#include <cstdint>
 #include <mutex>
+#include <vector>
 
 typedef struct CustomWaitsetInfo
 {
   std::condition_variable condition;
   std::mutex condition_mutex;
+  /// How long rmw_wait() spins for data before blocking.
+  std::chrono::nanoseconds spin_period{0};
+  std::atomic<uint64_t> immediate_count{0};
+  std::atomic<uint64_t> spin_count{0};
+  std::atomic<uint64_t> block_count{0};
+#ifdef __linux__
+  /// The file descriptors rmw_wait() polls, kept to reuse their memory.
+  std::vector<pollfd> fds;
+#endif
 } CustomWaitsetInfo;
 
 #endif  // TYPES__CUSTOM_WAIT_SET_INFO_HPP_
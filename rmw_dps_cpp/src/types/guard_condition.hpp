@@ -24,28 +24,24 @@
 
 #include "rcpputils/thread_safety_annotations.hpp"
 
+#include "rmw_dps_cpp/EventFd.hpp"
+#include "rmw_dps_cpp/WaitConditions.hpp"
+
 class GuardCondition
 {
 public:
   GuardCondition()
-  : hasTriggered_(false),
-    conditionMutex_(nullptr), conditionVariable_(nullptr) {}
+  : hasTriggered_(false) {}
 
   void
   trigger()
   {
     std::lock_guard<std::mutex> lock(internalMutex_);
-
-    if (conditionMutex_) {
-      std::unique_lock<std::mutex> clock(*conditionMutex_);
-      // the change to hasTriggered_ needs to be mutually exclusive with
-      // rmw_wait() which checks hasTriggered() and decides if wait() needs to
-      // be called
-      hasTriggered_ = true;
-      clock.unlock();
-      conditionVariable_->notify_one();
-    } else {
-      hasTriggered_ = true;
+    bool hadTriggered = hasTriggered_.exchange(true);
+    // Waiters only wait while hasTriggered() is false
+    if (!hadTriggered) {
+      conditions_.notify();
+      event_.set();
     }
   }
 
@@ -53,16 +49,14 @@ public:
   attachCondition(std::mutex * conditionMutex, std::condition_variable * conditionVariable)
   {
     std::lock_guard<std::mutex> lock(internalMutex_);
-    conditionMutex_ = conditionMutex;
-    conditionVariable_ = conditionVariable;
+    conditions_.attach(conditionMutex, conditionVariable);
   }
 
   void
-  detachCondition()
+  detachCondition(std::mutex * conditionMutex, std::condition_variable * conditionVariable)
   {
     std::lock_guard<std::mutex> lock(internalMutex_);
-    conditionMutex_ = nullptr;
-    conditionVariable_ = nullptr;
+    conditions_.detach(conditionMutex, conditionVariable);
   }
 
   bool
@@ -74,14 +68,26 @@ public:
   bool
   getHasTriggered()
   {
-    return hasTriggered_.exchange(false);
+    std::lock_guard<std::mutex> lock(internalMutex_);
+    bool hadTriggered = hasTriggered_.exchange(false);
+    if (hadTriggered) {
+      event_.clear();
+    }
+    return hadTriggered;
+  }
+
+  /// A file descriptor readable while hasTriggered(), or -1 if not supported.
+  int
+  fd() const
+  {
+    return event_.fd();
   }
 
 private:
   std::mutex internalMutex_;
   std::atomic_bool hasTriggered_;
-  std::mutex * conditionMutex_ RCPPUTILS_TSA_GUARDED_BY(internalMutex_);
-  std::condition_variable * conditionVariable_ RCPPUTILS_TSA_GUARDED_BY(internalMutex_);
+  rmw_dps_cpp::WaitConditions conditions_ RCPPUTILS_TSA_GUARDED_BY(internalMutex_);
+  rmw_dps_cpp::EventFd event_;
 };
 
 #endif  // TYPES__GUARD_CONDITION_HPP_
@@ -0,0 +1,85 @@
+// Copyright 2019 Intel Corporation All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef DPS_FIXTURES_HPP_
+#define DPS_FIXTURES_HPP_
+
+#include <dps/dps.h>
+#include <dps/event.h>
+
+#include <vector>
+
+/// A DPS node whose publications, each with a UUID of its own, stand in for received ones.
+class test_fixture_dps : public ::testing::Test
+{
+protected:
+  void
+  SetUp() override
+  {
+    node = DPS_CreateNode("/", nullptr, nullptr);
+    ASSERT_TRUE(nullptr != node);
+    ASSERT_EQ(DPS_OK, DPS_StartNode(node, DPS_MCAST_PUB_DISABLED, 0));
+  }
+
+  void
+  TearDown() override
+  {
+    for (auto pub : publications) {
+      DPS_DestroyPublication(pub, nullptr);
+    }
+    publications.clear();
+    DPS_Event * event = DPS_CreateEvent();
+    ASSERT_TRUE(nullptr != event);
+    if (DPS_ShutdownNode(node, node_shutdown, event) == DPS_OK) {
+      DPS_WaitForEvent(event);
+    }
+    if (DPS_DestroyNode(node, node_destroyed, event) == DPS_OK) {
+      DPS_WaitForEvent(event);
+    }
+    DPS_DestroyEvent(event);
+  }
+
+  DPS_Publication *
+  create_publication()
+  {
+    const char * topic = "test_fixture_dps";
+    DPS_Publication * pub = DPS_CreatePublication(node);
+    if (pub && DPS_InitPublication(pub, &topic, 1, DPS_TRUE, nullptr) != DPS_OK) {
+      DPS_DestroyPublication(pub, nullptr);
+      pub = nullptr;
+    }
+    if (pub) {
+      publications.push_back(pub);
+    }
+    return pub;
+  }
+
+  DPS_Node * node;
+  std::vector<DPS_Publication *> publications;
+
+private:
+  static void
+  node_shutdown(DPS_Node *, void * data)
+  {
+    DPS_SignalEvent(static_cast<DPS_Event *>(data), DPS_OK);
+  }
+
+  static void
+  node_destroyed(DPS_Node *, void * data)
+  {
+    DPS_SignalEvent(static_cast<DPS_Event *>(data), DPS_OK);
+  }
+};
+
+#endif  // DPS_FIXTURES_HPP_
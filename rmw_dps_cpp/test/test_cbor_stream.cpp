@@ -0,0 +1,81 @@
+// Copyright 2019 Intel Corporation All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "rmw_dps_cpp/CborStream.hpp"
+
+using rmw_dps_cpp::cbor::RxStream;
+using rmw_dps_cpp::cbor::TxStream;
+
+TEST(test_cbor_stream, sequence_size) {
+  // An array of 0xffffffff items with one byte left is rejected before allocating
+  const std::vector<uint8_t> corrupt = {0x9a, 0xff, 0xff, 0xff, 0xff, 0x00};
+  {
+    RxStream rx(corrupt.data(), corrupt.size());
+    std::vector<int32_t> v;
+    EXPECT_THROW(rx >> v, std::runtime_error);
+  }
+  {
+    RxStream rx(corrupt.data(), corrupt.size());
+    std::u16string s;
+    EXPECT_THROW(rx >> s, std::runtime_error);
+  }
+
+  TxStream tx;
+  tx << std::vector<int32_t>(16, 1);
+  ASSERT_EQ(DPS_OK, tx.status());
+  {
+    RxStream rx(tx.data(), tx.size());
+    rx.setMaxSequenceSize(15);
+    std::vector<int32_t> v;
+    EXPECT_THROW(rx >> v, std::runtime_error);
+  }
+  {
+    RxStream rx(tx.data(), tx.size());
+    rx.setMaxSequenceSize(16);
+    std::vector<int32_t> v;
+    rx >> v;
+    EXPECT_EQ(std::vector<int32_t>(16, 1), v);
+  }
+}
+
+TEST(test_cbor_stream, string_size) {
+  TxStream tx;
+  tx << std::string(16, 'a');
+  ASSERT_EQ(DPS_OK, tx.status());
+  {
+    RxStream rx(tx.data(), tx.size());
+    rx.setMaxSequenceSize(15);
+    std::string s;
+    EXPECT_THROW(rx >> s, std::runtime_error);
+  }
+  {
+    RxStream rx(tx.data(), tx.size());
+    rx.setMaxSequenceSize(16);
+    std::string s;
+    rx >> s;
+    EXPECT_EQ(std::string(16, 'a'), s);
+  }
+  // A string longer than the rest of the payload
+  const std::vector<uint8_t> truncated(tx.data(), tx.data() + tx.size() - 1);
+  RxStream rx(truncated.data(), truncated.size());
+  std::string s;
+  EXPECT_THROW(rx >> s, std::runtime_error);
+}
@@ -0,0 +1,193 @@
+// Copyright 2019 Intel Corporation All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "rmw_dps_cpp/CdrStream.hpp"
+
+using rmw_dps_cpp::cdr::RxStream;
+using rmw_dps_cpp::cdr::TxStream;
+
+/// A payload of the byte order other than this host's.
+static std::vector<uint8_t>
+swapped_payload(const std::vector<uint8_t> & body)
+{
+  std::vector<uint8_t> payload = {
+    0x00, static_cast<uint8_t>(rmw_dps_cpp::cdr::is_big_endian() ? 0x01 : 0x00), 0x00, 0x00};
+  payload.insert(payload.end(), body.begin(), body.end());
+  return payload;
+}
+
+/// The bytes of n, most significant first when big_endian.
+template<typename T>
+static std::vector<uint8_t>
+bytes(T n, bool big_endian)
+{
+  std::vector<uint8_t> b(sizeof(T));
+  for (size_t i = 0; i < sizeof(T); ++i) {
+    b[big_endian ? sizeof(T) - 1 - i : i] = static_cast<uint8_t>(n >> (8 * i));
+  }
+  return b;
+}
+
+TEST(test_cdr_stream, round_trip) {
+  TxStream tx;
+  tx << static_cast<uint8_t>(7) << static_cast<uint32_t>(0xdeadbeef) << -1.5 << true <<
+    std::string("hello") << std::vector<int32_t>({1, -2, 3}) << std::u16string(u"wide") <<
+    std::string() << static_cast<int16_t>(-3) << static_cast<uint64_t>(1) << 64;
+  ASSERT_TRUE(rmw_dps_cpp::cdr::is_cdr(tx.data(), tx.size()));
+
+  RxStream rx(tx.data(), tx.size());
+  uint8_t u8;
+  uint32_t u32;
+  double d;
+  bool b;
+  std::string s;
+  std::vector<int32_t> v;
+  std::u16string w;
+  std::string empty = "not empty";
+  int16_t i16;
+  uint64_t u64;
+  int32_t i32;
+  rx >> u8 >> u32 >> d >> b >> s >> v >> w >> empty >> i16 >> u64 >> i32;
+  EXPECT_EQ(7u, u8);
+  EXPECT_EQ(0xdeadbeefu, u32);
+  EXPECT_EQ(-1.5, d);
+  EXPECT_TRUE(b);
+  EXPECT_EQ("hello", s);
+  EXPECT_EQ(std::vector<int32_t>({1, -2, 3}), v);
+  EXPECT_EQ(u"wide", w);
+  EXPECT_EQ("", empty);
+  EXPECT_EQ(-3, i16);
+  EXPECT_EQ(1u, u64);
+  EXPECT_EQ(64, i32);
+  // Nothing is left to read
+  EXPECT_THROW(rx >> u8, std::runtime_error);
+}
+
+TEST(test_cdr_stream, alignment) {
+  TxStream tx;
+  tx << static_cast<uint8_t>(1) << static_cast<uint64_t>(2);
+  // The uint64 is aligned to 8 bytes from the end of the encapsulation header
+  ASSERT_EQ(rmw_dps_cpp::cdr::encapsulation_size + 16, tx.size());
+  for (size_t i = 1; i < 8; ++i) {
+    EXPECT_EQ(0u, tx.data()[rmw_dps_cpp::cdr::encapsulation_size + i]);
+  }
+}
+
+TEST(test_cdr_stream, byte_swap) {
+  const bool big_endian = !rmw_dps_cpp::cdr::is_big_endian();
+  std::vector<uint8_t> body;
+  auto append = [&body](const std::vector<uint8_t> & b) {
+      body.insert(body.end(), b.begin(), b.end());
+    };
+  append(bytes<uint32_t>(0x01020304, big_endian));
+  append(bytes<uint16_t>(0x0506, big_endian));
+  append({0, 0});  // Padding to the uint64
+  append(bytes<uint64_t>(0x0708090a0b0c0d0e, big_endian));
+  // A sequence of two uint16, decoded as a block
+  append(bytes<uint32_t>(2, big_endian));
+  append(bytes<uint16_t>(0x1122, big_endian));
+  append(bytes<uint16_t>(0x3344, big_endian));
+  // A string, whose characters are not swapped
+  append(bytes<uint32_t>(3, big_endian));
+  append({'a', 'b', 0});
+  std::vector<uint8_t> payload = swapped_payload(body);
+
+  RxStream rx(payload.data(), payload.size());
+  uint32_t u32;
+  uint16_t u16;
+  uint64_t u64;
+  std::vector<uint16_t> v;
+  std::string s;
+  rx >> u32 >> u16 >> u64 >> v >> s;
+  EXPECT_EQ(0x01020304u, u32);
+  EXPECT_EQ(0x0506u, u16);
+  EXPECT_EQ(0x0708090a0b0c0d0eu, u64);
+  EXPECT_EQ(std::vector<uint16_t>({0x1122, 0x3344}), v);
+  EXPECT_EQ("ab", s);
+}
+
+TEST(test_cdr_stream, invalid_encapsulation) {
+  const uint8_t cbor[] = {0xa1, 0x00, 0x00, 0x00};
+  EXPECT_THROW(RxStream(cbor, sizeof(cbor)), std::runtime_error);
+  const uint8_t short_header[] = {0x00, 0x01};
+  EXPECT_THROW(RxStream(short_header, sizeof(short_header)), std::runtime_error);
+}
+
+TEST(test_cdr_stream, truncated) {
+  TxStream tx;
+  tx << static_cast<uint32_t>(1) << std::string("truncated") << std::vector<double>({1, 2});
+  for (size_t size = rmw_dps_cpp::cdr::encapsulation_size; size < tx.size(); ++size) {
+    RxStream rx(tx.data(), size);
+    uint32_t u32;
+    std::string s;
+    std::vector<double> v;
+    EXPECT_THROW(rx >> u32 >> s >> v, std::runtime_error) << "size " << size;
+  }
+}
+
+TEST(test_cdr_stream, sequence_size) {
+  const bool big_endian = rmw_dps_cpp::cdr::is_big_endian();
+  // A sequence length larger than the rest of the payload is rejected before allocating
+  std::vector<uint8_t> body = bytes<uint32_t>(0xffffffff, big_endian);
+  body.insert(body.end(), 4, 0);
+  TxStream tx(0);
+  std::vector<uint8_t> payload(tx.data(), tx.data() + tx.size());
+  payload.insert(payload.end(), body.begin(), body.end());
+  {
+    RxStream rx(payload.data(), payload.size());
+    std::vector<uint8_t> v;
+    EXPECT_THROW(rx >> v, std::runtime_error);
+  }
+  {
+    RxStream rx(payload.data(), payload.size());
+    std::string s;
+    EXPECT_THROW(rx >> s, std::runtime_error);
+  }
+
+  TxStream limited;
+  limited << std::vector<uint8_t>(16, 1);
+  RxStream rx(limited.data(), limited.size());
+  rx.setMaxSequenceSize(15);
+  std::vector<uint8_t> v;
+  EXPECT_THROW(rx >> v, std::runtime_error);
+}
+
+TEST(test_cdr_stream, clear) {
+  TxStream tx;
+  tx.setMinReferenceSize(16);
+  std::vector<uint8_t> referenced(16, 1);
+  tx << std::string("first message") << referenced;
+  ASSERT_TRUE(tx.hasReferences());
+  // A cleared stream writes the next message as a new stream would
+  tx.clear();
+  EXPECT_FALSE(tx.hasReferences());
+  tx << static_cast<uint32_t>(2);
+  TxStream fresh;
+  fresh << static_cast<uint32_t>(2);
+  ASSERT_EQ(fresh.size(), tx.size());
+  EXPECT_EQ(0, memcmp(fresh.data(), tx.data(), tx.size()));
+  std::vector<DPS_Buffer> bufs(3);
+  tx.buffers(bufs);
+  ASSERT_EQ(1u, bufs.size());
+  EXPECT_EQ(tx.data(), bufs[0].base);
+  EXPECT_EQ(tx.size(), bufs[0].len);
+}
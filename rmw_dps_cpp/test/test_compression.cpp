@@ -0,0 +1,179 @@
+// Copyright 2019 Intel Corporation All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "rmw_dps_cpp/CborStream.hpp"
+#include "rmw_dps_cpp/Compression.hpp"
+#include "rmw_dps_cpp/subscription_options.hpp"
+
+using rmw_dps_cpp::Codec;
+
+/// A payload with runs, repeats and literals for the codecs to find.
+static std::vector<uint8_t>
+compressible_payload()
+{
+  std::vector<uint8_t> payload(1000, 0);
+  const std::string text = "geometry_msgs/msg/PoseStamped frame_id map ";
+  for (size_t i = 0; i < 100; ++i) {
+    payload.insert(payload.end(), text.begin(), text.end());
+    payload.push_back(static_cast<uint8_t>(i));
+  }
+  return payload;
+}
+
+/// Bytes that do not repeat, from a linear congruential generator.
+static std::vector<uint8_t>
+incompressible_payload(size_t size)
+{
+  std::vector<uint8_t> payload;
+  uint32_t x = 1;
+  for (size_t i = 0; i < size; ++i) {
+    x = x * 1103515245 + 12345;
+    payload.push_back(static_cast<uint8_t>(x >> 16));
+  }
+  return payload;
+}
+
+static bool
+decompress(const std::vector<uint8_t> & data, std::vector<uint8_t> & out, size_t max_size = 0)
+{
+  rmw_dps_cpp::cbor::RxStream payload(data.data(), data.size());
+  if (!rmw_dps_cpp::decompress(payload, max_size)) {
+    return false;
+  }
+  out.assign(payload.getBuffer(), payload.getBuffer() + payload.getBufferSize());
+  return true;
+}
+
+static void
+round_trip(Codec codec, const std::vector<uint8_t> & payload)
+{
+  std::vector<uint8_t> compressed;
+  ASSERT_TRUE(rmw_dps_cpp::compress(codec, payload.data(), payload.size(), compressed));
+  EXPECT_LT(compressed.size(), payload.size());
+  ASSERT_TRUE(rmw_dps_cpp::is_compressed(compressed.data(), compressed.size()));
+  EXPECT_EQ(payload.size(), rmw_dps_cpp::get_uncompressed_size(compressed.data()));
+  std::vector<uint8_t> out;
+  ASSERT_TRUE(decompress(compressed, out));
+  EXPECT_EQ(payload, out);
+}
+
+TEST(test_compression, get_codec) {
+  Codec codec = Codec::NONE;
+  ASSERT_TRUE(rmw_dps_cpp::get_codec("lz", codec));
+  EXPECT_EQ(Codec::LZ, codec);
+  EXPECT_FALSE(rmw_dps_cpp::get_codec("lz4", codec));
+  EXPECT_FALSE(rmw_dps_cpp::get_codec("", codec));
+}
+
+TEST(test_compression, lz_round_trip) {
+  round_trip(Codec::LZ, compressible_payload());
+  // Literal and match lengths of exactly a nibble and of several length bytes
+  for (size_t run : {15, 19, 270, 600}) {
+    std::vector<uint8_t> payload = incompressible_payload(run);
+    std::vector<uint8_t> repeat = payload;
+    payload.insert(payload.end(), repeat.begin(), repeat.end());
+    payload.insert(payload.end(), run, 'x');
+    payload.insert(payload.end(), 16, 'y');
+    round_trip(Codec::LZ, payload);
+  }
+}
+
+TEST(test_compression, zstd_round_trip) {
+  Codec codec;
+  if (!rmw_dps_cpp::get_codec("zstd", codec)) {
+    return;  // Not in this build
+  }
+  round_trip(codec, compressible_payload());
+}
+
+TEST(test_compression, incompressible) {
+  std::vector<uint8_t> compressed;
+  std::vector<uint8_t> payload = incompressible_payload(4096);
+  EXPECT_FALSE(rmw_dps_cpp::compress(Codec::LZ, payload.data(), payload.size(), compressed));
+  // Too small to save the size of the header
+  EXPECT_FALSE(rmw_dps_cpp::compress(Codec::LZ, payload.data(), 8, compressed));
+  EXPECT_FALSE(rmw_dps_cpp::compress(Codec::NONE, payload.data(), payload.size(), compressed));
+}
+
+TEST(test_compression, not_compressed) {
+  // Other payloads are left as they are
+  std::vector<uint8_t> payload = compressible_payload();
+  std::vector<uint8_t> out;
+  ASSERT_TRUE(decompress(payload, out));
+  EXPECT_EQ(payload, out);
+}
+
+TEST(test_compression, truncated) {
+  std::vector<uint8_t> payload = compressible_payload();
+  std::vector<uint8_t> compressed;
+  ASSERT_TRUE(rmw_dps_cpp::compress(Codec::LZ, payload.data(), payload.size(), compressed));
+  std::vector<uint8_t> out;
+  for (size_t size = rmw_dps_cpp::compression_header_size; size < compressed.size(); ++size) {
+    std::vector<uint8_t> truncated(compressed.begin(), compressed.begin() + size);
+    EXPECT_FALSE(decompress(truncated, out)) << "size " << size;
+  }
+}
+
+TEST(test_compression, corrupt) {
+  std::vector<uint8_t> payload = compressible_payload();
+  std::vector<uint8_t> compressed;
+  ASSERT_TRUE(rmw_dps_cpp::compress(Codec::LZ, payload.data(), payload.size(), compressed));
+  std::vector<uint8_t> out;
+
+  // An unknown codec
+  std::vector<uint8_t> corrupt = compressed;
+  corrupt[4] = 0x7f;
+  EXPECT_FALSE(decompress(corrupt, out));
+  // A size other than that of the payload uncompressed
+  corrupt = compressed;
+  ++corrupt[8];
+  EXPECT_FALSE(decompress(corrupt, out));
+  corrupt = compressed;
+  --corrupt[8];
+  EXPECT_FALSE(decompress(corrupt, out));
+  // A match before the start of the payload
+  corrupt = compressed;
+  corrupt.resize(rmw_dps_cpp::compression_header_size);
+  corrupt.insert(corrupt.end(), {0x10, 'a', 0x02, 0x00, 0x00});
+  EXPECT_FALSE(decompress(corrupt, out));
+}
+
+TEST(test_compression, oversized) {
+  std::vector<uint8_t> payload = compressible_payload();
+  std::vector<uint8_t> compressed;
+  ASSERT_TRUE(rmw_dps_cpp::compress(Codec::LZ, payload.data(), payload.size(), compressed));
+  std::vector<uint8_t> out;
+  // Larger than the maximum given
+  EXPECT_FALSE(decompress(compressed, out, payload.size() - 1));
+  ASSERT_TRUE(decompress(compressed, out, payload.size()));
+  EXPECT_EQ(payload, out);
+
+  // Larger than the default maximum, rejected before allocating it
+  std::vector<uint8_t> oversized = compressed;
+  uint32_t size = static_cast<uint32_t>(rmw_dps_cpp::default_max_payload_size + 1);
+  for (size_t j = 0; j < 4; ++j) {
+    oversized[8 + j] = static_cast<uint8_t>(size >> (8 * j));
+  }
+  EXPECT_FALSE(decompress(oversized, out));
+  for (size_t j = 0; j < 4; ++j) {
+    oversized[8 + j] = 0xff;
+  }
+  EXPECT_FALSE(decompress(oversized, out));
+}
@@ -0,0 +1,189 @@
+// Copyright 2019 Intel Corporation All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "rmw_dps_cpp/ContentFilter.hpp"
+
+using rmw_dps_cpp::ContentFilter;
+using rmw_dps_cpp::FilterValue;
+
+static FilterValue
+number(long double n)
+{
+  FilterValue value;
+  value.type = FilterValue::NUMBER;
+  value.number = n;
+  return value;
+}
+
+static FilterValue
+string(const std::string & s)
+{
+  FilterValue value;
+  value.type = FilterValue::STRING;
+  value.string = s;
+  return value;
+}
+
+/// Reads the given values, whatever the payload, or fails unless readable.
+class FakeReader : public rmw_dps_cpp::FieldReader
+{
+public:
+  FakeReader(
+    const std::vector<std::string> & fields, const std::vector<FilterValue> & values,
+    bool readable = true)
+  : values_(values), readable_(readable)
+  {
+    fields_ = fields;
+    for (const FilterValue & value : values) {
+      types_.push_back(value.type);
+    }
+  }
+
+  bool
+  read(uint8_t *, size_t, std::vector<FilterValue> & values) const override
+  {
+    if (!readable_) {
+      return false;
+    }
+    values = values_;
+    return true;
+  }
+
+private:
+  std::vector<FilterValue> values_;
+  bool readable_;
+};
+
+/// Evaluate an expression over a single field.
+static bool
+evaluate(const std::string & expression, const FilterValue & value)
+{
+  ContentFilter filter(expression, {});
+  EXPECT_EQ(1u, filter.fields().size()) << expression;
+  return filter.evaluate({value});
+}
+
+TEST(test_content_filter, comparisons) {
+  for (long double x : {4, 5, 6}) {
+    EXPECT_EQ(x == 5, evaluate("x = 5", number(x)));
+    EXPECT_EQ(x == 5, evaluate("x == 5", number(x)));
+    EXPECT_EQ(x != 5, evaluate("x <> 5", number(x)));
+    EXPECT_EQ(x != 5, evaluate("x != 5", number(x)));
+    EXPECT_EQ(x < 5, evaluate("x < 5", number(x)));
+    EXPECT_EQ(x <= 5, evaluate("x <= 5", number(x)));
+    EXPECT_EQ(x > 5, evaluate("x > 5", number(x)));
+    EXPECT_EQ(x >= 5, evaluate("x >= 5", number(x)));
+  }
+  EXPECT_TRUE(evaluate("x > -1.5e3", number(-1000)));
+  EXPECT_TRUE(evaluate("b = TRUE", number(1)));
+  EXPECT_TRUE(evaluate("b = false", number(0)));
+  EXPECT_TRUE(evaluate("s = 'map'", string("map")));
+  EXPECT_TRUE(evaluate("s = \"map\"", string("map")));
+  EXPECT_TRUE(evaluate("s < 'b'", string("a")));
+  EXPECT_FALSE(evaluate("s = 'map'", string("odom")));
+  // Values of another type than the literal never match
+  EXPECT_FALSE(evaluate("s = 'map'", number(0)));
+}
+
+TEST(test_content_filter, mirrored_comparisons) {
+  // A literal on the left compares as the mirrored comparison with the field on the left
+  for (long double x : {4, 5, 6}) {
+    EXPECT_EQ(evaluate("x > 5", number(x)), evaluate("5 < x", number(x)));
+    EXPECT_EQ(evaluate("x >= 5", number(x)), evaluate("5 <= x", number(x)));
+    EXPECT_EQ(evaluate("x < 5", number(x)), evaluate("5 > x", number(x)));
+    EXPECT_EQ(evaluate("x <= 5", number(x)), evaluate("5 >= x", number(x)));
+    EXPECT_EQ(evaluate("x = 5", number(x)), evaluate("5 = x", number(x)));
+    EXPECT_EQ(evaluate("x <> 5", number(x)), evaluate("5 <> x", number(x)));
+  }
+  EXPECT_TRUE(evaluate("'b' > s", string("a")));
+}
+
+TEST(test_content_filter, nan) {
+  const FilterValue nan = number(std::numeric_limits<long double>::quiet_NaN());
+  // NaN is unordered: only <> holds, whichever side the field is on
+  for (const char * expression : {"x = 1", "x < 1", "x <= 1", "x > 1", "x >= 1", "1 < x",
+      "1 <= x", "1 > x", "1 >= x", "1 = x"})
+  {
+    EXPECT_FALSE(evaluate(expression, nan)) << expression;
+  }
+  EXPECT_TRUE(evaluate("x <> 1", nan));
+  EXPECT_TRUE(evaluate("1 <> x", nan));
+  EXPECT_TRUE(evaluate("NOT x > 1", nan));
+  EXPECT_TRUE(evaluate("NOT x <= 1", nan));
+}
+
+TEST(test_content_filter, logic) {
+  ContentFilter filter("x > 1 AND (s = 'a' OR NOT y = TRUE) OR x < -10", {});
+  ASSERT_EQ(std::vector<std::string>({"x", "s", "y"}), filter.fields());
+  EXPECT_TRUE(filter.evaluate({number(2), string("a"), number(1)}));
+  EXPECT_TRUE(filter.evaluate({number(2), string("b"), number(0)}));
+  EXPECT_FALSE(filter.evaluate({number(2), string("b"), number(1)}));
+  EXPECT_FALSE(filter.evaluate({number(0), string("a"), number(0)}));
+  EXPECT_TRUE(filter.evaluate({number(-11), string("b"), number(1)}));
+  // AND binds tighter than OR
+  ContentFilter precedence("x = 1 OR x = 2 AND x = 3", {});
+  EXPECT_TRUE(precedence.evaluate({number(1)}));
+  EXPECT_FALSE(precedence.evaluate({number(2)}));
+}
+
+TEST(test_content_filter, parameters) {
+  ContentFilter filter("x > %0 AND s = %1 AND b = %2", {"5", "'abc'", "TRUE"});
+  EXPECT_TRUE(filter.evaluate({number(6), string("abc"), number(1)}));
+  EXPECT_FALSE(filter.evaluate({number(5), string("abc"), number(1)}));
+  EXPECT_FALSE(filter.evaluate({number(6), string("ab"), number(1)}));
+}
+
+TEST(test_content_filter, parse_errors) {
+  for (const char * expression : {
+      "", "x", "x >", "> 5", "x 5", "x > 5 5", "(x > 1", "x > 1)", "()", "x > y", "1 > 2",
+      "x ! 1", "x > 'a", "x > %", "x > -", "x > 1 AND", "OR x > 1", "NOT", "x # 1",
+      "x > 1 x > 2"})
+  {
+    EXPECT_THROW(ContentFilter(expression, {}), std::invalid_argument) << expression;
+  }
+  // Missing parameters, and parameters that are not a single literal
+  EXPECT_THROW(ContentFilter("x > %1", {"1"}), std::invalid_argument);
+  EXPECT_THROW(ContentFilter("x > %0", {"y"}), std::invalid_argument);
+  EXPECT_THROW(ContentFilter("x > %0", {"1 2"}), std::invalid_argument);
+  EXPECT_THROW(ContentFilter("x > %0", {""}), std::invalid_argument);
+  EXPECT_THROW(ContentFilter("x > %0", {"%0"}), std::invalid_argument);
+}
+
+TEST(test_content_filter, reader) {
+  ContentFilter filter("x > 1 AND s = 'a'", {});
+  filter.setReader(std::unique_ptr<rmw_dps_cpp::FieldReader>(
+      new FakeReader(filter.fields(), {number(2), string("a")})));
+  uint8_t payload[1] = {};
+  EXPECT_TRUE(filter.matches(payload, sizeof(payload)));
+
+  // A payload that cannot be read does not match
+  ContentFilter unreadable("x > 1", {});
+  unreadable.setReader(std::unique_ptr<rmw_dps_cpp::FieldReader>(
+      new FakeReader(unreadable.fields(), {number(2)}, false)));
+  EXPECT_FALSE(unreadable.matches(payload, sizeof(payload)));
+}
+
+TEST(test_content_filter, type_mismatch) {
+  ContentFilter filter("s > 1", {});
+  EXPECT_THROW(filter.setReader(std::unique_ptr<rmw_dps_cpp::FieldReader>(
+      new FakeReader(filter.fields(), {string("a")}))), std::invalid_argument);
+}
@@ -0,0 +1,273 @@
+// Copyright 2019 Intel Corporation All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "rmw_dps_cpp/CborStream.hpp"
+#include "rmw_dps_cpp/Compression.hpp"
+#include "rmw_dps_cpp/Delta.hpp"
+
+#include "dps_fixtures.hpp"
+
+using rmw_dps_cpp::DeltaDecoder;
+using rmw_dps_cpp::DeltaEncoder;
+using rmw_dps_cpp::DeltaHeader;
+
+static std::vector<uint8_t>
+bytes(const std::string & s)
+{
+  return std::vector<uint8_t>(s.begin(), s.end());
+}
+
+/// The frame of a header and body, the body of a keyframe being the payload.
+static std::vector<uint8_t>
+frame(const DeltaHeader & header, const std::vector<uint8_t> & body)
+{
+  std::vector<uint8_t> f(rmw_dps_cpp::delta_header_size);
+  rmw_dps_cpp::encode_delta_header(header, f.data());
+  f.insert(f.end(), body.begin(), body.end());
+  return f;
+}
+
+static std::vector<uint8_t>
+apply(const std::vector<uint8_t> & base, const std::vector<uint8_t> & delta, size_t size)
+{
+  std::vector<uint8_t> payload(size);
+  if (!rmw_dps_cpp::apply_delta(base, delta.data(), delta.size(), payload.data(), size)) {
+    payload.clear();
+  }
+  return payload;
+}
+
+class test_delta : public test_fixture_dps
+{
+protected:
+  DeltaDecoder::Result
+  decode(const DPS_Publication * pub, const std::vector<uint8_t> & f, size_t max_size = 0)
+  {
+    EXPECT_TRUE(rmw_dps_cpp::is_delta_frame(f.data(), f.size()));
+    return decoder.decode(pub, f.data(), f.size(), max_size, payload);
+  }
+
+  std::vector<uint8_t>
+  decoded() const
+  {
+    return std::vector<uint8_t>(payload.getBuffer(),
+             payload.getBuffer() + payload.getBufferSize());
+  }
+
+  DeltaDecoder decoder;
+  rmw_dps_cpp::cbor::RxStream payload;
+};
+
+TEST(test_delta_codec, header) {
+  uint8_t data[rmw_dps_cpp::delta_header_size];
+  rmw_dps_cpp::encode_delta_header(
+    DeltaHeader{DeltaHeader::KEYFRAME, 0x01020304, 0xfffffffe, 42}, data);
+  ASSERT_TRUE(rmw_dps_cpp::is_delta_frame(data, sizeof(data)));
+  EXPECT_FALSE(rmw_dps_cpp::is_delta_frame(data, sizeof(data) - 1));
+  DeltaHeader header = rmw_dps_cpp::decode_delta_header(data);
+  EXPECT_EQ(DeltaHeader::KEYFRAME, header.flags);
+  EXPECT_EQ(0x01020304u, header.sequence);
+  EXPECT_EQ(0xfffffffeu, header.base);
+  EXPECT_EQ(42u, header.size);
+}
+
+TEST(test_delta_codec, round_trip) {
+  const std::vector<uint8_t> base =
+    bytes("header: {stamp: 1000, frame_id: map}, x: 1.0, y: 2.0, z: 3.0, covariance: [0, 0]");
+  for (const std::string & s : std::vector<std::string>({
+      "header: {stamp: 1001, frame_id: map}, x: 1.5, y: 2.0, z: 3.0, covariance: [0, 0]",
+      "header: {stamp: 1001, frame_id: odom}, x: 1.0, y: 2.0, z: 3.0, covariance: [0, 0]",
+      "header: {stamp: 1000, frame_id: map}, x: 1.0, y: 2.0, z: 3.0, covariance: [0, 0, 1]",
+      "header: {stamp: 1000}, x: 1.0, y: 2.0, z: 3.0, covariance: [0, 0]",
+      "something else entirely", "", std::string(300, 'a')}))
+  {
+    std::vector<uint8_t> data = bytes(s);
+    std::vector<uint8_t> delta;
+    rmw_dps_cpp::encode_delta(base, data.data(), data.size(), delta);
+    EXPECT_EQ(data, apply(base, delta, data.size())) << s;
+    // Nor is the base needed for anything but itself
+    rmw_dps_cpp::encode_delta({}, data.data(), data.size(), delta);
+    EXPECT_EQ(data, apply({}, delta, data.size())) << s;
+  }
+}
+
+TEST(test_delta_codec, invalid) {
+  const std::vector<uint8_t> base = bytes("0123456789abcdef");
+  std::vector<uint8_t> data = bytes("0123456789ABCDEF");
+  std::vector<uint8_t> delta;
+  rmw_dps_cpp::encode_delta(base, data.data(), data.size(), delta);
+  // A delta resulting in more or fewer bytes than the size
+  EXPECT_TRUE(apply(base, delta, data.size() - 1).empty());
+  EXPECT_TRUE(apply(base, delta, data.size() + 1).empty());
+  // A truncated delta
+  for (size_t size = 0; size < delta.size(); ++size) {
+    std::vector<uint8_t> truncated(delta.begin(), delta.begin() + size);
+    EXPECT_TRUE(apply(base, truncated, data.size()).empty()) << "size " << size;
+  }
+  // Inserting more bytes than the delta has
+  EXPECT_TRUE(apply(base, {4, 'a', 'b'}, 2).empty());
+  // Copying from beyond the end of the base
+  EXPECT_TRUE(apply(base, {0, 4, 14}, 4).empty());
+  EXPECT_TRUE(apply(base, {0, 1, 17}, 1).empty());
+  // A number of more than 64 bits
+  EXPECT_TRUE(apply(base, std::vector<uint8_t>(11, 0x80), 0).empty());
+  EXPECT_EQ(bytes("xcdef"), apply(base, {1, 'x', 4, 12}, 5));
+}
+
+TEST(test_delta_codec, encoder) {
+  DeltaEncoder encoder(3);
+  const std::vector<uint8_t> base(100, 'a');
+  std::vector<uint8_t> data = base;
+  std::vector<uint8_t> delta;
+  DeltaHeader header = encoder.encode(data.data(), data.size(), delta);
+  EXPECT_EQ(DeltaHeader::KEYFRAME, header.flags);
+  EXPECT_EQ(1u, header.sequence);
+  EXPECT_EQ(100u, header.size);
+  EXPECT_TRUE(delta.empty());
+
+  data[50] = 'b';
+  header = encoder.encode(data.data(), data.size(), delta);
+  EXPECT_EQ(0, header.flags);
+  EXPECT_EQ(2u, header.sequence);
+  EXPECT_EQ(1u, header.base);
+  EXPECT_EQ(data, apply(base, delta, data.size()));
+
+  header = encoder.encode(data.data(), data.size(), delta);
+  EXPECT_EQ(0, header.flags);
+  // Every keyframe_interval'th payload is a keyframe
+  header = encoder.encode(data.data(), data.size(), delta);
+  EXPECT_EQ(DeltaHeader::KEYFRAME, header.flags);
+  EXPECT_EQ(4u, header.sequence);
+  // As is one whose delta would not be smaller
+  data.assign(100, 'c');
+  header = encoder.encode(data.data(), data.size(), delta);
+  EXPECT_EQ(DeltaHeader::KEYFRAME, header.flags);
+  EXPECT_TRUE(delta.empty());
+}
+
+TEST_F(test_delta, decode) {
+  DPS_Publication * pub = create_publication();
+  DPS_Publication * other = create_publication();
+  ASSERT_TRUE(nullptr != pub && nullptr != other);
+  const std::vector<uint8_t> base = bytes("the quick brown fox jumps over the lazy dog");
+  const std::vector<uint8_t> data = bytes("the quick brown cat jumps over the lazy dog");
+  std::vector<uint8_t> delta;
+  rmw_dps_cpp::encode_delta(base, data.data(), data.size(), delta);
+  std::vector<uint8_t> delta_frame = frame(
+    DeltaHeader{0, 2, 1, static_cast<uint32_t>(data.size())}, delta);
+
+  // A delta before its base
+  EXPECT_EQ(DeltaDecoder::MISSING_BASE, decode(pub, delta_frame));
+  ASSERT_EQ(DeltaDecoder::DECODED, decode(pub,
+    frame(DeltaHeader{DeltaHeader::KEYFRAME, 1, 0, static_cast<uint32_t>(base.size())}, base)));
+  EXPECT_EQ(base, decoded());
+  ASSERT_EQ(DeltaDecoder::DECODED, decode(pub, delta_frame));
+  EXPECT_EQ(data, decoded());
+  // The base is now the delta just decoded, and bases are kept per publication
+  EXPECT_EQ(DeltaDecoder::MISSING_BASE, decode(pub, delta_frame));
+  EXPECT_EQ(DeltaDecoder::MISSING_BASE, decode(other, delta_frame));
+}
+
+TEST_F(test_delta, decode_compressed) {
+  DPS_Publication * pub = create_publication();
+  ASSERT_TRUE(nullptr != pub);
+  const std::vector<uint8_t> base(1000, 'a');
+  std::vector<uint8_t> body;
+  ASSERT_TRUE(rmw_dps_cpp::compress(rmw_dps_cpp::Codec::LZ, base.data(), base.size(), body));
+  ASSERT_EQ(DeltaDecoder::DECODED, decode(pub, frame(DeltaHeader{
+      DeltaHeader::KEYFRAME | DeltaHeader::COMPRESSED, 1, 0,
+      static_cast<uint32_t>(base.size())}, body)));
+  EXPECT_EQ(base, decoded());
+  // A body flagged as compressed must be
+  EXPECT_EQ(DeltaDecoder::INVALID, decode(pub, frame(DeltaHeader{
+      DeltaHeader::KEYFRAME | DeltaHeader::COMPRESSED, 2, 0,
+      static_cast<uint32_t>(base.size())}, base)));
+}
+
+TEST_F(test_delta, decode_invalid) {
+  DPS_Publication * pub = create_publication();
+  ASSERT_TRUE(nullptr != pub);
+  const std::vector<uint8_t> base = bytes("the quick brown fox jumps over the lazy dog");
+  const std::vector<uint8_t> data = bytes("the quick brown cat jumps over the lazy dog");
+  const uint32_t size = static_cast<uint32_t>(base.size());
+  // A keyframe of another size than its header says
+  EXPECT_EQ(DeltaDecoder::INVALID, decode(pub,
+    frame(DeltaHeader{DeltaHeader::KEYFRAME, 1, 0, size + 1}, base)));
+  EXPECT_EQ(DeltaDecoder::INVALID, decode(pub,
+    frame(DeltaHeader{DeltaHeader::KEYFRAME, 1, 0, size - 1}, base)));
+  ASSERT_EQ(DeltaDecoder::DECODED, decode(pub,
+    frame(DeltaHeader{DeltaHeader::KEYFRAME, 1, 0, size}, base)));
+
+  // A truncated delta
+  std::vector<uint8_t> delta;
+  rmw_dps_cpp::encode_delta(base, data.data(), data.size(), delta);
+  for (size_t n = 0; n < delta.size(); ++n) {
+    std::vector<uint8_t> truncated(delta.begin(), delta.begin() + n);
+    EXPECT_EQ(DeltaDecoder::INVALID, decode(pub,
+      frame(DeltaHeader{0, 2, 1, size}, truncated))) << "size " << n;
+  }
+  // A delta copying from beyond its base
+  EXPECT_EQ(DeltaDecoder::INVALID, decode(pub,
+    frame(DeltaHeader{0, 2, 1, 4}, {0, 4, static_cast<uint8_t>(size - 2)})));
+  // The base is kept until a delta decodes
+  ASSERT_EQ(DeltaDecoder::DECODED, decode(pub, frame(DeltaHeader{0, 2, 1, size}, delta)));
+  EXPECT_EQ(data, decoded());
+}
+
+TEST_F(test_delta, decode_oversized) {
+  DPS_Publication * pub = create_publication();
+  ASSERT_TRUE(nullptr != pub);
+  const std::vector<uint8_t> base(100, 'a');
+  // Larger than the maximum given
+  EXPECT_EQ(DeltaDecoder::INVALID, decode(pub,
+    frame(DeltaHeader{DeltaHeader::KEYFRAME, 1, 0, 100}, base), 99));
+  ASSERT_EQ(DeltaDecoder::DECODED, decode(pub,
+    frame(DeltaHeader{DeltaHeader::KEYFRAME, 1, 0, 100}, base), 100));
+  // Larger than the default maximum, rejected before allocating it
+  EXPECT_EQ(DeltaDecoder::INVALID, decode(pub, frame(DeltaHeader{0, 2, 1,
+      static_cast<uint32_t>(rmw_dps_cpp::default_max_payload_size + 1)}, {0, 100, 0})));
+  EXPECT_EQ(DeltaDecoder::INVALID, decode(pub,
+    frame(DeltaHeader{0, 2, 1, 0xffffffff}, {0, 100, 0})));
+}
+
+TEST_F(test_delta, evict_oldest) {
+  DPS_Publication * pubs[3] = {create_publication(), create_publication(), create_publication()};
+  ASSERT_TRUE(nullptr != pubs[0] && nullptr != pubs[1] && nullptr != pubs[2]);
+  const std::vector<uint8_t> base = bytes("the quick brown fox jumps over the lazy dog");
+  const std::vector<uint8_t> data = bytes("the quick brown cat jumps over the lazy dog");
+  const uint32_t size = static_cast<uint32_t>(base.size());
+  std::vector<uint8_t> delta;
+  rmw_dps_cpp::encode_delta(base, data.data(), data.size(), delta);
+  const std::vector<uint8_t> keyframe = frame(DeltaHeader{DeltaHeader::KEYFRAME, 1, 0, size}, base);
+  const std::vector<uint8_t> delta_frame = frame(DeltaHeader{0, 2, 1, size}, delta);
+  DeltaDecoder bounded(2);
+  auto decode_bounded = [&bounded, this](DPS_Publication * pub, const std::vector<uint8_t> & f) {
+      return bounded.decode(pub, f.data(), f.size(), 0, payload);
+    };
+  ASSERT_EQ(DeltaDecoder::DECODED, decode_bounded(pubs[0], keyframe));
+  ASSERT_EQ(DeltaDecoder::DECODED, decode_bounded(pubs[1], keyframe));
+  // A third publication evicts the base of the least recently decoded from
+  ASSERT_EQ(DeltaDecoder::DECODED, decode_bounded(pubs[2], keyframe));
+  EXPECT_EQ(DeltaDecoder::MISSING_BASE, decode_bounded(pubs[0], delta_frame));
+  ASSERT_EQ(DeltaDecoder::DECODED, decode_bounded(pubs[1], delta_frame));
+  EXPECT_EQ(data, decoded());
+  ASSERT_EQ(DeltaDecoder::DECODED, decode_bounded(pubs[2], delta_frame));
+  EXPECT_EQ(data, decoded());
+}
@@ -56,7 +56,7 @@ protected:
   SetUp() override
   {
     test_fixture_rmw::SetUp();
-    node = rmw_create_node(&context, "test_node", "/", 0, &security_options);
+    node = rmw_create_node(&context, "test_node", "/", 0, &security_options, false);
     ASSERT_TRUE(nullptr != node);
   }
 
@@ -0,0 +1,219 @@
+// Copyright 2019 Intel Corporation All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "rmw_dps_cpp/CborStream.hpp"
+#include "rmw_dps_cpp/Fragment.hpp"
+
+#include "dps_fixtures.hpp"
+
+using rmw_dps_cpp::FragmentHeader;
+using rmw_dps_cpp::Reassembler;
+
+class test_fragment : public test_fixture_dps
+{
+protected:
+  void
+  SetUp() override
+  {
+    test_fixture_dps::SetUp();
+    for (size_t i = 0; i < 100; ++i) {
+      message.push_back(static_cast<uint8_t>(i));
+    }
+  }
+
+  /// The fragment of message with the given id covering [offset, end).
+  std::vector<uint8_t>
+  fragment(uint32_t message_id, size_t offset, size_t end) const
+  {
+    return fragment(FragmentHeader{message_id, static_cast<uint32_t>(message.size()),
+               static_cast<uint32_t>(offset)}, message.data() + offset, end - offset);
+  }
+
+  static std::vector<uint8_t>
+  fragment(const FragmentHeader & header, const uint8_t * data, size_t size)
+  {
+    std::vector<uint8_t> f(rmw_dps_cpp::fragment_header_size);
+    rmw_dps_cpp::encode_fragment_header(header, f.data());
+    f.insert(f.end(), data, data + size);
+    return f;
+  }
+
+  static bool
+  add(
+    Reassembler & reassembler, const DPS_Publication * pub, const std::vector<uint8_t> & f,
+    rmw_dps_cpp::cbor::RxStream & payload, size_t max_size = 0)
+  {
+    return reassembler.add(pub, f.data(), f.size(), max_size, payload);
+  }
+
+  std::vector<uint8_t>
+  bytes(const rmw_dps_cpp::cbor::RxStream & payload) const
+  {
+    return std::vector<uint8_t>(payload.getBuffer(),
+             payload.getBuffer() + payload.getBufferSize());
+  }
+
+  std::vector<uint8_t> message;
+  rmw_dps_cpp::cbor::RxStream payload;
+};
+
+TEST_F(test_fragment, header) {
+  std::vector<uint8_t> f = fragment(FragmentHeader{1, 0x01020304, 0xfffffff0}, nullptr, 0);
+  ASSERT_TRUE(rmw_dps_cpp::is_fragment(f.data(), f.size()));
+  FragmentHeader header = rmw_dps_cpp::decode_fragment_header(f.data());
+  EXPECT_EQ(1u, header.message_id);
+  EXPECT_EQ(0x01020304u, header.size);
+  EXPECT_EQ(0xfffffff0u, header.offset);
+  EXPECT_FALSE(rmw_dps_cpp::is_fragment(f.data(), f.size() - 1));
+  f[3] = 'X';
+  EXPECT_FALSE(rmw_dps_cpp::is_fragment(f.data(), f.size()));
+}
+
+TEST_F(test_fragment, in_order) {
+  DPS_Publication * pub = create_publication();
+  ASSERT_TRUE(nullptr != pub);
+  Reassembler reassembler(std::chrono::milliseconds(1000));
+  EXPECT_FALSE(add(reassembler, pub, fragment(1, 0, 40), payload));
+  EXPECT_FALSE(add(reassembler, pub, fragment(1, 40, 80), payload));
+  ASSERT_TRUE(add(reassembler, pub, fragment(1, 80, 100), payload));
+  EXPECT_EQ(message, bytes(payload));
+}
+
+TEST_F(test_fragment, out_of_order) {
+  DPS_Publication * pub = create_publication();
+  ASSERT_TRUE(nullptr != pub);
+  Reassembler reassembler(std::chrono::milliseconds(1000));
+  EXPECT_FALSE(add(reassembler, pub, fragment(1, 80, 100), payload));
+  EXPECT_FALSE(add(reassembler, pub, fragment(1, 0, 40), payload));
+  ASSERT_TRUE(add(reassembler, pub, fragment(1, 40, 80), payload));
+  EXPECT_EQ(message, bytes(payload));
+}
+
+TEST_F(test_fragment, interleaved) {
+  DPS_Publication * pub = create_publication();
+  DPS_Publication * other = create_publication();
+  ASSERT_TRUE(nullptr != pub && nullptr != other);
+  Reassembler reassembler(std::chrono::milliseconds(1000));
+  // Message ids are scoped by publication
+  EXPECT_FALSE(add(reassembler, pub, fragment(1, 0, 50), payload));
+  EXPECT_FALSE(add(reassembler, other, fragment(1, 50, 100), payload));
+  EXPECT_FALSE(add(reassembler, pub, fragment(2, 0, 50), payload));
+  ASSERT_TRUE(add(reassembler, other, fragment(1, 0, 50), payload));
+  EXPECT_EQ(message, bytes(payload));
+  ASSERT_TRUE(add(reassembler, pub, fragment(1, 50, 100), payload));
+  EXPECT_EQ(message, bytes(payload));
+  ASSERT_TRUE(add(reassembler, pub, fragment(2, 50, 100), payload));
+  EXPECT_EQ(message, bytes(payload));
+}
+
+TEST_F(test_fragment, duplicate) {
+  DPS_Publication * pub = create_publication();
+  ASSERT_TRUE(nullptr != pub);
+  Reassembler reassembler(std::chrono::milliseconds(1000));
+  EXPECT_FALSE(add(reassembler, pub, fragment(1, 0, 50), payload));
+  // A duplicate does not count towards completing the message
+  EXPECT_FALSE(add(reassembler, pub, fragment(1, 0, 50), payload));
+  ASSERT_TRUE(add(reassembler, pub, fragment(1, 50, 100), payload));
+  EXPECT_EQ(message, bytes(payload));
+  // Nor does it start the message again once complete, it is only its first fragment
+  EXPECT_FALSE(add(reassembler, pub, fragment(1, 50, 100), payload));
+}
+
+TEST_F(test_fragment, overlapping) {
+  DPS_Publication * pub = create_publication();
+  ASSERT_TRUE(nullptr != pub);
+  Reassembler reassembler(std::chrono::milliseconds(1000));
+  std::vector<uint8_t> forged(60, 0xee);
+  EXPECT_FALSE(add(reassembler, pub, fragment(1, 0, 60), payload));
+  // Overlapping the end, the start, or the whole of a fragment received
+  EXPECT_FALSE(add(reassembler, pub,
+    fragment(FragmentHeader{1, 100, 40}, forged.data(), 60), payload));
+  EXPECT_FALSE(add(reassembler, pub,
+    fragment(FragmentHeader{1, 100, 10}, forged.data(), 20), payload));
+  EXPECT_FALSE(add(reassembler, pub,
+    fragment(FragmentHeader{1, 100, 0}, forged.data(), 60), payload));
+  EXPECT_FALSE(add(reassembler, pub, fragment(1, 80, 100), payload));
+  EXPECT_FALSE(add(reassembler, pub,
+    fragment(FragmentHeader{1, 100, 50}, forged.data(), 40), payload));
+  ASSERT_TRUE(add(reassembler, pub, fragment(1, 60, 80), payload));
+  EXPECT_EQ(message, bytes(payload));
+}
+
+TEST_F(test_fragment, invalid_header) {
+  DPS_Publication * pub = create_publication();
+  ASSERT_TRUE(nullptr != pub);
+  Reassembler reassembler(std::chrono::milliseconds(1000));
+  // The slice must lie within the payload
+  EXPECT_FALSE(add(reassembler, pub,
+    fragment(FragmentHeader{1, 100, 101}, nullptr, 0), payload));
+  EXPECT_FALSE(add(reassembler, pub,
+    fragment(FragmentHeader{1, 100, 90}, message.data(), 20), payload));
+  // All fragments of a message must agree on its size
+  EXPECT_FALSE(add(reassembler, pub, fragment(1, 0, 50), payload));
+  EXPECT_FALSE(add(reassembler, pub,
+    fragment(FragmentHeader{1, 200, 50}, message.data() + 50, 50), payload));
+  ASSERT_TRUE(add(reassembler, pub, fragment(1, 50, 100), payload));
+  EXPECT_EQ(message, bytes(payload));
+}
+
+TEST_F(test_fragment, oversized) {
+  DPS_Publication * pub = create_publication();
+  ASSERT_TRUE(nullptr != pub);
+  Reassembler reassembler(std::chrono::milliseconds(1000));
+  // Larger than the maximum given
+  EXPECT_FALSE(add(reassembler, pub, fragment(1, 0, 50), payload, 99));
+  // Larger than the default maximum, rejected before allocating it
+  EXPECT_FALSE(add(reassembler, pub,
+    fragment(FragmentHeader{2, 0xffffffff, 0}, message.data(), 16), payload));
+  EXPECT_FALSE(add(reassembler, pub,
+    fragment(FragmentHeader{3, static_cast<uint32_t>(rmw_dps_cpp::default_max_payload_size + 1),
+      0}, message.data(), 16), payload));
+  // A payload of the maximum size is accepted
+  EXPECT_FALSE(add(reassembler, pub, fragment(4, 0, 50), payload, 100));
+  ASSERT_TRUE(add(reassembler, pub, fragment(4, 50, 100), payload, 100));
+  EXPECT_EQ(message, bytes(payload));
+}
+
+TEST_F(test_fragment, evict_oldest) {
+  DPS_Publication * pub = create_publication();
+  ASSERT_TRUE(nullptr != pub);
+  Reassembler reassembler(std::chrono::milliseconds(1000), 2);
+  EXPECT_FALSE(add(reassembler, pub, fragment(1, 0, 50), payload));
+  EXPECT_FALSE(add(reassembler, pub, fragment(2, 0, 50), payload));
+  // Adding to a message makes it the most recent
+  EXPECT_FALSE(add(reassembler, pub, fragment(1, 50, 60), payload));
+  // A third message evicts the least recently added to
+  EXPECT_FALSE(add(reassembler, pub, fragment(3, 0, 50), payload));
+  ASSERT_TRUE(add(reassembler, pub, fragment(3, 50, 100), payload));
+  EXPECT_EQ(message, bytes(payload));
+  ASSERT_TRUE(add(reassembler, pub, fragment(1, 60, 100), payload));
+  EXPECT_EQ(message, bytes(payload));
+  EXPECT_FALSE(add(reassembler, pub, fragment(2, 50, 100), payload));
+}
+
+TEST_F(test_fragment, expired) {
+  DPS_Publication * pub = create_publication();
+  ASSERT_TRUE(nullptr != pub);
+  Reassembler reassembler(std::chrono::milliseconds(10));
+  EXPECT_FALSE(add(reassembler, pub, fragment(1, 0, 50), payload));
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_FALSE(add(reassembler, pub, fragment(1, 50, 100), payload));
+}
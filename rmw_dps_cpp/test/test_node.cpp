@@ -34,13 +34,13 @@ TEST_F(test_node, create) {
   rmw_ret_t ret;
   rmw_node_t * node;
 
-  node = rmw_create_node(&context, "test_node_create", "/", 0, &security_options);
+  node = rmw_create_node(&context, "test_node_create", "/", 0, &security_options, false);
   ASSERT_TRUE(nullptr != node);
   ret = rmw_destroy_node(node);
   ASSERT_EQ(RMW_RET_OK, ret);
 
   node = rmw_create_node(&context, "test_subscriber_MultiNested", "/test_time_23_42_58", 97,
-      &security_options);
+      &security_options, false);
   ASSERT_TRUE(nullptr != node);
   ret = rmw_destroy_node(node);
   ASSERT_EQ(RMW_RET_OK, ret);
@@ -53,14 +53,14 @@ TEST_F(test_node, discover_existing_node) {
   rmw_wait_set_t * wait_set = rmw_create_wait_set(&context, 1);
   rmw_time_t timeout = {1, 0};
 
-  existing_node = rmw_create_node(&context, "existing_node", "/", 0, &security_options);
+  existing_node = rmw_create_node(&context, "existing_node", "/", 0, &security_options, false);
   ASSERT_TRUE(nullptr != existing_node);
 
   // wait for initial advertisements to settle down
   ret = rmw_wait(nullptr, nullptr, nullptr, nullptr, nullptr, wait_set, &timeout);
   ASSERT_EQ(RMW_RET_TIMEOUT, ret);
 
-  node = rmw_create_node(&context, "discovering_node", "/", 0, &security_options);
+  node = rmw_create_node(&context, "discovering_node", "/", 0, &security_options, false);
   ASSERT_TRUE(nullptr != node);
 
   void * conditions[] = {rmw_node_get_graph_guard_condition(node)->data};
@@ -124,7 +124,7 @@ TEST_F(test_node, get_service_names_and_types) {
   rmw_wait_set_t * wait_set = rmw_create_wait_set(&context, 1);
   rmw_time_t timeout = {1, 0};
 
-  node = rmw_create_node(&context, "test_node", "/", 0, &security_options);
+  node = rmw_create_node(&context, "test_node", "/", 0, &security_options, false);
   ASSERT_TRUE(nullptr != node);
 
   type_support = ROSIDL_GET_SRV_TYPE_SUPPORT(test_msgs, srv, Empty);
@@ -165,7 +165,7 @@ TEST_F(test_node, service_server_is_available) {
   rmw_wait_set_t * wait_set = rmw_create_wait_set(&context, 1);
   rmw_time_t timeout = {1, 0};
 
-  node = rmw_create_node(&context, "test_node", "/", 0, &security_options);
+  node = rmw_create_node(&context, "test_node", "/", 0, &security_options, false);
   ASSERT_TRUE(nullptr != node);
 
   type_support = ROSIDL_GET_SRV_TYPE_SUPPORT(test_msgs, srv, Empty);
@@ -0,0 +1,78 @@
+// Copyright 2019 Intel Corporation All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <chrono>
+#include <cstdint>
+
+#include "gtest/gtest.h"
+
+#include "rmw_dps_cpp/Pacer.hpp"
+
+using rmw_dps_cpp::Pacer;
+using rmw_dps_cpp::PacingStatistics;
+
+typedef std::chrono::steady_clock Clock;
+
+// Only lower bounds on the time waited are checked, a loaded host may always wait longer
+
+TEST(test_pacer, within_burst) {
+  Pacer pacer(1000, 1000);
+  pacer.acquire(500);
+  pacer.acquire(500);
+  PacingStatistics statistics = pacer.statistics();
+  EXPECT_EQ(0u, statistics.queued_bytes);
+  EXPECT_EQ(1000u, statistics.sent_bytes);
+  EXPECT_EQ(0u, statistics.delayed_bytes);
+  EXPECT_EQ(0u, statistics.delay_ns);
+}
+
+TEST(test_pacer, rate) {
+  Pacer pacer(1000000, 1000);
+  pacer.acquire(1000);
+  Clock::time_point start = Clock::now();
+  // The bucket is empty, refilling it takes 1ms
+  pacer.acquire(1000);
+  EXPECT_GE(Clock::now() - start, std::chrono::microseconds(500));
+  PacingStatistics statistics = pacer.statistics();
+  EXPECT_EQ(2000u, statistics.sent_bytes);
+  EXPECT_EQ(1000u, statistics.delayed_bytes);
+  EXPECT_GE(statistics.delay_ns, 500000u);
+}
+
+TEST(test_pacer, debt) {
+  Pacer pacer(1000000, 1000);
+  pacer.acquire(1000);
+  // A send larger than the burst waits only for a full bucket...
+  pacer.acquire(10000);
+  PacingStatistics before = pacer.statistics();
+  EXPECT_EQ(11000u, before.sent_bytes);
+  EXPECT_EQ(10000u, before.delayed_bytes);
+
+  // ...and the next send waits for the 9000 bytes of debt, 9ms, however small it is
+  Clock::time_point start = Clock::now();
+  pacer.acquire(1);
+  EXPECT_GE(Clock::now() - start, std::chrono::milliseconds(8));
+  PacingStatistics after = pacer.statistics();
+  EXPECT_EQ(11001u, after.sent_bytes);
+  EXPECT_EQ(10001u, after.delayed_bytes);
+  EXPECT_GE(after.delay_ns - before.delay_ns, 8000000u);
+}
+
+TEST(test_pacer, zero_burst) {
+  // A burst of zero is one byte, so sends still make progress
+  Pacer pacer(1000000, 0);
+  pacer.acquire(10);
+  pacer.acquire(10);
+  EXPECT_EQ(20u, pacer.statistics().sent_bytes);
+}
@@ -17,12 +17,16 @@
 #include <test_msgs/msg/empty.h>
 
 #include <chrono>
+#include <thread>
 
 #include "gmock/gmock.h"
 
 #include "rmw/node_security_options.h"
 #include "rmw/rmw.h"
 
+#include "rmw_dps_cpp/pacing_statistics.hpp"
+#include "rmw_dps_cpp/publisher_options.hpp"
+
 #include "test_fixtures.hpp"
 
 class test_publisher : public test_fixture_node
@@ -37,17 +41,19 @@ TEST_F(test_publisher, count_matched_subscriptions) {
   size_t count;
   rmw_wait_set_t * wait_set = rmw_create_wait_set(&context, 1);
   rmw_time_t timeout = {1, 0};
+  rmw_publisher_options_t publisher_options = rmw_get_default_publisher_options();
+  rmw_subscription_options_t subscription_options = rmw_get_default_subscription_options();
 
   type_support = ROSIDL_GET_MSG_TYPE_SUPPORT(test_msgs, msg, Empty);
   ASSERT_TRUE(nullptr != type_support);
 
   publisher = rmw_create_publisher(node, type_support, "/count_matched_subscriptions",
-      &rmw_qos_profile_default);
+      &rmw_qos_profile_default, &publisher_options);
   ASSERT_TRUE(nullptr != publisher);
 
   // discover that a matching subscription has been created
   subscription = rmw_create_subscription(node, type_support, "/count_matched_subscriptions",
-      &rmw_qos_profile_default, false);
+      &rmw_qos_profile_default, &subscription_options);
   ASSERT_TRUE(nullptr != subscription);
   // wait for advertisements to settle down
   ret = rmw_wait(nullptr, nullptr, nullptr, nullptr, nullptr, wait_set, &timeout);
@@ -68,3 +74,96 @@ TEST_F(test_publisher, count_matched_subscriptions) {
   ret = rmw_destroy_publisher(node, publisher);
   ASSERT_EQ(RMW_RET_OK, ret);
 }
+
+TEST_F(test_publisher, unmatched_grace_period) {
+  rmw_ret_t ret;
+  rmw_publisher_t * publisher;
+  rmw_dps_cpp::PacingStatistics statistics;
+  rmw_dps_cpp::PublisherOptions dps_options = {};
+  dps_options.max_bandwidth = 1 << 30;  // Only to count the bytes sent
+  dps_options.unmatched_grace_period = 100;
+  rmw_publisher_options_t publisher_options = rmw_get_default_publisher_options();
+  publisher_options.rmw_specific_publisher_payload = &dps_options;
+  test_msgs__msg__Empty message;
+  test_msgs__msg__Empty__init(&message);
+
+  publisher = rmw_create_publisher(node, ROSIDL_GET_MSG_TYPE_SUPPORT(test_msgs, msg, Empty),
+      "/unmatched_grace_period", &rmw_qos_profile_default, &publisher_options);
+  ASSERT_TRUE(nullptr != publisher);
+
+  // every message is sent during the grace period
+  ret = rmw_publish(publisher, &message, nullptr);
+  ASSERT_EQ(RMW_RET_OK, ret);
+  ret = rmw_dps_cpp_publisher_get_pacing_statistics(publisher, &statistics);
+  ASSERT_EQ(RMW_RET_OK, ret);
+  uint64_t message_size = statistics.sent_bytes;
+  ASSERT_LT(0u, message_size);
+
+  // only one message per grace period is sent after it
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+  for (int i = 0; i < 10; ++i) {
+    ret = rmw_publish(publisher, &message, nullptr);
+    ASSERT_EQ(RMW_RET_OK, ret);
+  }
+  ret = rmw_dps_cpp_publisher_get_pacing_statistics(publisher, &statistics);
+  ASSERT_EQ(RMW_RET_OK, ret);
+  EXPECT_EQ(2 * message_size, statistics.sent_bytes);
+
+  test_msgs__msg__Empty__fini(&message);
+  ret = rmw_destroy_publisher(node, publisher);
+  ASSERT_EQ(RMW_RET_OK, ret);
+}
+
+TEST_F(test_publisher, unmatched_late_subscription) {
+  rmw_ret_t ret;
+  const rosidl_message_type_support_t * type_support;
+  rmw_publisher_t * publisher;
+  rmw_node_t * late_node;
+  rmw_subscription_t * subscription;
+  size_t count = 0;
+  bool taken = false;
+  rmw_dps_cpp::PublisherOptions dps_options = {};
+  dps_options.unmatched_grace_period = 50;
+  rmw_publisher_options_t publisher_options = rmw_get_default_publisher_options();
+  publisher_options.rmw_specific_publisher_payload = &dps_options;
+  rmw_subscription_options_t subscription_options = rmw_get_default_subscription_options();
+  test_msgs__msg__Empty message;
+  test_msgs__msg__Empty__init(&message);
+
+  type_support = ROSIDL_GET_MSG_TYPE_SUPPORT(test_msgs, msg, Empty);
+  ASSERT_TRUE(nullptr != type_support);
+
+  publisher = rmw_create_publisher(node, type_support, "/unmatched_late_subscription",
+      &rmw_qos_profile_default, &publisher_options);
+  ASSERT_TRUE(nullptr != publisher);
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+  // a subscription joining after the grace period receives messages before it is discovered
+  late_node = rmw_create_node(&context, "test_late_node", "/", 0, &security_options, false);
+  ASSERT_TRUE(nullptr != late_node);
+  subscription = rmw_create_subscription(late_node, type_support,
+      "/unmatched_late_subscription", &rmw_qos_profile_default, &subscription_options);
+  ASSERT_TRUE(nullptr != subscription);
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  while (!taken && std::chrono::steady_clock::now() < deadline) {
+    ret = rmw_publisher_count_matched_subscriptions(publisher, &count);
+    ASSERT_EQ(RMW_RET_OK, ret);
+    if (count) {
+      break;
+    }
+    ret = rmw_publish(publisher, &message, nullptr);
+    ASSERT_EQ(RMW_RET_OK, ret);
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    ret = rmw_take(subscription, &message, &taken, nullptr);
+    ASSERT_EQ(RMW_RET_OK, ret);
+  }
+  EXPECT_TRUE(taken);
+
+  test_msgs__msg__Empty__fini(&message);
+  ret = rmw_destroy_subscription(late_node, subscription);
+  ASSERT_EQ(RMW_RET_OK, ret);
+  ret = rmw_destroy_node(late_node);
+  ASSERT_EQ(RMW_RET_OK, ret);
+  ret = rmw_destroy_publisher(node, publisher);
+  ASSERT_EQ(RMW_RET_OK, ret);
+}
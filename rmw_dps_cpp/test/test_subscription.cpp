@@ -14,19 +14,70 @@
 
 #include <rcutils/allocator.h>
 #include <rosidl_generator_c/message_type_support_struct.h>
+#include <test_msgs/msg/basic_types.h>
 #include <test_msgs/msg/empty.h>
 
 #include <chrono>
+#include <thread>
+#include <vector>
 
 #include "gmock/gmock.h"
 
 #include "rmw/node_security_options.h"
 #include "rmw/rmw.h"
 
+#include "rmw_dps_cpp/publisher_options.hpp"
+#include "rmw_dps_cpp/subscription_options.hpp"
+#include "rmw_dps_cpp/take_sequence.hpp"
+
 #include "test_fixtures.hpp"
 
 class test_subscription : public test_fixture_node
 {
+protected:
+  /// Publish a BasicTypes message of each value.
+  void
+  publish(rmw_publisher_t * publisher, const std::vector<int32_t> & values)
+  {
+    test_msgs__msg__BasicTypes message;
+    test_msgs__msg__BasicTypes__init(&message);
+    for (int32_t value : values) {
+      message.int32_value = value;
+      ASSERT_EQ(RMW_RET_OK, rmw_publish(publisher, &message, nullptr));
+    }
+    test_msgs__msg__BasicTypes__fini(&message);
+  }
+
+  /// Wait up to timeout for the subscription to have a message to take.
+  bool
+  wait_for_message(rmw_subscription_t * subscription, rmw_time_t timeout = {1, 0})
+  {
+    rmw_wait_set_t * wait_set = rmw_create_wait_set(&context, 1);
+    void * data = subscription->data;
+    rmw_subscriptions_t subscriptions = {1, &data};
+    rmw_ret_t ret = rmw_wait(&subscriptions, nullptr, nullptr, nullptr, nullptr, wait_set,
+        &timeout);
+    EXPECT_EQ(RMW_RET_OK, rmw_destroy_wait_set(wait_set));
+    return ret == RMW_RET_OK && data;
+  }
+
+  /// Take the values of the BasicTypes messages received within a second, up to count.
+  std::vector<int32_t>
+  take_values(rmw_subscription_t * subscription, size_t count)
+  {
+    std::vector<int32_t> values;
+    test_msgs__msg__BasicTypes message;
+    test_msgs__msg__BasicTypes__init(&message);
+    while (values.size() < count && wait_for_message(subscription)) {
+      bool taken = false;
+      EXPECT_EQ(RMW_RET_OK, rmw_take(subscription, &message, &taken, nullptr));
+      if (taken) {
+        values.push_back(message.int32_value);
+      }
+    }
+    test_msgs__msg__BasicTypes__fini(&message);
+    return values;
+  }
 };
 
 TEST_F(test_subscription, count_matched_publishers) {
@@ -37,17 +88,19 @@ TEST_F(test_subscription, count_matched_publishers) {
   size_t count;
   rmw_wait_set_t * wait_set = rmw_create_wait_set(&context, 1);
   rmw_time_t timeout = {1, 0};
+  rmw_publisher_options_t publisher_options = rmw_get_default_publisher_options();
+  rmw_subscription_options_t subscription_options = rmw_get_default_subscription_options();
 
   type_support = ROSIDL_GET_MSG_TYPE_SUPPORT(test_msgs, msg, Empty);
   ASSERT_TRUE(nullptr != type_support);
 
   subscription = rmw_create_subscription(node, type_support, "/count_matched_subscriptions",
-      &rmw_qos_profile_default, false);
+      &rmw_qos_profile_default, &subscription_options);
   ASSERT_TRUE(nullptr != subscription);
 
   // discover that a matching publisher has been created
   publisher = rmw_create_publisher(node, type_support, "/count_matched_subscriptions",
-      &rmw_qos_profile_default);
+      &rmw_qos_profile_default, &publisher_options);
   ASSERT_TRUE(nullptr != publisher);
   // wait for advertisements to settle down
   ret = rmw_wait(nullptr, nullptr, nullptr, nullptr, nullptr, wait_set, &timeout);
@@ -68,3 +121,216 @@ TEST_F(test_subscription, count_matched_publishers) {
   ret = rmw_destroy_subscription(node, subscription);
   ASSERT_EQ(RMW_RET_OK, ret);
 }
+
+TEST_F(test_subscription, keyed_routing) {
+  rmw_ret_t ret;
+  const rosidl_message_type_support_t * type_support;
+  rmw_publisher_t * publisher;
+  rmw_subscription_t * keyed_subscription;
+  rmw_subscription_t * subscription;
+  rmw_dps_cpp::PublisherOptions dps_publisher_options = {};
+  dps_publisher_options.key_fields = "int32_value";
+  rmw_publisher_options_t publisher_options = rmw_get_default_publisher_options();
+  publisher_options.rmw_specific_publisher_payload = &dps_publisher_options;
+  rmw_dps_cpp::SubscriptionOptions dps_subscription_options = {};
+  dps_subscription_options.key = "int32_value=7";
+  rmw_subscription_options_t keyed_subscription_options = rmw_get_default_subscription_options();
+  keyed_subscription_options.rmw_specific_subscription_payload = &dps_subscription_options;
+  rmw_subscription_options_t subscription_options = rmw_get_default_subscription_options();
+
+  type_support = ROSIDL_GET_MSG_TYPE_SUPPORT(test_msgs, msg, BasicTypes);
+  ASSERT_TRUE(nullptr != type_support);
+
+  publisher = rmw_create_publisher(node, type_support, "/keyed_routing",
+      &rmw_qos_profile_default, &publisher_options);
+  ASSERT_TRUE(nullptr != publisher);
+  keyed_subscription = rmw_create_subscription(node, type_support, "/keyed_routing",
+      &rmw_qos_profile_default, &keyed_subscription_options);
+  ASSERT_TRUE(nullptr != keyed_subscription);
+  subscription = rmw_create_subscription(node, type_support, "/keyed_routing",
+      &rmw_qos_profile_default, &subscription_options);
+  ASSERT_TRUE(nullptr != subscription);
+
+  // the keyed subscription only receives the messages with its key values
+  publish(publisher, {8, 7, 9});
+  EXPECT_THAT(take_values(subscription, 3), ::testing::UnorderedElementsAre(7, 8, 9));
+  EXPECT_THAT(take_values(keyed_subscription, 1), ::testing::ElementsAre(7));
+  EXPECT_FALSE(wait_for_message(keyed_subscription, {0, 100000000}));
+
+  ret = rmw_destroy_subscription(node, subscription);
+  ASSERT_EQ(RMW_RET_OK, ret);
+  ret = rmw_destroy_subscription(node, keyed_subscription);
+  ASSERT_EQ(RMW_RET_OK, ret);
+  ret = rmw_destroy_publisher(node, publisher);
+  ASSERT_EQ(RMW_RET_OK, ret);
+}
+
+TEST_F(test_subscription, loaned_take) {
+  rmw_ret_t ret;
+  const rosidl_message_type_support_t * type_support;
+  rmw_publisher_t * publisher;
+  rmw_subscription_t * subscription;
+  void * loaned_message = nullptr;
+  void * next_loaned_message = nullptr;
+  bool taken = false;
+  rmw_qos_profile_t qos = rmw_qos_profile_default;
+  qos.depth = 1;  // A pool of one message
+  rmw_publisher_options_t publisher_options = rmw_get_default_publisher_options();
+  rmw_dps_cpp::SubscriptionOptions dps_subscription_options = {};
+  dps_subscription_options.loan_messages = true;
+  rmw_subscription_options_t subscription_options = rmw_get_default_subscription_options();
+  subscription_options.rmw_specific_subscription_payload = &dps_subscription_options;
+
+  type_support = ROSIDL_GET_MSG_TYPE_SUPPORT(test_msgs, msg, BasicTypes);
+  ASSERT_TRUE(nullptr != type_support);
+
+  publisher = rmw_create_publisher(node, type_support, "/loaned_take",
+      &rmw_qos_profile_default, &publisher_options);
+  ASSERT_TRUE(nullptr != publisher);
+  subscription = rmw_create_subscription(node, type_support, "/loaned_take", &qos,
+      &subscription_options);
+  ASSERT_TRUE(nullptr != subscription);
+  EXPECT_TRUE(subscription->can_loan_messages);
+
+  publish(publisher, {1});
+  ASSERT_TRUE(wait_for_message(subscription));
+  ret = rmw_take_loaned_message(subscription, &loaned_message, &taken, nullptr);
+  ASSERT_EQ(RMW_RET_OK, ret);
+  ASSERT_TRUE(taken);
+  EXPECT_EQ(1, static_cast<test_msgs__msg__BasicTypes *>(loaned_message)->int32_value);
+
+  // the only message of the pool is lent out
+  publish(publisher, {2});
+  ASSERT_TRUE(wait_for_message(subscription));
+  ret = rmw_take_loaned_message(subscription, &next_loaned_message, &taken, nullptr);
+  EXPECT_EQ(RMW_RET_ERROR, ret);
+  rmw_reset_error();
+
+  // giving it back lends it again, once only
+  ret = rmw_return_loaned_message_from_subscription(subscription, loaned_message);
+  ASSERT_EQ(RMW_RET_OK, ret);
+  ret = rmw_return_loaned_message_from_subscription(subscription, loaned_message);
+  EXPECT_EQ(RMW_RET_ERROR, ret);
+  rmw_reset_error();
+  ret = rmw_take_loaned_message(subscription, &next_loaned_message, &taken, nullptr);
+  ASSERT_EQ(RMW_RET_OK, ret);
+  ASSERT_TRUE(taken);
+  EXPECT_EQ(loaned_message, next_loaned_message);
+  EXPECT_EQ(2, static_cast<test_msgs__msg__BasicTypes *>(next_loaned_message)->int32_value);
+  ret = rmw_return_loaned_message_from_subscription(subscription, next_loaned_message);
+  ASSERT_EQ(RMW_RET_OK, ret);
+
+  ret = rmw_destroy_subscription(node, subscription);
+  ASSERT_EQ(RMW_RET_OK, ret);
+  ret = rmw_destroy_publisher(node, publisher);
+  ASSERT_EQ(RMW_RET_OK, ret);
+}
+
+TEST_F(test_subscription, take_sequence) {
+  rmw_ret_t ret;
+  const rosidl_message_type_support_t * type_support;
+  rmw_publisher_t * publisher;
+  rmw_subscription_t * subscription;
+  size_t taken = 0;
+  rmw_publisher_options_t publisher_options = rmw_get_default_publisher_options();
+  rmw_subscription_options_t subscription_options = rmw_get_default_subscription_options();
+  test_msgs__msg__BasicTypes messages[5];
+  void * ros_messages[5];
+  for (size_t i = 0; i < 5; ++i) {
+    test_msgs__msg__BasicTypes__init(&messages[i]);
+    ros_messages[i] = &messages[i];
+  }
+
+  type_support = ROSIDL_GET_MSG_TYPE_SUPPORT(test_msgs, msg, BasicTypes);
+  ASSERT_TRUE(nullptr != type_support);
+
+  publisher = rmw_create_publisher(node, type_support, "/take_sequence",
+      &rmw_qos_profile_default, &publisher_options);
+  ASSERT_TRUE(nullptr != publisher);
+  subscription = rmw_create_subscription(node, type_support, "/take_sequence",
+      &rmw_qos_profile_default, &subscription_options);
+  ASSERT_TRUE(nullptr != subscription);
+
+  // one call drains all the queued messages, in arrival order
+  publish(publisher, {1, 2, 3});
+  ASSERT_TRUE(wait_for_message(subscription));
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  ret = rmw_dps_cpp_take_sequence(subscription, 5, ros_messages, nullptr, &taken);
+  ASSERT_EQ(RMW_RET_OK, ret);
+  ASSERT_EQ(3u, taken);
+  EXPECT_EQ(1, messages[0].int32_value);
+  EXPECT_EQ(2, messages[1].int32_value);
+  EXPECT_EQ(3, messages[2].int32_value);
+  ret = rmw_dps_cpp_take_sequence(subscription, 5, ros_messages, nullptr, &taken);
+  ASSERT_EQ(RMW_RET_OK, ret);
+  EXPECT_EQ(0u, taken);
+
+  // no more than count are taken
+  publish(publisher, {4, 5, 6});
+  ASSERT_TRUE(wait_for_message(subscription));
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  ret = rmw_dps_cpp_take_sequence(subscription, 2, ros_messages, nullptr, &taken);
+  ASSERT_EQ(RMW_RET_OK, ret);
+  ASSERT_EQ(2u, taken);
+  EXPECT_EQ(4, messages[0].int32_value);
+  EXPECT_EQ(5, messages[1].int32_value);
+  EXPECT_THAT(take_values(subscription, 1), ::testing::ElementsAre(6));
+
+  for (size_t i = 0; i < 5; ++i) {
+    test_msgs__msg__BasicTypes__fini(&messages[i]);
+  }
+  ret = rmw_destroy_subscription(node, subscription);
+  ASSERT_EQ(RMW_RET_OK, ret);
+  ret = rmw_destroy_publisher(node, publisher);
+  ASSERT_EQ(RMW_RET_OK, ret);
+}
+
+TEST_F(test_subscription, transfer_serialized_messages) {
+  rmw_ret_t ret;
+  const rosidl_message_type_support_t * type_support;
+  rmw_publisher_t * publisher;
+  rmw_subscription_t * subscription;
+  bool taken = false;
+  rcutils_allocator_t allocator = rcutils_get_default_allocator();
+  rmw_serialized_message_t serialized_message = rmw_get_zero_initialized_serialized_message();
+  rmw_publisher_options_t publisher_options = rmw_get_default_publisher_options();
+  rmw_dps_cpp::SubscriptionOptions dps_subscription_options = {};
+  dps_subscription_options.transfer_serialized_messages = true;
+  rmw_subscription_options_t subscription_options = rmw_get_default_subscription_options();
+  subscription_options.rmw_specific_subscription_payload = &dps_subscription_options;
+
+  type_support = ROSIDL_GET_MSG_TYPE_SUPPORT(test_msgs, msg, BasicTypes);
+  ASSERT_TRUE(nullptr != type_support);
+
+  publisher = rmw_create_publisher(node, type_support, "/transfer_serialized_messages",
+      &rmw_qos_profile_default, &publisher_options);
+  ASSERT_TRUE(nullptr != publisher);
+  subscription = rmw_create_subscription(node, type_support, "/transfer_serialized_messages",
+      &rmw_qos_profile_default, &subscription_options);
+  ASSERT_TRUE(nullptr != subscription);
+
+  // the received buffer replaces that of the serialized message
+  ret = rmw_serialized_message_init(&serialized_message, 4096, &allocator);
+  ASSERT_EQ(RMW_RET_OK, ret);
+  const uint8_t * buffer = serialized_message.buffer;
+  publish(publisher, {7});
+  ASSERT_TRUE(wait_for_message(subscription));
+  ret = rmw_take_serialized_message(subscription, &serialized_message, &taken, nullptr);
+  ASSERT_EQ(RMW_RET_OK, ret);
+  ASSERT_TRUE(taken);
+  EXPECT_NE(buffer, serialized_message.buffer);
+  EXPECT_LT(0u, serialized_message.buffer_length);
+  EXPECT_EQ(serialized_message.buffer_length, serialized_message.buffer_capacity);
+
+  // and is what was published
+  ret = rmw_publish_serialized_message(publisher, &serialized_message, nullptr);
+  ASSERT_EQ(RMW_RET_OK, ret);
+  EXPECT_THAT(take_values(subscription, 1), ::testing::ElementsAre(7));
+
+  ret = rmw_serialized_message_fini(&serialized_message);
+  ASSERT_EQ(RMW_RET_OK, ret);
+  ret = rmw_destroy_subscription(node, subscription);
+  ASSERT_EQ(RMW_RET_OK, ret);
+  ret = rmw_destroy_publisher(node, publisher);
+  ASSERT_EQ(RMW_RET_OK, ret);
+}
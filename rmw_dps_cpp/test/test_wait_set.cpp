@@ -0,0 +1,314 @@
+// Copyright 2019 Intel Corporation All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+#include <chrono>
+#include <thread>
+
+#include <rcutils/allocator.h>
+#include <rosidl_generator_c/message_type_support_struct.h>
+#include <test_msgs/msg/empty.h>
+
+#include "gmock/gmock.h"
+
+#include "rmw/node_security_options.h"
+#include "rmw/rmw.h"
+
+#include "rmw_dps_cpp/wait_fds.hpp"
+#include "rmw_dps_cpp/wait_policy.hpp"
+
+#include "test_fixtures.hpp"
+
+class test_wait_set : public test_fixture_node
+{
+protected:
+  void
+  SetUp() override
+  {
+    test_fixture_node::SetUp();
+    wait_set = rmw_create_wait_set(&context, 0);
+    ASSERT_TRUE(nullptr != wait_set);
+  }
+
+  void
+  TearDown() override
+  {
+    rmw_ret_t ret = rmw_destroy_wait_set(wait_set);
+    ASSERT_EQ(RMW_RET_OK, ret);
+    test_fixture_node::TearDown();
+  }
+
+  rmw_wait_set_t * wait_set;
+};
+
+TEST_F(test_wait_set, immediate) {
+  rmw_ret_t ret;
+  rmw_dps_cpp::WaitStatistics statistics;
+  rmw_time_t zero = {0, 0};
+  rmw_guard_condition_t * guard_condition = rmw_create_guard_condition(&context);
+  ASSERT_TRUE(nullptr != guard_condition);
+  void * data = guard_condition->data;
+  rmw_guard_conditions_t guard_conditions = {1, &data};
+
+  // a zero timeout returns at once
+  ret = rmw_wait(nullptr, &guard_conditions, nullptr, nullptr, nullptr, wait_set, &zero);
+  EXPECT_EQ(RMW_RET_TIMEOUT, ret);
+  EXPECT_EQ(nullptr, data);
+
+  // as does an entity already being ready
+  ret = rmw_trigger_guard_condition(guard_condition);
+  ASSERT_EQ(RMW_RET_OK, ret);
+  data = guard_condition->data;
+  ret = rmw_wait(nullptr, &guard_conditions, nullptr, nullptr, nullptr, wait_set, nullptr);
+  EXPECT_EQ(RMW_RET_OK, ret);
+  EXPECT_EQ(guard_condition->data, data);
+
+  ret = rmw_dps_cpp_wait_set_get_statistics(wait_set, &statistics);
+  ASSERT_EQ(RMW_RET_OK, ret);
+  EXPECT_EQ(2u, statistics.immediate_count);
+  EXPECT_EQ(0u, statistics.spin_count);
+  EXPECT_EQ(0u, statistics.block_count);
+
+  ret = rmw_destroy_guard_condition(guard_condition);
+  ASSERT_EQ(RMW_RET_OK, ret);
+}
+
+TEST_F(test_wait_set, spin_period) {
+  rmw_ret_t ret;
+  rmw_dps_cpp::WaitStatistics statistics;
+  rmw_time_t timeout = {10, 0};
+  rmw_guard_condition_t * guard_condition = rmw_create_guard_condition(&context);
+  ASSERT_TRUE(nullptr != guard_condition);
+  void * data = guard_condition->data;
+  rmw_guard_conditions_t guard_conditions = {1, &data};
+
+  // a trigger while spinning is seen by the spin, without blocking
+  ret = rmw_dps_cpp_wait_set_set_spin_period(wait_set, {5, 0});
+  ASSERT_EQ(RMW_RET_OK, ret);
+  std::thread trigger([guard_condition]() {
+      std::this_thread::sleep_for(std::chrono::milliseconds(50));
+      EXPECT_EQ(RMW_RET_OK, rmw_trigger_guard_condition(guard_condition));
+    });
+  ret = rmw_wait(nullptr, &guard_conditions, nullptr, nullptr, nullptr, wait_set, &timeout);
+  trigger.join();
+  EXPECT_EQ(RMW_RET_OK, ret);
+  EXPECT_EQ(guard_condition->data, data);
+  ret = rmw_dps_cpp_wait_set_get_statistics(wait_set, &statistics);
+  ASSERT_EQ(RMW_RET_OK, ret);
+  EXPECT_EQ(1u, statistics.spin_count);
+  EXPECT_EQ(0u, statistics.block_count);
+
+  // a timeout within the spin period times out while spinning
+  timeout = {0, 50000000};
+  data = guard_condition->data;
+  ret = rmw_wait(nullptr, &guard_conditions, nullptr, nullptr, nullptr, wait_set, &timeout);
+  EXPECT_EQ(RMW_RET_TIMEOUT, ret);
+  ret = rmw_dps_cpp_wait_set_get_statistics(wait_set, &statistics);
+  ASSERT_EQ(RMW_RET_OK, ret);
+  EXPECT_EQ(2u, statistics.spin_count);
+  EXPECT_EQ(0u, statistics.block_count);
+
+  // nothing ready by the end of the spin period blocks for the rest of the timeout
+  ret = rmw_dps_cpp_wait_set_set_spin_period(wait_set, {0, 10000000});
+  ASSERT_EQ(RMW_RET_OK, ret);
+  timeout = {0, 100000000};
+  data = guard_condition->data;
+  auto start = std::chrono::steady_clock::now();
+  ret = rmw_wait(nullptr, &guard_conditions, nullptr, nullptr, nullptr, wait_set, &timeout);
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  EXPECT_EQ(RMW_RET_TIMEOUT, ret);
+  EXPECT_GE(elapsed, std::chrono::milliseconds(100));
+  ret = rmw_dps_cpp_wait_set_get_statistics(wait_set, &statistics);
+  ASSERT_EQ(RMW_RET_OK, ret);
+  EXPECT_EQ(2u, statistics.spin_count);
+  EXPECT_EQ(1u, statistics.block_count);
+  EXPECT_EQ(0u, statistics.immediate_count);
+
+  ret = rmw_destroy_guard_condition(guard_condition);
+  ASSERT_EQ(RMW_RET_OK, ret);
+}
+
+TEST_F(test_wait_set, multiple_wait_sets) {
+  rmw_ret_t ret;
+  const rosidl_message_type_support_t * type_support;
+  rmw_publisher_t * publisher;
+  rmw_subscription_t * subscription;
+  rmw_wait_set_t * other_wait_set;
+  rmw_publisher_options_t publisher_options = rmw_get_default_publisher_options();
+  rmw_subscription_options_t subscription_options = rmw_get_default_subscription_options();
+  test_msgs__msg__Empty message;
+  test_msgs__msg__Empty__init(&message);
+
+  type_support = ROSIDL_GET_MSG_TYPE_SUPPORT(test_msgs, msg, Empty);
+  ASSERT_TRUE(nullptr != type_support);
+
+  publisher = rmw_create_publisher(node, type_support, "/multiple_wait_sets",
+      &rmw_qos_profile_default, &publisher_options);
+  ASSERT_TRUE(nullptr != publisher);
+  subscription = rmw_create_subscription(node, type_support, "/multiple_wait_sets",
+      &rmw_qos_profile_default, &subscription_options);
+  ASSERT_TRUE(nullptr != subscription);
+  other_wait_set = rmw_create_wait_set(&context, 0);
+  ASSERT_TRUE(nullptr != other_wait_set);
+
+  // a message wakes every wait set waiting on the subscription
+  auto wait = [subscription](rmw_wait_set_t * wait_set) {
+      void * data = subscription->data;
+      rmw_subscriptions_t subscriptions = {1, &data};
+      rmw_time_t timeout = {10, 0};
+      EXPECT_EQ(RMW_RET_OK,
+        rmw_wait(&subscriptions, nullptr, nullptr, nullptr, nullptr, wait_set, &timeout));
+      EXPECT_EQ(subscription->data, data);
+    };
+  std::thread waiter(wait, wait_set);
+  std::thread other_waiter(wait, other_wait_set);
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  ret = rmw_publish(publisher, &message, nullptr);
+  EXPECT_EQ(RMW_RET_OK, ret);
+  waiter.join();
+  other_waiter.join();
+
+  test_msgs__msg__Empty__fini(&message);
+  ret = rmw_destroy_wait_set(other_wait_set);
+  ASSERT_EQ(RMW_RET_OK, ret);
+  ret = rmw_destroy_subscription(node, subscription);
+  ASSERT_EQ(RMW_RET_OK, ret);
+  ret = rmw_destroy_publisher(node, publisher);
+  ASSERT_EQ(RMW_RET_OK, ret);
+}
+
+#ifdef __linux__
+/// Return true if fd becomes readable within timeout_ms.
+static bool
+readable(int fd, int timeout_ms = 0)
+{
+  pollfd pfd = {fd, POLLIN, 0};
+  return poll(&pfd, 1, timeout_ms) == 1 && (pfd.revents & POLLIN);
+}
+
+TEST_F(test_wait_set, guard_condition_fd) {
+  rmw_ret_t ret;
+  int fd = -1;
+  rmw_time_t timeout = {1, 0};
+  rmw_guard_condition_t * guard_condition = rmw_create_guard_condition(&context);
+  ASSERT_TRUE(nullptr != guard_condition);
+  ret = rmw_dps_cpp_guard_condition_get_fd(guard_condition, &fd);
+  ASSERT_EQ(RMW_RET_OK, ret);
+  EXPECT_FALSE(readable(fd));
+
+  // the fd is readable from the trigger until rmw_wait() reports it
+  ret = rmw_trigger_guard_condition(guard_condition);
+  ASSERT_EQ(RMW_RET_OK, ret);
+  EXPECT_TRUE(readable(fd));
+  void * data = guard_condition->data;
+  rmw_guard_conditions_t guard_conditions = {1, &data};
+  ret = rmw_wait(nullptr, &guard_conditions, nullptr, nullptr, nullptr, wait_set, &timeout);
+  ASSERT_EQ(RMW_RET_OK, ret);
+  EXPECT_EQ(guard_condition->data, data);
+  EXPECT_FALSE(readable(fd));
+
+  ret = rmw_destroy_guard_condition(guard_condition);
+  ASSERT_EQ(RMW_RET_OK, ret);
+}
+
+TEST_F(test_wait_set, subscription_fd) {
+  rmw_ret_t ret;
+  const rosidl_message_type_support_t * type_support;
+  rmw_publisher_t * publisher;
+  rmw_subscription_t * subscription;
+  int fd = -1;
+  bool taken = false;
+  rmw_time_t timeout = {1, 0};
+  rmw_publisher_options_t publisher_options = rmw_get_default_publisher_options();
+  rmw_subscription_options_t subscription_options = rmw_get_default_subscription_options();
+  test_msgs__msg__Empty message;
+  test_msgs__msg__Empty__init(&message);
+
+  type_support = ROSIDL_GET_MSG_TYPE_SUPPORT(test_msgs, msg, Empty);
+  ASSERT_TRUE(nullptr != type_support);
+
+  publisher = rmw_create_publisher(node, type_support, "/subscription_fd",
+      &rmw_qos_profile_default, &publisher_options);
+  ASSERT_TRUE(nullptr != publisher);
+  subscription = rmw_create_subscription(node, type_support, "/subscription_fd",
+      &rmw_qos_profile_default, &subscription_options);
+  ASSERT_TRUE(nullptr != subscription);
+  ret = rmw_dps_cpp_subscription_get_fd(subscription, &fd);
+  ASSERT_EQ(RMW_RET_OK, ret);
+  EXPECT_FALSE(readable(fd));
+
+  // the fd is readable while the subscription has a message to take
+  ret = rmw_publish(publisher, &message, nullptr);
+  ASSERT_EQ(RMW_RET_OK, ret);
+  ASSERT_TRUE(readable(fd, 1000));
+  void * data = subscription->data;
+  rmw_subscriptions_t subscriptions = {1, &data};
+  ret = rmw_wait(&subscriptions, nullptr, nullptr, nullptr, nullptr, wait_set, &timeout);
+  ASSERT_EQ(RMW_RET_OK, ret);
+  EXPECT_EQ(subscription->data, data);
+  EXPECT_TRUE(readable(fd));
+  ret = rmw_take(subscription, &message, &taken, nullptr);
+  ASSERT_EQ(RMW_RET_OK, ret);
+  ASSERT_TRUE(taken);
+  EXPECT_FALSE(readable(fd));
+
+  test_msgs__msg__Empty__fini(&message);
+  ret = rmw_destroy_subscription(node, subscription);
+  ASSERT_EQ(RMW_RET_OK, ret);
+  ret = rmw_destroy_publisher(node, publisher);
+  ASSERT_EQ(RMW_RET_OK, ret);
+}
+
+TEST_F(test_wait_set, without_fd) {
+  rmw_ret_t ret;
+  int fd = -1;
+  rmw_time_t timeout = {10, 0};
+  rlimit limit;
+
+  // create a guard condition while out of file descriptors
+  ASSERT_EQ(0, getrlimit(RLIMIT_NOFILE, &limit));
+  int lowest = dup(0);
+  ASSERT_LE(0, lowest);
+  close(lowest);
+  rlimit lowered = limit;
+  lowered.rlim_cur = static_cast<rlim_t>(lowest);
+  ASSERT_EQ(0, setrlimit(RLIMIT_NOFILE, &lowered));
+  rmw_guard_condition_t * guard_condition = rmw_create_guard_condition(&context);
+  ASSERT_EQ(0, setrlimit(RLIMIT_NOFILE, &limit));
+  ASSERT_TRUE(nullptr != guard_condition);
+  ret = rmw_dps_cpp_guard_condition_get_fd(guard_condition, &fd);
+  EXPECT_EQ(RMW_RET_UNSUPPORTED, ret);
+  rmw_reset_error();
+
+  // rmw_wait() falls back to waiting on a condition variable
+  std::thread trigger([guard_condition]() {
+      std::this_thread::sleep_for(std::chrono::milliseconds(50));
+      EXPECT_EQ(RMW_RET_OK, rmw_trigger_guard_condition(guard_condition));
+    });
+  void * data = guard_condition->data;
+  rmw_guard_conditions_t guard_conditions = {1, &data};
+  ret = rmw_wait(nullptr, &guard_conditions, nullptr, nullptr, nullptr, wait_set, &timeout);
+  trigger.join();
+  EXPECT_EQ(RMW_RET_OK, ret);
+  EXPECT_EQ(guard_condition->data, data);
+
+  ret = rmw_destroy_guard_condition(guard_condition);
+  ASSERT_EQ(RMW_RET_OK, ret);
+}
+#endif